@@ -0,0 +1,145 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+# define ADT_HAMMING_AVX2 1
+# include <immintrin.h>
+#endif
+
+namespace adt {
+
+/**
+ * @brief  Block of 2-bit packed nucleotide strings of the same length for computing Hamming distances
+ *         between many pairs at once. Strings are loaded once into word planes (i-th word of every string
+ *         is stored contiguously), distances are computed via popcount of the xor-ed words, four strings at
+ *         a time with AVX2 if the CPU supports it.
+ */
+class HammingBlock {
+public:
+    explicit HammingBlock(size_t nucls)
+            : nucls_(nucls), words_((nucls + NUCLS_PER_WORD - 1) / NUCLS_PER_WORD), size_(0),
+              planes_(words_) {
+        VERIFY(nucls_ > 0);
+        size_t rest = nucls_ - (words_ - 1) * NUCLS_PER_WORD;
+        last_mask_ = rest == NUCLS_PER_WORD ? -1ull : (1ull << (2 * rest)) - 1;
+    }
+
+    size_t size() const { return size_; }
+    size_t nucls() const { return nucls_; }
+
+    void clear() {
+        for (auto &plane : planes_)
+            plane.clear();
+        size_ = 0;
+    }
+
+    void reserve(size_t n) {
+        for (auto &plane : planes_)
+            plane.reserve(n);
+    }
+
+    /// Words are in the layout of Seq: i-th nucleotide is stored in bits [2 * (i % 32), 2 * (i % 32) + 2) of word i / 32
+    void push_back_words(const uint64_t *data) {
+        for (size_t w = 0; w + 1 < words_; ++w)
+            planes_[w].push_back(data[w]);
+        planes_[words_ - 1].push_back(data[words_ - 1] & last_mask_);
+        size_ += 1;
+    }
+
+    template<class Seq>
+    void push_back(const Seq &s) {
+        static_assert(sizeof(typename Seq::DataType) == sizeof(uint64_t), "Only 64-bit words are supported");
+        VERIFY(Seq::DataSize == words_);
+        push_back_words(reinterpret_cast<const uint64_t*>(s.data()));
+    }
+
+    unsigned distance(size_t i, size_t j) const {
+        unsigned dist = 0;
+        for (size_t w = 0; w < words_; ++w)
+            dist += mismatches(planes_[w][i] ^ planes_[w][j]);
+        return dist;
+    }
+
+    /// Writes distances between i-th string and strings [from, to) into out[0, to - from)
+    void distances(size_t i, size_t from, size_t to, unsigned *out) const {
+        VERIFY(from <= to && to <= size_);
+#ifdef ADT_HAMMING_AVX2
+        if (avx2_supported()) {
+            distances_avx2(i, from, to, out);
+            return;
+        }
+#endif
+        distances_scalar(i, from, to, out);
+    }
+
+    void distances_scalar(size_t i, size_t from, size_t to, unsigned *out) const {
+        for (size_t j = from; j < to; ++j)
+            out[j - from] = distance(i, j);
+    }
+
+#ifdef ADT_HAMMING_AVX2
+    static bool avx2_supported() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    __attribute__((target("avx2")))
+    void distances_avx2(size_t i, size_t from, size_t to, unsigned *out) const {
+        const __m256i low_bits = _mm256_set1_epi64x(0x5555555555555555ull);
+        const __m256i nibble_mask = _mm256_set1_epi8(0x0F);
+        const __m256i nibble_popcount = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const __m256i zero = _mm256_setzero_si256();
+
+        size_t j = from;
+        for (; j + 4 <= to; j += 4) {
+            __m256i sum = zero;
+            for (size_t w = 0; w < words_; ++w) {
+                __m256i x = _mm256_set1_epi64x((long long)planes_[w][i]);
+                __m256i y = _mm256_loadu_si256((const __m256i*)(planes_[w].data() + j));
+                __m256i diff = _mm256_xor_si256(x, y);
+                // One bit per mismatching nucleotide
+                diff = _mm256_and_si256(_mm256_or_si256(diff, _mm256_srli_epi64(diff, 1)), low_bits);
+                __m256i cnt = _mm256_add_epi8(_mm256_shuffle_epi8(nibble_popcount, _mm256_and_si256(diff, nibble_mask)),
+                                              _mm256_shuffle_epi8(nibble_popcount,
+                                                                  _mm256_and_si256(_mm256_srli_epi64(diff, 4), nibble_mask)));
+                sum = _mm256_add_epi64(sum, _mm256_sad_epu8(cnt, zero));
+            }
+
+            uint64_t res[4];
+            _mm256_storeu_si256((__m256i*)res, sum);
+            for (size_t k = 0; k < 4; ++k)
+                out[j - from + k] = unsigned(res[k]);
+        }
+
+        for (; j < to; ++j)
+            out[j - from] = distance(i, j);
+    }
+#endif
+
+private:
+    static constexpr size_t NUCLS_PER_WORD = 32;
+
+    static unsigned mismatches(uint64_t diff) {
+        return unsigned(__builtin_popcountll((diff | (diff >> 1)) & 0x5555555555555555ull));
+    }
+
+    size_t nucls_;
+    size_t words_;
+    size_t size_;
+    uint64_t last_mask_;
+    std::vector<std::vector<uint64_t>> planes_;
+};
+
+}
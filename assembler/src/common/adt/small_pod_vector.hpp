@@ -401,7 +401,7 @@ public:
         return *this;
     }
 
-    SmallPODVector(self &&that)
+    SmallPODVector(self &&that) noexcept
             : data_(std::move(that.data_)) {
         that.data_.reset();
     }
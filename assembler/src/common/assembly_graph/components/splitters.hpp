@@ -11,6 +11,8 @@
 #include "assembly_graph/dijkstra/dijkstra_helper.hpp"
 #include "component_filters.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace omnigraph {
 
 
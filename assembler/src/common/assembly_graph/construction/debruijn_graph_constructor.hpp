@@ -189,6 +189,8 @@ private:
 
     Index &origin_;
     size_t kmer_size_;
+    // Arena to allocate sequences from, heap is used if null
+    NuclArena *arena_;
 
     bool IsJunction(KeyWithHash kwh) const {
         return IsJunction(origin_.get_value(kwh));
@@ -233,7 +235,7 @@ private:
         return false;
     }
 
-    Sequence ConstructSequenceWithEdge(DeEdge edge, SequenceBuilder &builder) const {
+    void CollectNucls(DeEdge edge, SequenceBuilder &builder) const {
         builder.clear(); // We reuse the buffer to reduce malloc traffic
         builder.append(edge.start.key());
         builder.append(edge.end[kmer_size_ - 1]);
@@ -241,7 +243,26 @@ private:
         while (StepRightIfPossible(edge) && edge != initial) {
             builder.append(edge.end[kmer_size_ - 1]);
         }
-        return builder.BuildSequence();
+    }
+
+    Sequence BuildSequence(SequenceBuilder &builder) const {
+        return arena_ ? builder.BuildSequence(*arena_) : builder.BuildSequence();
+    }
+
+    Sequence ConstructSequenceWithEdge(DeEdge edge, SequenceBuilder &builder) const {
+        CollectNucls(edge, builder);
+        return BuildSequence(builder);
+    }
+
+    // Checks s < !s for the sequence s collected in the builder without building it
+    static bool LessThanConjugate(const SequenceBuilder &builder) {
+        size_t n = builder.size();
+        for (size_t i = 0; i < n; ++i) {
+            char c = builder[i], rc = complement(builder[n - 1 - i]);
+            if (c != rc)
+                return c < rc;
+        }
+        return false;
     }
 
     // Loop consists of 4 parts: 2 selfRC k+1-mers and two sequences of arbitrary length RC to each other; pos is a position of one of selfRC edges
@@ -275,10 +296,11 @@ private:
             AddStartDeEdges(kh, start_edges);
 
             for (auto edge : start_edges) {
-                Sequence s = ConstructSequenceWithEdge(edge, builder);
-                if (s < !s)
+                CollectNucls(edge, builder);
+                if (LessThanConjugate(builder))
                     continue;
 
+                Sequence s = BuildSequence(builder);
                 sequences.push_back(s);
                 TRACE("From " << edge << " calculated sequence\n" << s);
             }
@@ -344,8 +366,8 @@ private:
     }
 
 public:
-    UnbranchingPathExtractor(Index &origin, size_t k)
-            : origin_(origin), kmer_size_(k) {}
+    UnbranchingPathExtractor(Index &origin, size_t k, NuclArena *arena = nullptr)
+            : origin_(origin), kmer_size_(k), arena_(arena) {}
 
     //TODO very large vector is returned. But I hate to make all those artificial changes that can fix it.
     const std::vector<Sequence> ExtractUnbranchingPaths(unsigned nchunks) const {
@@ -540,10 +562,12 @@ public:
     void ConstructGraph(bool keep_perfect_loops) {
         std::vector<Sequence> edge_sequences;
         unsigned nchunks = 16 * omp_get_max_threads();
+        // Edge sequences are packed directly into the graph storage
+        UnbranchingPathExtractor extractor(origin_, kmer_size_, &graph_.master().arena());
         if (keep_perfect_loops)
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPathsAndLoops(nchunks);
+            edge_sequences = extractor.ExtractUnbranchingPathsAndLoops(nchunks);
         else
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPaths(nchunks);
+            edge_sequences = extractor.ExtractUnbranchingPaths(nchunks);
         FastGraphFromSequencesConstructor<Graph>(kmer_size_, origin_).ConstructGraph(graph_, edge_sequences);
     }
 
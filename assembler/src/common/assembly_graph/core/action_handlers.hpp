@@ -34,6 +34,7 @@ class ActionHandler  {
     const std::string handler_name_;
 private:
     bool attached_;
+    bool batched_;
 public:
     ActionHandler(const ActionHandler&) = delete;
     ActionHandler& operator=(const ActionHandler&) = delete;
@@ -44,7 +45,7 @@ public:
      * Create action handler with given name. With this name one can find out what tipe of handler is it.
      */
     ActionHandler(const std::string &name)
-            : handler_name_(name), attached_(true) {
+            : handler_name_(name), attached_(true), batched_(false) {
     }
 
     virtual ~ActionHandler() {
@@ -126,6 +127,27 @@ public:
         return false;
     }
 
+    /**
+     * Handlers which don't need to be in sync with every graph modification (e.g. the ones keeping
+     * external info about edges) should override this method. In batched mode of the graph such handlers
+     * receive events in bulk at the sync points. Handling should use only the state of the handler itself
+     * and the data of the elements mentioned in the events, which are kept by the graph until the sync point.
+     */
+    virtual bool IsBatchable() const {
+        return false;
+    }
+
+    /**
+     * Returns true iff the events are currently delivered to the handler at the sync points of the graph
+     */
+    bool IsBatched() const {
+        return batched_;
+    }
+
+    void SetBatched(bool batched) {
+        batched_ = batched;
+    }
+
     bool IsAttached() const {
         return attached_;
     }
@@ -0,0 +1,208 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <cstring>
+
+namespace omnigraph {
+
+namespace impl {
+
+/**
+ * CSR-like storage of sorted adjacency lists indexed by (vertex) id. Lists of all vertices live in a single
+ * pool split into fixed-size blocks. Every list occupies a power-of-two sized segment of the pool, and is moved
+ * to the segment of the next (previous) size class when it outgrows (shrinks below) its capacity. Per vertex
+ * only a packed (segment offset, list size) slot is stored.
+ *
+ * Released segments are reused via per-class free lists.
+ *
+ * Thread safety: insert() and erase() relocate the list to a segment taken from the shared pool; the pool
+ * itself is synchronized (atomic bump of the top, free lists and block allocation under the lock), so lists
+ * of different ids can be modified concurrently. Concurrent modification of the same list, or reading a list
+ * while it is modified, is a data race and must be serialized by the caller (e.g. by per-vertex locks).
+ * resize() must not be called concurrently with any other method.
+ */
+template<class T>
+class CompactAdjacency {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Value type for CompactAdjacency should be trivially copyable");
+
+    static constexpr unsigned BLOCK_BITS = 16;
+    static constexpr uint64_t BLOCK_SIZE = 1ull << BLOCK_BITS;
+    static constexpr uint64_t MAX_BLOCKS = 1ull << 16;
+
+  public:
+    typedef const T *const_iterator;
+
+    CompactAdjacency()
+            : top_(1) /* Offset 0 means "no segment" */ {
+        for (auto &cnt : free_count_)
+            cnt = 0;
+    }
+
+    ~CompactAdjacency() {
+        if (!blocks_)
+            return;
+
+        for (uint64_t i = 0; i < MAX_BLOCKS; ++i)
+            delete[] blocks_[i].load();
+    }
+
+    /**
+     * @brief Ensures slots for ids [0, n) exist. Must not be called concurrently with any other method.
+     */
+    void resize(size_t n) {
+        if (!blocks_) {
+            blocks_.reset(new std::atomic<T*>[MAX_BLOCKS]);
+            for (uint64_t i = 0; i < MAX_BLOCKS; ++i)
+                blocks_[i] = nullptr;
+        }
+
+        if (slots_.size() < n)
+            slots_.resize(n, 0);
+    }
+
+    size_t size() const { return slots_.size(); }
+
+    size_t size(uint64_t id) const noexcept {
+        return list_size(slots_[id]);
+    }
+
+    const_iterator begin(uint64_t id) const noexcept {
+        uint64_t slot = slots_[id];
+        return list_size(slot) ? at(offset(slot)) : nullptr;
+    }
+
+    const_iterator end(uint64_t id) const noexcept {
+        uint64_t slot = slots_[id];
+        return list_size(slot) ? at(offset(slot)) + list_size(slot) : nullptr;
+    }
+
+    /**
+     * @brief Inserts the value keeping the list sorted. Not thread-safe for the same id, see class comment.
+     */
+    void insert(uint64_t id, T value) {
+        uint64_t slot = slots_[id], off = offset(slot);
+        size_t sz = list_size(slot);
+        // The segment is full, when the size is zero or a power of two
+        if ((sz & (sz - 1)) == 0)
+            off = Relocate(off, sz, sz + 1);
+
+        T *data = at(off);
+        T *pos = std::upper_bound(data, data + sz, value);
+        memmove(pos + 1, pos, (data + sz - pos) * sizeof(T));
+        *pos = value;
+
+        slots_[id] = pack(off, sz + 1);
+    }
+
+    /**
+     * @brief Removes the value from the list. Returns false if there is no such value.
+     *        Not thread-safe for the same id, see class comment.
+     */
+    bool erase(uint64_t id, T value) {
+        uint64_t slot = slots_[id], off = offset(slot);
+        size_t sz = list_size(slot);
+        if (!sz)
+            return false;
+
+        T *data = at(off);
+        T *pos = std::find(data, data + sz, value);
+        if (pos == data + sz)
+            return false;
+
+        memmove(pos, pos + 1, (data + sz - pos - 1) * sizeof(T));
+        sz -= 1;
+        // Move to the smaller segment, if the list fits there
+        if ((sz & (sz - 1)) == 0)
+            off = Relocate(off, sz + 1, sz);
+
+        slots_[id] = pack(off, sz);
+        return true;
+    }
+
+  private:
+    static size_t list_size(uint64_t slot) noexcept { return slot & 0xFFFFFFFF; }
+    static uint64_t offset(uint64_t slot) noexcept { return slot >> 32; }
+    static uint64_t pack(uint64_t off, size_t sz) noexcept { return (sz ? (off << 32) | sz : 0); }
+
+    // Size class of the segment holding sz > 0 elements
+    static unsigned size_class(size_t sz) noexcept {
+        return sz <= 1 ? 0 : 64 - __builtin_clzll(sz - 1);
+    }
+
+    T *at(uint64_t off) const noexcept {
+        return blocks_[off >> BLOCK_BITS].load(std::memory_order_acquire) + (off & (BLOCK_SIZE - 1));
+    }
+
+    // Moves first min(old_sz, new_sz) elements into the segment for new_sz elements
+    uint64_t Relocate(uint64_t off, size_t old_sz, size_t new_sz) {
+        uint64_t new_off = (new_sz ? Allocate(size_class(new_sz)) : 0);
+        if (new_off && old_sz)
+            memcpy(at(new_off), at(off), std::min(old_sz, new_sz) * sizeof(T));
+        if (old_sz)
+            Release(off, size_class(old_sz));
+
+        return new_off;
+    }
+
+    uint64_t Allocate(unsigned cls) {
+        uint64_t n = 1ull << cls;
+        VERIFY_MSG(n <= BLOCK_SIZE, "Too many adjacent edges for compact graph layout");
+
+        if (free_count_[cls].load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!free_[cls].empty()) {
+                uint64_t off = free_[cls].back();
+                free_[cls].pop_back();
+                free_count_[cls] -= 1;
+                return off;
+            }
+        }
+
+        // Segments are aligned by their size, so they never cross block boundary
+        uint64_t start, top = top_.load(std::memory_order_relaxed);
+        do {
+            start = (top + n - 1) & ~(n - 1);
+        } while (!top_.compare_exchange_weak(top, start + n, std::memory_order_relaxed));
+
+        uint64_t block = start >> BLOCK_BITS;
+        VERIFY_MSG(block < MAX_BLOCKS, "Compact adjacency pool is exhausted");
+        if (!blocks_[block].load(std::memory_order_acquire)) {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (!blocks_[block].load(std::memory_order_relaxed))
+                blocks_[block].store(new T[BLOCK_SIZE], std::memory_order_release);
+        }
+
+        return start;
+    }
+
+    void Release(uint64_t off, unsigned cls) {
+        std::lock_guard<std::mutex> guard(lock_);
+        free_[cls].push_back(off);
+        free_count_[cls] += 1;
+    }
+
+    std::vector<uint64_t> slots_;
+    std::unique_ptr<std::atomic<T*>[]> blocks_;
+    std::atomic<uint64_t> top_;
+
+    std::mutex lock_;
+    std::vector<uint64_t> free_[BLOCK_BITS + 1];
+    std::atomic<size_t> free_count_[BLOCK_BITS + 1];
+};
+
+}
+
+}
@@ -50,7 +50,7 @@ public:
 
     template<class It>
     Graph component(It start, It end) const {
-        Graph clone(graph_.master_);
+        Graph clone(graph_.master_, graph_.layout());
         clone.reserve(graph_.vreserved(), graph_.ereserved());
 
         for (; start != end; ++start) {
@@ -82,14 +82,14 @@ public:
 
     void LinkIncomingEdge(VertexId v, EdgeId e) {
         VERIFY(graph_.EdgeEnd(e) == VertexId());
-        graph_.cvertex(v).AddOutgoingEdge(graph_.conjugate(e));
-        graph_.edge(e).SetEndVertex(v);
+        graph_.AddOutgoingEdge(graph_.conjugate(v), graph_.conjugate(e));
+        graph_.SetEdgeEnd(e, v);
     }
 
     void LinkOutgoingEdge(VertexId v, EdgeId e) {
         VERIFY(graph_.EdgeEnd(graph_.conjugate(e)) == VertexId());
-        graph_.vertex(v).AddOutgoingEdge(e);
-        graph_.cedge(e).SetEndVertex(graph_.conjugate(v));
+        graph_.AddOutgoingEdge(v, e);
+        graph_.SetEdgeEnd(graph_.conjugate(e), graph_.conjugate(v));
     }
 
     void LinkEdges(EdgeId e1, EdgeId e2) {
@@ -99,9 +99,9 @@ public:
     }
 
     void DeleteLink(VertexId v, EdgeId e) {
-        bool res = graph_.vertex(v).RemoveOutgoingEdge(e);
+        bool res = graph_.RemoveOutgoingEdge(v, e);
         VERIFY(res);
-        graph_.cedge(e).SetEndVertex(VertexId());
+        graph_.SetEdgeEnd(graph_.conjugate(e), VertexId());
     }
 
     void DeleteUnlinkedEdge(EdgeId e) {
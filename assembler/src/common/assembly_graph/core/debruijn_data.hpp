@@ -12,6 +12,7 @@
 
 #include <vector>
 #include <set>
+#include <memory>
 #include <cstring>
 #include <cstdint>
 
@@ -97,13 +98,29 @@ public:
 class DeBruijnDataMaster {
 private:
     const size_t k_;
+    // Storage of edge nucleotides, shared by all copies of the master
+    std::shared_ptr<NuclArena> arena_;
 
 public:
     typedef DeBruijnVertexData VertexData;
     typedef DeBruijnEdgeData EdgeData;
 
     DeBruijnDataMaster(size_t k) :
-            k_(k) {
+            k_(k), arena_(std::make_shared<NuclArena>()) {
+    }
+
+    NuclArena &arena() const {
+        return *arena_;
+    }
+
+    // Moves nucleotides of the edge into the arena, conjugate edge data is updated accordingly
+    void Repack(EdgeData &data, EdgeData &conj_data) const {
+        data.nucls_ = arena_->Copy(data.nucls_);
+        conj_data.nucls_ = !data.nucls_;
+    }
+
+    void Repack(EdgeData &data) const {
+        data.nucls_ = arena_->Copy(data.nucls_);
     }
 
     const EdgeData MergeData(const std::vector<const EdgeData*>& to_merge, bool safe_merging = true) const;
@@ -148,7 +165,7 @@ inline const DeBruijnEdgeData DeBruijnDataMaster::MergeData(const std::vector<co
     for (auto it = to_merge.begin(); it != to_merge.end(); ++it) {
         ss.push_back((*it)->nucls());
     }
-    return EdgeData(MergeOverlappingSequences(ss, k_, safe_merging));
+    return EdgeData(MergeOverlappingSequences(ss, k_, safe_merging, arena_.get()));
 }
 
 inline std::pair<DeBruijnVertexData, std::pair<DeBruijnEdgeData, DeBruijnEdgeData>> DeBruijnDataMaster::SplitData(const EdgeData& edge,
@@ -30,8 +30,8 @@ private:
     CoverageIndex<DeBruijnGraph> coverage_index_;
 
 public:
-    DeBruijnGraph(size_t k) :
-            base(k), coverage_index_(*this) {
+    DeBruijnGraph(size_t k, omnigraph::GraphLayout layout = omnigraph::GraphLayout::Default) :
+            base(k, layout), coverage_index_(*this) {
     }
 
     CoverageIndex<DeBruijnGraph>& coverage_index() {
@@ -89,6 +89,50 @@ public:
         return Sequence();
     }
 
+    /**
+     * Re-packs nucleotides of all edges into fresh slabs of the arena, so the slabs
+     * holding sequences of removed edges could be released
+     */
+    void CompactNucls() {
+        // Sequences of the deleted edges should not be used anymore
+        VERIFY(!batching());
+        INFO("Compacting edge sequences");
+        NuclArena &arena = master().arena();
+        arena.Reset();
+
+        std::vector<EdgeId> edges(canonical_edges().begin(), canonical_edges().end());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i) {
+            EdgeId e = edges[i], ce = conjugate(e);
+            if (e == ce)
+                master().Repack(data(e));
+            else
+                master().Repack(data(e), data(ce));
+        }
+        INFO("Edge sequences compacted, " << arena.slabs() << " slabs allocated in total");
+    }
+
+    /**
+     * Compacts edge sequences (see CompactNucls()), if the share of nucleotides packed since the last
+     * compaction that belong to removed edges exceeds max_garbage
+     */
+    void CompactNuclsIfSparse(double max_garbage = 0.5) {
+        if (batching())
+            return;
+
+        // Long sequences are allocated separately and do not count towards the packed size
+        size_t live = 0;
+        for (EdgeId e : canonical_edges())
+            live += NuclArena::PackedSize(EdgeNucls(e).size());
+
+        size_t packed = master().arena().allocated();
+        DEBUG("Edge sequences: " << live << " bytes used, " << packed << " bytes packed");
+        if (double(live) >= double(packed) * (1. - max_garbage))
+            return;
+
+        CompactNucls();
+    }
+
 private:
     DECL_LOGGER("DeBruijnGraph")
 };
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "id_distributor.hpp"
+#include "compact_adjacency.hpp"
 #include "utils/verify.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/stl_utils.hpp"
@@ -23,6 +24,7 @@
 #include <atomic>
 #include <vector>
 #include <set>
+#include <type_traits>
 
 namespace omnigraph {
 
@@ -77,8 +79,31 @@ struct EdgeId : public Id {
     using Id::Id;
 };
 
+// Topology of graph elements is kept apart from their data in dense per-id arrays,
+// so traversals do not touch (potentially large) edge data
+struct VertexLinks {
+    VertexId conjugate;
+};
+
+struct EdgeLinks {
+    VertexId end;
+    EdgeId conjugate;
+};
+
 }
 
+/**
+ * Layout of vertex adjacency lists:
+ *  - Default: every vertex owns a small vector of its outgoing edges (up to 3 edges are stored inline);
+ *  - Compact: outgoing edges of all vertices are stored in a single CSR-like pool, every vertex keeps only
+ *             a packed (offset, size) slot. Saves memory and improves locality on large graphs
+ *             (enabled in SPAdes by compact_graph option).
+ */
+enum class GraphLayout {
+    Default,
+    Compact
+};
+
 template<class It, class Graph>
 class conjugate_iterator : public boost::iterator_adaptor<conjugate_iterator<It, Graph>,
                                                           It,
@@ -124,24 +149,16 @@ private:
     friend class PairedElementManipulationHelper<EdgeId>;
     //todo unfriend
     friend class PairedVertex<DataMaster>;
-    VertexId end_;
-    EdgeId conjugate_;
     EdgeData data_;
 
-    PairedEdge(VertexId end, const EdgeData &data)
-            : end_(end), data_(data) {}
+    PairedEdge(const EdgeData &data)
+            : data_(data) {}
 
     PairedEdge(PairedEdge &&that) = default;
 
     EdgeData &data() noexcept { return data_; }
     const EdgeData &data() const noexcept { return data_; }
     void set_data(const EdgeData &data)  noexcept { data_ = data; }
-
-    VertexId end() const noexcept { return end_; }
-    void SetEndVertex(VertexId end) noexcept { end_ = end; }
-
-    EdgeId conjugate() const noexcept { return conjugate_; }
-    void set_conjugate(EdgeId conjugate) noexcept { conjugate_ = conjugate; }
 };
 
 template<class DataMaster>
@@ -150,37 +167,14 @@ private:
     typedef typename DataMaster::VertexData VertexData;
     typedef impl::EdgeId EdgeId;
     typedef impl::VertexId VertexId;
-    typedef typename adt::SmallPODVector<EdgeId>::const_iterator edge_raw_iterator;
 
-public:
-    typedef conjugate_iterator<edge_raw_iterator, GraphCore<DataMaster>> edge_const_iterator;
-
-private:
     friend class GraphCore<DataMaster>;
     friend class ConstructionHelper<DataMaster>;
     friend class PairedEdge<DataMaster>;
     friend class PairedElementManipulationHelper<VertexId>;
-    template<class It, class Graph>
-    friend class conjugate_iterator;
 
-    adt::SmallPODVector<EdgeId> outgoing_edges_;
-
-    VertexId conjugate_;
     VertexData data_;
 
-    VertexId conjugate() const noexcept { return conjugate_; }
-    void set_conjugate(VertexId conjugate) noexcept { conjugate_ = conjugate; }
-
-    size_t OutgoingEdgeCount() const noexcept { return outgoing_edges_.size(); }
-
-    edge_const_iterator out_begin(const GraphCore<DataMaster> *graph, bool conjugate = false) const {
-        return edge_const_iterator(outgoing_edges_.cbegin(), graph, conjugate);
-    }
-
-    edge_const_iterator out_end(const GraphCore<DataMaster> *graph, bool conjugate = false) const {
-        return edge_const_iterator(outgoing_edges_.cend(), graph, conjugate);
-    }
-
     PairedVertex(const VertexData &data)
             : data_(data) {}
 
@@ -189,24 +183,6 @@ private:
     VertexData &data() noexcept { return data_; }
     const VertexData &data() const noexcept { return data_; }
     void set_data(VertexData data) noexcept { data_ = data; }
-
-    void AddOutgoingEdge(EdgeId e) {
-        outgoing_edges_.insert(std::upper_bound(outgoing_edges_.begin(), outgoing_edges_.end(), e), e);
-        //outgoing_edges_.push_back(e);
-    }
-
-    bool RemoveOutgoingEdge(const EdgeId e) {
-        auto it = std::find(outgoing_edges_.begin(), outgoing_edges_.end(), e);
-        if (it == outgoing_edges_.end())
-            return false;
-
-        outgoing_edges_.erase(it);
-        return true;
-    }
-
-    ~PairedVertex() {
-        VERIFY(outgoing_edges_.size() == 0);
-    }
 };
 
 template<class DataMaster>
@@ -217,7 +193,7 @@ public:
     typedef typename DataMasterT::EdgeData EdgeData;
     typedef impl::EdgeId EdgeId;
     typedef impl::VertexId VertexId;
-    typedef typename PairedVertex<DataMaster>::edge_const_iterator edge_const_iterator;
+    typedef conjugate_iterator<const EdgeId*, GraphCore<DataMaster>> edge_const_iterator;
 
 private:
     DataMaster master_;
@@ -227,14 +203,22 @@ private:
 private:
     static constexpr unsigned ID_BIAS = 3;
 
-    template<class T>
+    // Storage of elements indexed by id. Element data and element topology (links) are kept in separate arrays
+    template<class T, class Links>
     class IdStorage {
+        static_assert(std::is_trivially_copyable<Links>::value,
+                      "Element links should be trivially copyable");
+
       private:
         void resize(size_t N) {
             VERIFY(N > storage_size_);
+            Links *new_links = (Links*)realloc(links_, N * sizeof(Links));
+            VERIFY(new_links);
+            links_ = new_links;
+
             T *new_storage = (T*)malloc(N * sizeof(T));
             for (uint64_t id = bias_; id < storage_size_; ++id) {
-                if (!id_distributor_.occupied(id))
+                if (!id_distributor_.occupied(id) && !id_distributor_.retired(id))
                     continue;
 
                 T *val = &storage_[id];
@@ -253,13 +237,15 @@ private:
         typedef T value_type;
 
         IdStorage(uint64_t bias = ID_BIAS)
-                : size_(0), bias_(bias), storage_(nullptr), storage_size_(0), id_distributor_(bias) {
+                : size_(0), retired_(0), bias_(bias), storage_(nullptr), links_(nullptr), storage_size_(0), id_distributor_(bias) {
             resize(id_distributor_.size() + bias_);
         }
 
         ~IdStorage() {
             if (storage_)
                 free(storage_);
+            if (links_)
+                free(links_);
         }
 
         id_iterator id_begin() const { return id_distributor_.begin(); }
@@ -267,15 +253,18 @@ private:
         uint64_t max_id() const { return id_distributor_.max_id(); }
 
         void reserve(size_t sz) {
-            if (storage_size_ >= sz + bias_)
-                return;
-
-            id_distributor_.resize(sz);
-            resize(sz + bias_);
+            if (id_distributor_.size() < sz)
+                id_distributor_.resize(sz);
+            if (storage_size_ < sz + bias_)
+                resize(sz + bias_);
         }
 
         // FIXME: Count!
         size_t size() const noexcept { return size_; }
+        // Upper bound for ids that could be used without reallocation
+        size_t capacity() const noexcept { return storage_size_; }
+        // Number of elements that could be created without reallocation
+        size_t available() const noexcept { return id_distributor_.size() - size_ - retired_; }
 
         bool contains(uint64_t id) const {
             return id < storage_size_ && id_distributor_.occupied(id);
@@ -288,7 +277,8 @@ private:
             while (storage_size_ < id + 1)
                 resize(storage_size_ * 2 + 1);
 
-            new(storage_ + id) T(std::forward<ArgTypes>(args)...);;
+            new(storage_ + id) T(std::forward<ArgTypes>(args)...);
+            new(links_ + id) Links();
             size_ += 1;
 
             // INFO("Create " << id);
@@ -298,10 +288,11 @@ private:
         template<typename... ArgTypes>
         uint64_t emplace(uint64_t at, ArgTypes &&... args) {
             // One MUST call reserve before using emplace()
-            VERIFY(!id_distributor_.occupied(at));
+            VERIFY(!id_distributor_.occupied(at) && !id_distributor_.retired(at));
 
             id_distributor_.acquire(at);
-            new(storage_ + at) T(std::forward<ArgTypes>(args)...);;
+            new(storage_ + at) T(std::forward<ArgTypes>(args)...);
+            new(links_ + at) Links();
             size_.fetch_add(1);
 
             // INFO("Emplace " << at);
@@ -318,38 +309,113 @@ private:
             size_ -= 1;
         }
 
+        // Removes the element, but keeps its data and does not reuse its id until reclaim() is called
+        void retire(uint64_t id) {
+            id_distributor_.retire(id);
+            size_ -= 1;
+            retired_ += 1;
+        }
+
+        void reclaim(uint64_t id) {
+            storage_[id].~T();
+            id_distributor_.reclaim(id);
+            retired_ -= 1;
+        }
+
         T& at(uint64_t id) const noexcept {
             return storage_[id];
         }
 
+        Links& links(uint64_t id) const noexcept {
+            return links_[id];
+        }
+
         uint64_t reserved() const { return id_distributor_.size(); }
         void clear_state() { id_distributor_.clear_state(); }
 
       private:
         std::atomic<size_t> size_;
+        std::atomic<size_t> retired_;
         uint64_t bias_;
         T *storage_;
+        Links *links_;
         size_t storage_size_;
         omnigraph::ReclaimingIdDistributor id_distributor_;
     };
 
-    using VertexStorage = IdStorage<PairedVertex<DataMaster>>;
+    using VertexStorage = IdStorage<PairedVertex<DataMaster>, impl::VertexLinks>;
     VertexStorage vstorage_;
-    using EdgeStorage = IdStorage<PairedEdge<DataMaster>>;
+    using EdgeStorage = IdStorage<PairedEdge<DataMaster>, impl::EdgeLinks>;
     EdgeStorage estorage_;
 
+    GraphLayout layout_;
+    // Outgoing edges of vertices indexed by vertex id, only one of them is used depending on layout
+    std::vector<adt::SmallPODVector<EdgeId>> outgoing_edges_;
+    impl::CompactAdjacency<EdgeId> compact_outgoing_edges_;
+    // Elements deleted while retain_deleted_ is set, they are destroyed by ReclaimDeleted()
+    bool retain_deleted_ = false;
+    std::vector<VertexId> retired_vertices_;
+    std::vector<EdgeId> retired_edges_;
+
     PairedVertex<DataMaster>& vertex(VertexId id) const noexcept {
         return vstorage_.at(id.int_id());
     }
-    PairedVertex<DataMaster>& cvertex(VertexId id) const noexcept {
-        return vertex(conjugate(id));
+    impl::VertexLinks& vlinks(VertexId id) const noexcept {
+        return vstorage_.links(id.int_id());
     }
 
     PairedEdge<DataMaster>& edge(EdgeId id) const noexcept {
         return estorage_.at(id.int_id());
     }
-    PairedEdge<DataMaster>& cedge(EdgeId id) const noexcept {
-        return edge(conjugate(id));
+    impl::EdgeLinks& elinks(EdgeId id) const noexcept {
+        return estorage_.links(id.int_id());
+    }
+
+    bool compact() const noexcept { return layout_ == GraphLayout::Compact; }
+
+    // Makes adjacency lists available for all vertex ids that could be created without reallocation
+    void ReserveAdjacency() {
+        size_t sz = vstorage_.capacity();
+        if (compact())
+            compact_outgoing_edges_.resize(sz);
+        else if (outgoing_edges_.size() < sz)
+            outgoing_edges_.resize(sz);
+    }
+
+    const EdgeId *out_raw_begin(VertexId v) const noexcept {
+        return compact() ?
+                compact_outgoing_edges_.begin(v.int_id()) : outgoing_edges_[v.int_id()].cbegin();
+    }
+    const EdgeId *out_raw_end(VertexId v) const noexcept {
+        return compact() ?
+                compact_outgoing_edges_.end(v.int_id()) : outgoing_edges_[v.int_id()].cend();
+    }
+
+    void AddOutgoingEdge(VertexId v, EdgeId e) {
+        if (compact()) {
+            compact_outgoing_edges_.insert(v.int_id(), e);
+            return;
+        }
+
+        auto &edges = outgoing_edges_[v.int_id()];
+        edges.insert(std::upper_bound(edges.begin(), edges.end(), e), e);
+    }
+
+    bool RemoveOutgoingEdge(VertexId v, EdgeId e) {
+        if (compact())
+            return compact_outgoing_edges_.erase(v.int_id(), e);
+
+        auto &edges = outgoing_edges_[v.int_id()];
+        auto it = std::find(edges.begin(), edges.end(), e);
+        if (it == edges.end())
+            return false;
+
+        edges.erase(it);
+        return true;
+    }
+
+    void SetEdgeEnd(EdgeId e, VertexId v) noexcept {
+        elinks(e).end = v;
     }
 
     struct EdgePredicate {
@@ -544,11 +610,15 @@ public:
         return edges<true>();
     }
 
-    edge_const_iterator out_begin(VertexId v) const { return vertex(v).out_begin(this); }
-    edge_const_iterator out_end(VertexId v) const { return vertex(v).out_end(this); }
+    edge_const_iterator out_begin(VertexId v) const { return edge_const_iterator(out_raw_begin(v), this); }
+    edge_const_iterator out_end(VertexId v) const { return edge_const_iterator(out_raw_end(v), this); }
 
-    edge_const_iterator in_begin(VertexId v) const { return cvertex(v).out_begin(this, true); }
-    edge_const_iterator in_end(VertexId v) const { return cvertex(v).out_end(this, true); }
+    edge_const_iterator in_begin(VertexId v) const {
+        return edge_const_iterator(out_raw_begin(conjugate(v)), this, true);
+    }
+    edge_const_iterator in_end(VertexId v) const {
+        return edge_const_iterator(out_raw_end(conjugate(v)), this, true);
+    }
 
     void clear_state() { estorage_.clear_state(); vstorage_.clear_state(); }
 
@@ -564,15 +634,29 @@ private:
 
         VertexId vid1 = (id1 ? vstorage_.emplace(id1.int_id(), data1) : vstorage_.create(data1));
         VertexId vid2 = (id2 ? vstorage_.emplace(id2.int_id(), data2) : vstorage_.create(data2));
+        // Emplaced vertices are reserved in advance, so adjacency lists are never reallocated concurrently
+        if (!id1 || !id2)
+            ReserveAdjacency();
 
-        vertex(vid1).set_conjugate(vid2);
-        vertex(vid2).set_conjugate(vid1);
+        vlinks(vid1).conjugate = vid2;
+        vlinks(vid2).conjugate = vid1;
 
         return vid1;
     }
 
     void DestroyVertex(VertexId v) {
         VertexId cv = conjugate(v);
+        VERIFY(OutgoingEdgeCount(v) == 0 && OutgoingEdgeCount(cv) == 0);
+        if (retain_deleted_) {
+            vstorage_.retire(v.int_id());
+            vstorage_.retire(cv.int_id());
+#           pragma omp critical(graph_core_retired)
+            {
+                retired_vertices_.push_back(v);
+                retired_vertices_.push_back(cv);
+            }
+            return;
+        }
         vstorage_.erase(v.int_id());
         vstorage_.erase(cv.int_id());
     }
@@ -580,14 +664,27 @@ private:
     EdgeId AddSingleEdge(VertexId v1, VertexId v2,
                          const EdgeData &data, EdgeId id = 0) {
         EdgeId eid = (id ?
-                      estorage_.emplace(id.int_id(), v2, data) :
-                      estorage_.create(v2, data));
+                      estorage_.emplace(id.int_id(), data) :
+                      estorage_.create(data));
+        SetEdgeEnd(eid, v2);
         if (v1.int_id())
-            vertex(v1).AddOutgoingEdge(eid);
+            AddOutgoingEdge(v1, eid);
         return eid;
     }
 
     void DestroyEdge(EdgeId e, EdgeId rc) {
+        if (retain_deleted_) {
+            if (e != rc)
+                estorage_.retire(rc.int_id());
+            estorage_.retire(e.int_id());
+#           pragma omp critical(graph_core_retired)
+            {
+                if (e != rc)
+                    retired_edges_.push_back(rc);
+                retired_edges_.push_back(e);
+            }
+            return;
+        }
         if (e != rc)
             estorage_.erase(rc.int_id());
         estorage_.erase(e.int_id());
@@ -611,7 +708,7 @@ protected:
                          EdgeId at1 = 0, EdgeId at2 = 0) {
         EdgeId result = AddSingleEdge(VertexId(), VertexId(), data, at1);
         if (this->master().isSelfConjugate(data)) {
-            edge(result).set_conjugate(result);
+            elinks(result).conjugate = result;
             return result;
         }
 
@@ -619,8 +716,8 @@ protected:
             at2 = at1.int_id() + 1;
         EdgeId rcEdge = AddSingleEdge(VertexId(), VertexId(), this->master().conjugate(data),
                                       at2);
-        edge(result).set_conjugate(rcEdge);
-        edge(rcEdge).set_conjugate(result);
+        elinks(result).conjugate = rcEdge;
+        elinks(rcEdge).conjugate = result;
         return result;
     }
 
@@ -634,26 +731,26 @@ protected:
             //          Because of some split issues: when self-conjugate edge is split armageddon happends
             //          VERIFY(v1 == conjugate(v2));
             //          VERIFY(v1 == conjugate(v2));
-            edge(result).set_conjugate(result);
+            elinks(result).conjugate = result;
             return result;
         }
 
         if (at1 && !at2)
             at2 = at1.int_id() + 1;
-        EdgeId rcEdge = AddSingleEdge(vertex(v2).conjugate(), vertex(v1).conjugate(),
+        EdgeId rcEdge = AddSingleEdge(conjugate(v2), conjugate(v1),
                                       this->master().conjugate(data), at2);
-        edge(result).set_conjugate(rcEdge);
-        edge(rcEdge).set_conjugate(result);
+        elinks(result).conjugate = rcEdge;
+        elinks(rcEdge).conjugate = result;
         return result;
     }
 
     void HiddenDeleteEdge(EdgeId e) {
         TRACE("Hidden delete edge " << e.int_id());
         EdgeId rcEdge = conjugate(e);
-        VertexId rcStart = conjugate(edge(e).end());
-        VertexId start = conjugate(edge(rcEdge).end());
-        vertex(start).RemoveOutgoingEdge(e);
-        vertex(rcStart).RemoveOutgoingEdge(rcEdge);
+        VertexId rcStart = conjugate(EdgeEnd(e));
+        VertexId start = conjugate(EdgeEnd(rcEdge));
+        RemoveOutgoingEdge(start, e);
+        RemoveOutgoingEdge(rcStart, rcEdge);
         DestroyEdge(e, rcEdge);
     }
 
@@ -665,27 +762,59 @@ protected:
             HiddenDeleteVertex(v);
     }
 
+    // While set, deleted elements are only unlinked from the graph. Their data (and conjugate links)
+    // stay accessible and their ids are not reused until ReclaimDeleted() is called
+    void RetainDeleted(bool retain) {
+        retain_deleted_ = retain;
+    }
+
+    void ReclaimDeleted() {
+        for (EdgeId e : retired_edges_)
+            estorage_.reclaim(e.int_id());
+        for (VertexId v : retired_vertices_)
+            vstorage_.reclaim(v.int_id());
+        retired_edges_.clear();
+        retired_vertices_.clear();
+    }
+
 public:
-    GraphCore(const DataMaster& master)
+    GraphCore(const DataMaster& master, GraphLayout layout = GraphLayout::Default)
             : master_(master),
-              vstorage_(ID_BIAS), estorage_(ID_BIAS) {
-        INFO("Graph created, vertex min_id: " << ID_BIAS << ", edge min_id: " << ID_BIAS);
-        INFO("Vertex size: " << sizeof(PairedVertex<DataMaster>) << ", edge size: " << sizeof(PairedEdge<DataMaster>));
+              vstorage_(ID_BIAS), estorage_(ID_BIAS),
+              layout_(layout) {
+        ReserveAdjacency();
+        INFO("Graph created, vertex min_id: " << ID_BIAS << ", edge min_id: " << ID_BIAS
+             << (compact() ? ", compact layout" : ""));
+        INFO("Vertex size: " << sizeof(PairedVertex<DataMaster>) + sizeof(impl::VertexLinks)
+             << ", edge size: " << sizeof(PairedEdge<DataMaster>) + sizeof(impl::EdgeLinks));
     }
 
     virtual ~GraphCore() { VERIFY(size() == 0); }
 
-    void vreserve(size_t sz) { vstorage_.reserve(sz); }
+    void vreserve(size_t sz) {
+        vstorage_.reserve(sz);
+        ReserveAdjacency();
+    }
     void ereserve(size_t sz) { estorage_.reserve(sz); }
     void reserve(size_t vertices, size_t edges) {
         vreserve(vertices);
         ereserve(edges);
     }
 
+    // Makes sure that the given number of new vertices and edges could be created without reallocation
+    // of element storage, so that threads modifying disjoint parts of the graph could create them concurrently
+    void reserve_new(size_t vertices, size_t edges) {
+        if (vstorage_.available() < vertices)
+            vreserve(vstorage_.reserved() + vertices);
+        if (estorage_.available() < edges)
+            ereserve(estorage_.reserved() + edges);
+    }
+
     size_t vreserved() const { return vstorage_.reserved(); }
     size_t ereserved() const { return estorage_.reserved(); }
 
     uint64_t min_id() const noexcept { return ID_BIAS; }
+    GraphLayout layout() const noexcept { return layout_; }
 
     bool contains(VertexId vertex) const {
         return vstorage_.contains(vertex.int_id());
@@ -704,23 +833,24 @@ public:
     EdgeData& data(EdgeId e) noexcept { return edge(e).data(); }
     VertexData& data(VertexId v) noexcept { return vertex(v).data(); }
 
-    size_t OutgoingEdgeCount(VertexId v) const noexcept { return vertex(v).OutgoingEdgeCount(); }
-    size_t IncomingEdgeCount(VertexId v) const noexcept { return cvertex(v).OutgoingEdgeCount(); }
+    size_t OutgoingEdgeCount(VertexId v) const noexcept {
+        return compact() ?
+                compact_outgoing_edges_.size(v.int_id()) : outgoing_edges_[v.int_id()].size();
+    }
+    size_t IncomingEdgeCount(VertexId v) const noexcept { return OutgoingEdgeCount(conjugate(v)); }
 
     adt::iterator_range<edge_const_iterator> OutgoingEdges(VertexId v) const {
-        auto &vertex = this->vertex(v);
-        return { vertex.out_begin(this), vertex.out_end(this) };
+        return { out_begin(v), out_end(v) };
     }
 
     adt::iterator_range<edge_const_iterator> IncomingEdges(VertexId v) const {
-        auto &vertex = this->cvertex(v);
-        return { vertex.out_begin(this, true), vertex.out_end(this, true) };
+        return { in_begin(v), in_end(v) };
     }
 
     std::vector<EdgeId> GetEdgesBetween(VertexId v, VertexId u) const {
         std::vector<EdgeId> result;
         for (auto e : OutgoingEdges(v)) {
-            if (edge(e).end() != u)
+            if (EdgeEnd(e) != u)
                 continue;
 
             result.push_back(e);
@@ -734,10 +864,10 @@ public:
 
     //////////////////////// Edge information
     VertexId EdgeStart(EdgeId edge) const noexcept { return conjugate(EdgeEnd(conjugate(edge))); }
-    VertexId EdgeEnd(EdgeId e) const noexcept { return edge(e).end(); }
+    VertexId EdgeEnd(EdgeId e) const noexcept { return elinks(e).end; }
 
-    VertexId conjugate(VertexId v) const noexcept { return vertex(v).conjugate(); }
-    EdgeId conjugate(EdgeId e) const noexcept { return edge(e).conjugate(); }
+    VertexId conjugate(VertexId v) const noexcept { return vlinks(v).conjugate; }
+    EdgeId conjugate(EdgeId e) const noexcept { return elinks(e).conjugate; }
 
     size_t length(EdgeId edge) const { return master_.length(data(edge)); }
     size_t length(VertexId v) const { return master_.length(data(v)); }
@@ -0,0 +1,111 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "action_handlers.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace omnigraph {
+
+/**
+ * GraphEventLog keeps graph events recorded in batched mode of ObservableGraph. Events are replayed
+ * to every batched handler in the order they were recorded through the same HandlerApplier the graph
+ * uses for immediate dispatch. Paths of merge events are kept in a single array shared by all events.
+ */
+template<typename VertexId, typename EdgeId>
+class GraphEventLog {
+    typedef ActionHandler<VertexId, EdgeId> Handler;
+    typedef HandlerApplier<VertexId, EdgeId> Applier;
+
+    enum class EventType : uint8_t {
+        AddVertex, AddEdge, DeleteVertex, DeleteEdge, Merge, Glue, Split
+    };
+
+    struct Event {
+        EventType type;
+        VertexId vertex;
+        EdgeId edges[3];
+        size_t path_begin, path_end;
+    };
+
+public:
+    void RecordAdd(VertexId v) {
+        events_.push_back({ EventType::AddVertex, v, {}, 0, 0 });
+    }
+
+    void RecordAdd(EdgeId e) {
+        events_.push_back({ EventType::AddEdge, VertexId(), { e }, 0, 0 });
+    }
+
+    void RecordDelete(VertexId v) {
+        events_.push_back({ EventType::DeleteVertex, v, {}, 0, 0 });
+    }
+
+    void RecordDelete(EdgeId e) {
+        events_.push_back({ EventType::DeleteEdge, VertexId(), { e }, 0, 0 });
+    }
+
+    void RecordMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) {
+        size_t path_begin = paths_.size();
+        paths_.insert(paths_.end(), old_edges.begin(), old_edges.end());
+        events_.push_back({ EventType::Merge, VertexId(), { new_edge }, path_begin, paths_.size() });
+    }
+
+    void RecordGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
+        events_.push_back({ EventType::Glue, VertexId(), { new_edge, edge1, edge2 }, 0, 0 });
+    }
+
+    void RecordSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) {
+        events_.push_back({ EventType::Split, VertexId(), { edge, new_edge1, new_edge2 }, 0, 0 });
+    }
+
+    void Replay(const Applier &applier, Handler &handler) const {
+        std::vector<EdgeId> path;
+        for (const Event &event : events_) {
+            switch (event.type) {
+                case EventType::AddVertex:
+                    applier.ApplyAdd(handler, event.vertex);
+                    break;
+                case EventType::AddEdge:
+                    applier.ApplyAdd(handler, event.edges[0]);
+                    break;
+                case EventType::DeleteVertex:
+                    applier.ApplyDelete(handler, event.vertex);
+                    break;
+                case EventType::DeleteEdge:
+                    applier.ApplyDelete(handler, event.edges[0]);
+                    break;
+                case EventType::Merge:
+                    path.assign(paths_.begin() + event.path_begin, paths_.begin() + event.path_end);
+                    applier.ApplyMerge(handler, path, event.edges[0]);
+                    break;
+                case EventType::Glue:
+                    applier.ApplyGlue(handler, event.edges[0], event.edges[1], event.edges[2]);
+                    break;
+                case EventType::Split:
+                    applier.ApplySplit(handler, event.edges[0], event.edges[1], event.edges[2]);
+                    break;
+            }
+        }
+    }
+
+    size_t size() const { return events_.size(); }
+    bool empty() const { return events_.empty(); }
+
+    void clear() {
+        events_.clear();
+        paths_.clear();
+    }
+
+private:
+    std::vector<Event> events_;
+    std::vector<EdgeId> paths_;
+};
+
+}
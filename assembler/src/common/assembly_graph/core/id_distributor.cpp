@@ -4,7 +4,7 @@ using namespace omnigraph;
 
 uint64_t ReclaimingIdDistributor::next_free(uint64_t n) const {
     for (size_t i = n; i < free_map_.size(); ++i) {
-        if (free_map_[i])
+        if (free_map_[i] && !retired_map_[i])
             return i;
     }
 
@@ -14,23 +14,29 @@ uint64_t ReclaimingIdDistributor::next_free(uint64_t n) const {
 void ReclaimingIdDistributor::resize(size_t sz) {
     //fprintf(stderr, "!!!RESIZE!!!! %llu\n", sz);
     free_map_.resize(sz, true);
+    retired_map_.resize(sz, false);
 }
 
 uint64_t ReclaimingIdDistributor::allocate(uint64_t offset) {
-    // First hint: see if we could find any spot after last allocated
-    uint64_t hint = last_allocated_ + offset;
-    uint64_t n = next_free(hint);
-    if (n == free_map_.size()) {
-        // No luck, start from the beginning
-        n = next_free();
+    uint64_t n;
+    // FIXME: "lock" only single bit
+#pragma omp critical
+    {
+        // First hint: see if we could find any spot after last allocated
+        uint64_t hint = last_allocated_ + offset;
+        n = next_free(hint);
+        if (n == free_map_.size()) {
+            // No luck, start from the beginning
+            n = next_free();
+        }
+
+        // Still no luck, resize
+        if (n == free_map_.size())
+            resize(free_map_.size() * 2);
+
+        last_allocated_ = n;
+        free_map_[n] = false;
     }
-
-    // Still no luck, resize
-    if (n == free_map_.size())
-        resize(free_map_.size() * 2);
-
-    last_allocated_ = n;
-    free_map_[n] = false;
     return n + bias_;
 }
 
@@ -43,6 +43,21 @@ class ReclaimingIdDistributor {
 #pragma omp critical
         free_map_[at - bias_] = true;
     }
+    // Retired id is not occupied anymore, but is not allocated again until it is reclaimed
+    void retire(uint64_t at) {
+#pragma omp critical
+        {
+            free_map_[at - bias_] = true;
+            retired_map_[at - bias_] = true;
+        }
+    }
+    void reclaim(uint64_t at) {
+#pragma omp critical
+        retired_map_[at - bias_] = false;
+    }
+    bool retired(uint64_t at) const {
+        return retired_map_[at - bias_];
+    }
 
     void clear_state(void) { last_allocated_ = 0; }
 
@@ -110,6 +125,7 @@ class ReclaimingIdDistributor {
     uint64_t last_allocated_;
     uint64_t bias_;
     std::vector<bool> free_map_;
+    std::vector<bool> retired_map_;
 };
 
 }
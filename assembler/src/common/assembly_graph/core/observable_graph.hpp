@@ -10,7 +10,10 @@
 #include "utils/logger/logger.hpp"
 #include "graph_core.hpp"
 #include "graph_iterators.hpp"
+#include "graph_event_log.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
+#include <algorithm>
 #include <vector>
 #include <set>
 #include <cstring>
@@ -34,12 +37,30 @@ public:
     typedef SmartEdgeIterator<ObservableGraph> SmartEdgeIt;
     typedef ConstEdgeIterator<ObservableGraph> ConstEdgeIt;
     typedef ActionHandler<VertexId, EdgeId> Handler;
+    typedef GraphEventLog<VertexId, EdgeId> EventLog;
 
 private:
    //todo switch to smart iterators
    mutable std::vector<Handler*> action_handler_list_;
    std::unique_ptr<const HandlerApplier<VertexId, EdgeId>> applier_;
 
+   // Batched mode state: handlers receiving the events at sync points and the events recorded since the last one
+   bool batching_;
+   mutable std::vector<Handler*> batched_handlers_;
+   mutable EventLog event_log_;
+
+   // Handlers, which are not thread-safe, never get events concurrently. Disjoint parts of the graph could be
+   // modified in parallel (see ParallelBulgeRemover), then the events for such handlers are delivered one at a time
+   template<class F>
+   void Deliver(const Handler &handler, F apply) const {
+       if (handler.IsThreadSafe() || !omp_in_parallel()) {
+           apply();
+           return;
+       }
+#      pragma omp critical(graph_event_handlers)
+       apply();
+   }
+
 public:
 //todo move to graph core
     typedef ConstructionHelper<DataMaster> HelperT;
@@ -82,6 +103,26 @@ public:
 
     bool VerifyAllDetached();
 
+    /**
+     * Switches the graph to batched mode. Events for the attached handlers, which are batchable, are recorded
+     * into the log instead of being delivered immediately. Deleted elements are unlinked from the graph,
+     * but their data are kept and their ids are not reused until the sync point.
+     * Handlers added while the graph is in batched mode receive events immediately.
+     */
+    void StartBatching();
+
+    /**
+     * Sync point: delivers recorded events to the batched handlers (independent handlers are processed
+     * in parallel) and destroys the elements deleted since the previous sync point.
+     */
+    void FlushEvents();
+
+    void StopBatching();
+
+    bool batching() const {
+        return batching_;
+    }
+
     //smart iterators
     template<typename Priority>
     SmartVertexIterator<ObservableGraph, Priority> SmartVertexBegin(
@@ -109,8 +150,9 @@ public:
 
     void FireDeletePath(const std::vector<EdgeId>& edges_to_delete, const std::vector<VertexId>& vertices_to_delete) const;
 
-    ObservableGraph(const DataMaster& master) :
-            base(master), applier_(new PairedHandlerApplier<ObservableGraph>(*this)) {
+    ObservableGraph(const DataMaster& master, GraphLayout layout = GraphLayout::Default) :
+            base(master, layout), applier_(new PairedHandlerApplier<ObservableGraph>(*this)),
+            batching_(false) {
     }
 
     virtual ~ObservableGraph();
@@ -285,7 +327,11 @@ bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_hand
     {
         auto it = std::find(action_handler_list_.begin(), action_handler_list_.end(), action_handler);
         if (it != action_handler_list_.end()) {
+            // Events recorded for the handler are dropped, the handler gets the immediate ones if attached again
+            (*it)->SetBatched(false);
             action_handler_list_.erase(it);
+            batched_handlers_.erase(std::remove(batched_handlers_.begin(), batched_handlers_.end(), action_handler),
+                                    batched_handlers_.end());
             TRACE("Action handler " << action_handler->name() << " removed");
             result = true;
         } else {
@@ -298,7 +344,8 @@ bool ObservableGraph<DataMaster>::RemoveActionHandler(const Handler* action_hand
 template<class DataMaster>
 bool ObservableGraph<DataMaster>::AllHandlersThreadSafe() const {
     for (Handler* handler : action_handler_list_) {
-        if (handler->IsAttached() && !handler->IsThreadSafe()) {
+        // Batched handlers are never called concurrently
+        if (handler->IsAttached() && !handler->IsBatched() && !handler->IsThreadSafe()) {
             return false;
         }
     }
@@ -324,66 +371,94 @@ void ObservableGraph<DataMaster>::FireGameOver() const {
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddVertex(VertexId v) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !handler_ptr->IsBatched()) {
             TRACE("FireAddVertex to handler " << handler_ptr->name());
-            applier_->ApplyAdd(*handler_ptr, v);
+            Deliver(*handler_ptr, [&] { applier_->ApplyAdd(*handler_ptr, v); });
         }
     }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordAdd(v);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireAddEdge(EdgeId e) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
+        if (handler_ptr->IsAttached() && !handler_ptr->IsBatched()) {
             TRACE("FireAddEdge to handler " << handler_ptr->name());
-            applier_->ApplyAdd(*handler_ptr, e);
+            Deliver(*handler_ptr, [&] { applier_->ApplyAdd(*handler_ptr, e); });
         }
     }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordAdd(e);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteVertex(VertexId v) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
-        if ((*it)->IsAttached()) {
-            applier_->ApplyDelete(**it, v);
+        if ((*it)->IsAttached() && !(*it)->IsBatched()) {
+            Deliver(**it, [&] { applier_->ApplyDelete(**it, v); });
         }
     }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordDelete(v);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeleteEdge(EdgeId e) const {
     for (auto it = action_handler_list_.rbegin(); it != action_handler_list_.rend(); ++it) {
-        if ((*it)->IsAttached()) {
-            applier_->ApplyDelete(**it, e);
+        if ((*it)->IsAttached() && !(*it)->IsBatched()) {
+            Deliver(**it, [&] { applier_->ApplyDelete(**it, e); });
         }
-    };
+    }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordDelete(e);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
-            applier_->ApplyMerge(*handler_ptr, old_edges, new_edge);
+        if (handler_ptr->IsAttached() && !handler_ptr->IsBatched()) {
+            Deliver(*handler_ptr, [&] { applier_->ApplyMerge(*handler_ptr, old_edges, new_edge); });
         }
     }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordMerge(old_edges, new_edge);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
-            applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2);
+        if (handler_ptr->IsAttached() && !handler_ptr->IsBatched()) {
+            Deliver(*handler_ptr, [&] { applier_->ApplyGlue(*handler_ptr, new_edge, edge1, edge2); });
         }
-    };
+    }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordGlue(new_edge, edge1, edge2);
+    }
 }
 
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireSplit(EdgeId edge, EdgeId new_edge1, EdgeId new_edge2) const {
     for (Handler* handler_ptr : action_handler_list_) {
-        if (handler_ptr->IsAttached()) {
-            applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2);
+        if (handler_ptr->IsAttached() && !handler_ptr->IsBatched()) {
+            Deliver(*handler_ptr, [&] { applier_->ApplySplit(*handler_ptr, edge, new_edge1, new_edge2); });
         }
     }
+    if (batching_) {
+#       pragma omp critical(graph_event_log)
+        event_log_.RecordSplit(edge, new_edge1, new_edge2);
+    }
 }
 
 template<class DataMaster>
@@ -396,6 +471,46 @@ bool ObservableGraph<DataMaster>::VerifyAllDetached() {
     return true;
 }
 
+template<class DataMaster>
+void ObservableGraph<DataMaster>::StartBatching() {
+    VERIFY(!batching_);
+    for (Handler* handler_ptr : action_handler_list_) {
+        if (handler_ptr->IsAttached() && handler_ptr->IsBatchable()) {
+            handler_ptr->SetBatched(true);
+            batched_handlers_.push_back(handler_ptr);
+        }
+    }
+    base::RetainDeleted(true);
+    batching_ = true;
+    DEBUG("Batched mode started, " << batched_handlers_.size() << " handlers batched");
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::FlushEvents() {
+    VERIFY(batching_);
+    DEBUG("Delivering " << event_log_.size() << " events to " << batched_handlers_.size() << " handlers");
+    // Handlers detached at the sync point don't get the events
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < batched_handlers_.size(); ++i) {
+        Handler *handler_ptr = batched_handlers_[i];
+        if (handler_ptr->IsAttached())
+            event_log_.Replay(*applier_, *handler_ptr);
+    }
+    event_log_.clear();
+    base::ReclaimDeleted();
+}
+
+template<class DataMaster>
+void ObservableGraph<DataMaster>::StopBatching() {
+    FlushEvents();
+    for (Handler* handler_ptr : batched_handlers_)
+        handler_ptr->SetBatched(false);
+    batched_handlers_.clear();
+    base::RetainDeleted(false);
+    batching_ = false;
+    DEBUG("Batched mode stopped");
+}
+
 template<class DataMaster>
 void ObservableGraph<DataMaster>::FireDeletePath(const std::vector<EdgeId> &edgesToDelete,
                                                  const std::vector<VertexId> &verticesToDelete) const {
@@ -413,6 +528,8 @@ void ObservableGraph<DataMaster>::clear() {
 
 template<class DataMaster>
 ObservableGraph<DataMaster>::~ObservableGraph<DataMaster>() {
+    if (batching_)
+        StopBatching();
     FireGameOver();
     clear();
 }
@@ -513,4 +630,34 @@ typename ObservableGraph<DataMaster>::EdgeId ObservableGraph<DataMaster>::GlueEd
     return new_edge;
 }
 
+/**
+ * Keeps the graph in batched mode while alive, all the recorded events are delivered on destruction.
+ * Does nothing if the graph is already in batched mode.
+ */
+template<class Graph>
+class EventBatch {
+public:
+    EventBatch(Graph &g)
+            : g_(g), started_(!g.batching()) {
+        if (started_)
+            g_.StartBatching();
+    }
+
+    EventBatch(const EventBatch&) = delete;
+    EventBatch& operator=(const EventBatch&) = delete;
+
+    void Flush() {
+        g_.FlushEvents();
+    }
+
+    ~EventBatch() {
+        if (started_)
+            g_.StopBatching();
+    }
+
+private:
+    Graph &g_;
+    bool started_;
+};
+
 } // namespace omnigraph
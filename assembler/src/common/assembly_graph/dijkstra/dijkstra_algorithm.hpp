@@ -7,62 +7,22 @@
 #pragma once
 
 #include "dijkstra_settings.hpp"
+#include "dijkstra_workspace.hpp"
 
 #include "utils/stl_utils.hpp"
 #include "utils/logger/logger.hpp"
 
-#include <parallel_hashmap/phmap.h>
-
-#include <queue>
 #include <vector>
 
 namespace omnigraph {
 
-template<typename Graph, typename distance_t = size_t>
-struct element_t {
-    typedef typename Graph::VertexId VertexId;
-    typedef typename Graph::EdgeId EdgeId;
-
-    distance_t distance;
-    VertexId curr_vertex;
-    VertexId prev_vertex;
-    EdgeId edge_between;
-
-    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
-              EdgeId new_edge_between) noexcept
-            : distance(new_distance),
-              curr_vertex(new_cur_vertex), prev_vertex(new_prev_vertex),
-              edge_between(new_edge_between) { }
-};
-
-template<typename T>
-class ReverseDistanceComparator {
-public:
-    ReverseDistanceComparator() {}
-
-    bool operator()(T obj1, T obj2) const {
-        if (obj1.distance != obj2.distance)
-            return obj2.distance < obj1.distance;
-        if (obj2.curr_vertex != obj1.curr_vertex)
-            return obj2.curr_vertex < obj1.curr_vertex;
-        if (obj2.prev_vertex != obj1.prev_vertex)
-            return obj2.prev_vertex < obj1.prev_vertex;
-        return obj2.edge_between < obj1.edge_between;
-    }
-};
-
 template<class Graph, class DijkstraSettings, typename distance_t = size_t>
 class Dijkstra {
     typedef typename Graph::VertexId VertexId;
     typedef typename Graph::EdgeId EdgeId;
     typedef distance_t DistanceType;
-    using queue_element = element_t<Graph, distance_t>;
-
-    typedef phmap::flat_hash_map<VertexId, distance_t> distances_map;
-    typedef typename distances_map::const_iterator distances_map_ci;
-    typedef typename std::priority_queue<queue_element,
-                                         std::vector<queue_element>,
-                                         ReverseDistanceComparator<queue_element>> queue_t;
+    typedef DijkstraWorkspace<Graph, distance_t> workspace_t;
+    using queue_element = typename workspace_t::queue_element;
     // constructor parameters
     const Graph& graph_;
     DijkstraSettings settings_;
@@ -74,21 +34,24 @@ class Dijkstra {
     size_t vertex_number_;
     bool vertex_limit_exceeded_;
 
-    // accumulative structures
-    distances_map distances_;
-    phmap::flat_hash_set<VertexId> processed_vertices_;
-    phmap::flat_hash_map<VertexId, std::pair<VertexId, EdgeId>> prev_vert_map_;
+    // accumulative structures, borrowed from the thread pool
+    typename workspace_t::Ptr workspace_;
 
-    void Init(VertexId start, queue_t &queue) {
+    void Init(VertexId start) {
         vertex_number_ = 0;
-        distances_.clear();
-        processed_vertices_.clear();
-        prev_vert_map_.clear();
+        workspace_->Clear();
         set_finished(false);
         settings_.Init(start);
-        queue.push(queue_element(0, start, VertexId(), EdgeId()));
+        workspace_->QueuePush(queue_element(0, start, VertexId(), EdgeId()));
         if (collect_traceback_)
-            prev_vert_map_[start] = std::pair<VertexId, EdgeId>(VertexId(), EdgeId());
+            SetTraceback(start, VertexId(), EdgeId());
+    }
+
+    void SetTraceback(VertexId vertex, VertexId prev_vertex, EdgeId edge) {
+        auto &entry = workspace_->Get(vertex);
+        entry.prev_vertex = prev_vertex;
+        entry.edge = edge;
+        entry.traced = true;
     }
 
     void set_finished(bool state) {
@@ -112,7 +75,7 @@ class Dijkstra {
         return settings_.GetLength(edge);
     }
 
-    void AddNeighboursToQueue(VertexId cur_vertex, distance_t cur_dist, queue_t& queue) {
+    void AddNeighboursToQueue(VertexId cur_vertex, distance_t cur_dist) {
         auto neigh_iterator = settings_.GetIterator(cur_vertex);
         while (neigh_iterator.HasNext()) {
             // TRACE("Checking new neighbour of vertex " << graph_.str(cur_vertex) << " started");
@@ -123,7 +86,7 @@ class Dijkstra {
                 // TRACE("Entry: vertex " << graph_.str(cur_vertex) << " distance " << new_dist);
                 if (CheckPutVertex(cur_pair.vertex, cur_pair.edge, new_dist)) {
                     // TRACE("CheckPutVertex returned true and new entry is added");
-                    queue.push(queue_element(new_dist, cur_pair.vertex, cur_vertex, cur_pair.edge));
+                    workspace_->QueuePush(queue_element(new_dist, cur_pair.vertex, cur_vertex, cur_pair.edge));
                 }
             }
             // TRACE("Checking new neighbour of vertex " << graph_.str(cur_vertex) << " finished");
@@ -141,7 +104,8 @@ public:
               collect_traceback_(collect_traceback),
               finished_(false),
               vertex_number_(0),
-              vertex_limit_exceeded_(false) {}
+              vertex_limit_exceeded_(false),
+              workspace_(workspace_t::Borrow()) {}
 
     Dijkstra(Dijkstra&& /*other*/) = default;
     Dijkstra& operator=(Dijkstra&& /*other*/) = default;
@@ -154,37 +118,39 @@ public:
     }
 
     bool DistanceCounted(VertexId vertex) const {
-        return distances_.count(vertex);
+        auto entry = workspace_->Find(vertex);
+        return entry && entry->counted;
     }
 
     distance_t GetDistance(VertexId vertex) const {
-        auto it = distances_.find(vertex);
-        VERIFY(it != distances_.end());
-        return it->second;
+        auto entry = workspace_->Find(vertex);
+        VERIFY(entry && entry->counted);
+        return entry->distance;
     }
 
     void Run(VertexId start) {
         TRACE("Starting dijkstra run from vertex " << graph_.str(start));
-        queue_t queue;
-        Init(start, queue);
+        Init(start);
         TRACE("Priority queue initialized. Starting search");
 
-        while (!queue.empty() && !finished()) {
+        while (!workspace_->QueueEmpty() && !finished()) {
             // TRACE("Dijkstra iteration started");
-            const auto& next = queue.top();
+            const auto& next = workspace_->QueueTop();
             distance_t distance = next.distance;
             VertexId vertex = next.curr_vertex;
 
             if (collect_traceback_)
-                prev_vert_map_[vertex] = std::pair<VertexId, EdgeId>(next.prev_vertex, next.edge_between);
-            queue.pop();
+                SetTraceback(vertex, next.prev_vertex, next.edge_between);
+            workspace_->QueuePop();
             // TRACE("Vertex " << graph_.str(vertex) << " with distance " << distance << " fetched from queue");
 
             if (DistanceCounted(vertex)) {
                 // TRACE("Distance to vertex " << graph_.str(vertex) << " already counted. Proceeding to next queue entry.");
                 continue;
             }
-            distances_.emplace(vertex, distance);
+            auto &entry = workspace_->Get(vertex);
+            entry.distance = distance;
+            entry.counted = true;
 
             // TRACE("Vertex " << graph_.str(vertex) << " is found to be at distance "
             //       << distance << " from vertex " << graph_.str(start));
@@ -192,8 +158,8 @@ public:
                 // TRACE("Check for processing vertex failed. Proceeding to the next queue entry.");
                 continue;
             }
-            processed_vertices_.insert(vertex);
-            AddNeighboursToQueue(vertex, distance, queue);
+            workspace_->MarkProcessed(vertex);
+            AddNeighboursToQueue(vertex, distance);
         }
         set_finished(true);
         // TRACE("Finished dijkstra run from vertex " << graph_.str(start));
@@ -202,12 +168,13 @@ public:
     std::vector<EdgeId> GetShortestPathTo(VertexId vertex) {
         VERIFY_MSG(collect_traceback_, "GetShortestPathTo() is available only if traceback is collected");
         std::vector<EdgeId> path;
-        if (prev_vert_map_.find(vertex) == prev_vert_map_.end())
+        auto entry = workspace_->Find(vertex);
+        if (!entry || !entry->traced)
             return path;
 
         VertexId curr_vertex = vertex;
-        VertexId prev_vertex = utils::get(prev_vert_map_, vertex).first;
-        EdgeId edge = utils::get(prev_vert_map_, curr_vertex).second;
+        VertexId prev_vertex = entry->prev_vertex;
+        EdgeId edge = entry->edge;
 
         while (prev_vertex != VertexId()) {
             if (graph_.EdgeStart(edge) == prev_vertex)
@@ -215,26 +182,48 @@ public:
             else
                 path.push_back(edge);
             curr_vertex = prev_vertex;
-            const auto& prev_v_e = utils::get(prev_vert_map_, curr_vertex);
-            prev_vertex = prev_v_e.first;
-            edge = prev_v_e.second;
+            entry = workspace_->Find(curr_vertex);
+            VERIFY(entry && entry->traced);
+            prev_vertex = entry->prev_vertex;
+            edge = entry->edge;
         }
         return path;
     }
 
     std::vector<VertexId> ReachedVertices() const {
         std::vector<VertexId> result;
-        result.reserve(distances_.size());
+        result.reserve(workspace_->entries().size());
 
-        for (const auto &el : distances_)
-            result.push_back(el.first);
+        for (const auto &entry : workspace_->entries()) {
+            if (entry.counted)
+                result.push_back(entry.vertex);
+        }
         std::sort(result.begin(), result.end());
 
         return result;
     }
 
-    const auto& ProcessedVertices() const {
-        return processed_vertices_;
+    /// Set-like view of processed vertices
+    class ProcessedVerticesView {
+    public:
+        explicit ProcessedVerticesView(const workspace_t &workspace)
+                : workspace_(workspace) {}
+
+        auto begin() const { return workspace_.processed().begin(); }
+        auto end() const { return workspace_.processed().end(); }
+        size_t size() const { return workspace_.processed().size(); }
+
+        size_t count(VertexId vertex) const {
+            auto entry = workspace_.Find(vertex);
+            return entry && entry->processed;
+        }
+
+    private:
+        const workspace_t &workspace_;
+    };
+
+    ProcessedVerticesView ProcessedVertices() const {
+        return ProcessedVerticesView(*workspace_);
     }
 
     bool VertexLimitExceeded() const {
@@ -280,7 +269,7 @@ public:
 private:
   void EnsureFrom(VertexId from) {
     if (!ready_ || prev_ != from) {
-      dijkstra_.run(from);
+      dijkstra_.Run(from);
       ready_ = true;
       prev_ = from;
     }
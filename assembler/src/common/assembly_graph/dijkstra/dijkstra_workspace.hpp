@@ -0,0 +1,265 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace omnigraph {
+
+namespace dijkstra_detail {
+
+// Pools of idle workspaces of all threads and instantiations, so that any thread could release them
+class IdlePoolRegistry {
+public:
+    virtual void Clear() = 0;
+
+    static void ClearAll() {
+        std::lock_guard<std::mutex> guard(Lock());
+        for (IdlePoolRegistry *pool : Pools())
+            pool->Clear();
+    }
+
+protected:
+    IdlePoolRegistry() {
+        std::lock_guard<std::mutex> guard(Lock());
+        Pools().push_back(this);
+    }
+
+    // Must be called by the destructor of the derived pool before its members are destroyed
+    void Unregister() {
+        std::lock_guard<std::mutex> guard(Lock());
+        auto &pools = Pools();
+        pools.erase(std::find(pools.begin(), pools.end(), this));
+    }
+
+    ~IdlePoolRegistry() = default;
+
+private:
+    static std::mutex &Lock() {
+        static std::mutex lock;
+        return lock;
+    }
+
+    static std::vector<IdlePoolRegistry*> &Pools() {
+        static std::vector<IdlePoolRegistry*> pools;
+        return pools;
+    }
+};
+
+}
+
+/**
+ * @brief  Frees idle Dijkstra workspaces kept by all threads. The slot arrays of the workspaces grow
+ *         up to the largest vertex id seen and are never shrunk, so this should be called when
+ *         a stage is over or the graph is gone. Workspaces currently in use are not affected.
+ */
+inline void ReleaseIdleDijkstraWorkspaces() {
+    dijkstra_detail::IdlePoolRegistry::ClearAll();
+}
+
+template<typename Graph, typename distance_t = size_t>
+struct element_t {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    distance_t distance;
+    VertexId curr_vertex;
+    VertexId prev_vertex;
+    EdgeId edge_between;
+
+    element_t(distance_t new_distance, VertexId new_cur_vertex, VertexId new_prev_vertex,
+              EdgeId new_edge_between) noexcept
+            : distance(new_distance),
+              curr_vertex(new_cur_vertex), prev_vertex(new_prev_vertex),
+              edge_between(new_edge_between) { }
+};
+
+template<typename T>
+class ReverseDistanceComparator {
+public:
+    ReverseDistanceComparator() {}
+
+    bool operator()(T obj1, T obj2) const {
+        if (obj1.distance != obj2.distance)
+            return obj2.distance < obj1.distance;
+        if (obj2.curr_vertex != obj1.curr_vertex)
+            return obj2.curr_vertex < obj1.curr_vertex;
+        if (obj2.prev_vertex != obj1.prev_vertex)
+            return obj2.prev_vertex < obj1.prev_vertex;
+        return obj2.edge_between < obj1.edge_between;
+    }
+};
+
+/**
+ * @brief  Storage of a single Dijkstra run: the queue and the state of reached vertices.
+ *         The state is kept in the dense array indexed by vertex id, each slot is stamped by the run
+ *         it belongs to, so clearing is O(1) and no memory is allocated once the workspace is warmed up.
+ *         Workspaces are borrowed from the per-thread pool, so the one is reused by all the searches
+ *         done by the thread one after another. Idle workspaces are freed by ReleaseIdleDijkstraWorkspaces().
+ */
+template<typename Graph, typename distance_t = size_t>
+class DijkstraWorkspace {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+public:
+    typedef element_t<Graph, distance_t> queue_element;
+
+    struct Entry {
+        VertexId vertex;
+        distance_t distance;
+        VertexId prev_vertex;
+        EdgeId edge;
+        bool counted;
+        bool processed;
+        bool traced;
+    };
+
+    class Releaser {
+    public:
+        void operator()(DijkstraWorkspace *workspace) const {
+            DijkstraWorkspace::Release(workspace);
+        }
+    };
+
+    typedef std::unique_ptr<DijkstraWorkspace, Releaser> Ptr;
+
+    /// @returns cleared workspace owned by the caller until the pointer is destroyed
+    static Ptr Borrow() {
+        DijkstraWorkspace *workspace = Idle().Take();
+        if (!workspace)
+            workspace = new DijkstraWorkspace();
+        workspace->Clear();
+        return Ptr(workspace);
+    }
+
+    void Clear() {
+        if (++stamp_ == 0) {
+            // Stamps wrapped around, forget all of them
+            std::fill(slots_.begin(), slots_.end(), Slot());
+            stamp_ = 1;
+        }
+        entries_.clear();
+        processed_.clear();
+        queue_.clear();
+    }
+
+    const Entry *Find(VertexId v) const {
+        size_t id = v.int_id();
+        if (id >= slots_.size() || slots_[id].stamp != stamp_)
+            return nullptr;
+        return &entries_[slots_[id].entry];
+    }
+
+    Entry *Find(VertexId v) {
+        return const_cast<Entry*>(static_cast<const DijkstraWorkspace*>(this)->Find(v));
+    }
+
+    Entry &Get(VertexId v) {
+        if (Entry *entry = Find(v))
+            return *entry;
+
+        size_t id = v.int_id();
+        if (id >= slots_.size())
+            slots_.resize(std::max(id + 1, slots_.size() * 3 / 2));
+        slots_[id] = { stamp_, uint32_t(entries_.size()) };
+        entries_.push_back({ v, distance_t(), VertexId(), EdgeId(), false, false, false });
+        return entries_.back();
+    }
+
+    void MarkProcessed(VertexId v) {
+        Entry &entry = Get(v);
+        if (!entry.processed) {
+            entry.processed = true;
+            processed_.push_back(v);
+        }
+    }
+
+    const std::vector<Entry> &entries() const { return entries_; }
+    const std::vector<VertexId> &processed() const { return processed_; }
+
+    // Binary heap, the order is the same as the one of std::priority_queue
+    bool QueueEmpty() const { return queue_.empty(); }
+    const queue_element &QueueTop() const { return queue_.front(); }
+
+    void QueuePush(const queue_element &element) {
+        queue_.push_back(element);
+        std::push_heap(queue_.begin(), queue_.end(), comparator_);
+    }
+
+    void QueuePop() {
+        std::pop_heap(queue_.begin(), queue_.end(), comparator_);
+        queue_.pop_back();
+    }
+
+private:
+    // Number of idle workspaces kept by each thread
+    static constexpr size_t MAX_IDLE = 4;
+
+    struct Slot {
+        uint32_t stamp = 0;
+        uint32_t entry = 0;
+    };
+
+    // Idle workspaces of a single thread. The lock is only contended by ReleaseIdleDijkstraWorkspaces()
+    class IdlePool : public dijkstra_detail::IdlePoolRegistry {
+    public:
+        ~IdlePool() {
+            Unregister();
+        }
+
+        DijkstraWorkspace *Take() {
+            std::lock_guard<std::mutex> guard(lock_);
+            if (workspaces_.empty())
+                return nullptr;
+            DijkstraWorkspace *workspace = workspaces_.back().release();
+            workspaces_.pop_back();
+            return workspace;
+        }
+
+        void Put(DijkstraWorkspace *workspace) {
+            std::unique_ptr<DijkstraWorkspace> owned(workspace);
+            std::lock_guard<std::mutex> guard(lock_);
+            if (workspaces_.size() < MAX_IDLE)
+                workspaces_.push_back(std::move(owned));
+        }
+
+        void Clear() override {
+            std::vector<std::unique_ptr<DijkstraWorkspace>> released;
+            std::lock_guard<std::mutex> guard(lock_);
+            workspaces_.swap(released);
+        }
+
+    private:
+        std::mutex lock_;
+        std::vector<std::unique_ptr<DijkstraWorkspace>> workspaces_;
+    };
+
+    DijkstraWorkspace()
+            : stamp_(0) {}
+
+    static IdlePool &Idle() {
+        static thread_local IdlePool idle;
+        return idle;
+    }
+
+    static void Release(DijkstraWorkspace *workspace) {
+        Idle().Put(workspace);
+    }
+
+    std::vector<Slot> slots_;
+    uint32_t stamp_;
+    std::vector<Entry> entries_;
+    std::vector<VertexId> processed_;
+    std::vector<queue_element> queue_;
+    ReverseDistanceComparator<queue_element> comparator_;
+};
+
+}
@@ -113,10 +113,20 @@ public:
 };
 
 class UsedUniqueStorage {
+public:
+    typedef std::unordered_map<size_t, std::unordered_set<EdgeId>> PathsUsage;
+
+private:
     std::unordered_set<EdgeId> used_;
-    std::unordered_map<size_t, std::unordered_set<EdgeId>> used_by_paths_; // for fast check 'whether the path contains the edge'
+    PathsUsage used_by_paths_; // for fast check 'whether the path contains the edge'
     const ScaffoldingUniqueEdgeStorage& unique_;
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
+    std::unordered_set<EdgeId> *queried_ = nullptr;
+
+    void Queried(EdgeId e) const {
+        if (queried_)
+            queried_->insert(e);
+    }
 
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
@@ -140,12 +150,19 @@ public:
         used_by_paths_[path_id].insert(g_.conjugate(e));
     }
 
+    /// Makes the storage add every edge it is asked about to 'queried', nullptr stops it
+    void RecordQueries(std::unordered_set<EdgeId> *queried) {
+        queried_ = queried;
+    }
+
     bool IsUsed(EdgeId e, size_t path_id) const {
+        Queried(e);
         auto it = used_by_paths_.find(path_id);
         return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
     }
 
     bool IsUsed(EdgeId e) const {
+        Queried(e);
         return used_.find(e) != used_.end();
     }
 
@@ -161,6 +178,30 @@ public:
         return !unique_.empty();
     }
 
+    const ScaffoldingUniqueEdgeStorage &unique_storage() const {
+        return unique_;
+    }
+
+    /// @returns the edges used by each path, the storage is left empty
+    PathsUsage Release() {
+        PathsUsage res;
+        std::swap(res, used_by_paths_);
+        used_.clear();
+        return res;
+    }
+
+    /// Marks the edges as used by the paths, path ids present in 'ids' are replaced by the mapped ones
+    void Use(const PathsUsage &usage, const std::unordered_map<size_t, size_t> &ids) {
+        for (const auto &entry : usage) {
+            auto it = ids.find(entry.first);
+            auto &path_used = used_by_paths_[it == ids.end() ? entry.first : it->second];
+            for (EdgeId e : entry.second) {
+                used_.insert(e);
+                path_used.insert(e);
+            }
+        }
+    }
+
     bool TryUseEdge(BidirectionalPath &path, EdgeId e, const Gap &gap) {
         if (UniqueCheckEnabled()) {
             if (IsUsedAndUnique(e)) {
@@ -214,6 +214,10 @@ public:
         edges_positions_.erase(e);
     }
 
+    virtual bool IsBatchable() const {
+        return true;
+    }
+
     void clear() {
         edges_positions_.clear();
     }
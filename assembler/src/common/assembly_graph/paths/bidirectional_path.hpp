@@ -502,6 +502,10 @@ public:
         listeners_.push_back(&listener);
     }
 
+    void Unsubscribe(PathListener &listener) {
+        listeners_.erase(std::remove(listeners_.begin(), listeners_.end(), &listener), listeners_.end());
+    }
+
     void SetConjPath(BidirectionalPath* path) noexcept {
         conj_path_ = path;
     }
@@ -0,0 +1,204 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "path_processor.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace omnigraph {
+
+/**
+ * @brief  Sets of lengths of all the walks from the start vertex, which are not longer than the bound.
+ *         Walks go through the vertices reached by the bounded Dijkstra only, as the ones enumerated
+ *         by PathProcessor do, but the lengths to all the vertices are found in a single pass instead of
+ *         enumerating paths for each end vertex. Set of every vertex is kept as a bit vector.
+ *         Both passes go over the lengths in increasing order and keep only the pending (length, vertex)
+ *         entries, bucketed by the length modulo the longest edge, so no other per-length state is stored.
+ *         PathProcessor stops enumerating after MAX_CALL_CNT calls and limits vertex usage after
+ *         VERTEX_USAGE_ENABLE_THRESHOLD ones, so its sets could be truncated. Complete() tells whether
+ *         the enumeration to the vertex stays within the limits, i.e. whether both sets are the same.
+ */
+template<class Graph>
+class BoundedPathLengths {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef uint64_t Word;
+    static const size_t WORD_BITS = 64;
+
+public:
+    BoundedPathLengths(const Graph &g, VertexId start, size_t length_bound,
+                       size_t dijkstra_vertex_limit = PathProcessor<Graph>::MAX_DIJKSTRA_VERTICES)
+            : g_(g), start_(start), length_bound_(length_bound),
+              words_(length_bound / WORD_BITS + 1) {
+        auto dijkstra = DijkstraHelper<Graph>::CreateBoundedDijkstra(g, length_bound, dijkstra_vertex_limit);
+        dijkstra.Run(start);
+        vertices_ = dijkstra.ReachedVertices();
+        ids_.reserve(vertices_.size());
+        std::vector<size_t> distances(vertices_.size());
+        for (size_t i = 0; i < vertices_.size(); ++i) {
+            ids_[vertices_[i]] = i;
+            distances[i] = dijkstra.GetDistance(vertices_[i]);
+        }
+        for (VertexId v : vertices_) {
+            for (EdgeId e : g_.OutgoingEdges(v))
+                buckets_ = std::max(buckets_, std::min(g_.length(e), length_bound_) + 1);
+        }
+        Count();
+        CountWalks(distances);
+    }
+
+    VertexId start() const { return start_; }
+    size_t length_bound() const { return length_bound_; }
+
+    /// Appends lengths of walks to the vertex lying in [min_len, max_len] in increasing order
+    void Lengths(VertexId v, size_t min_len, size_t max_len, std::vector<size_t> &lengths) const {
+        auto it = ids_.find(v);
+        if (it == ids_.end())
+            return;
+        max_len = std::min(max_len, length_bound_);
+        const Word *set = &lengths_[it->second * words_];
+        for (size_t i = min_len / WORD_BITS; i <= max_len / WORD_BITS && i < words_; ++i) {
+            for (Word word = set[i]; word; word &= word - 1) {
+                size_t length = i * WORD_BITS + __builtin_ctzll(word);
+                if (length > max_len)
+                    break;
+                if (length >= min_len)
+                    lengths.push_back(length);
+            }
+        }
+    }
+
+    /// @returns true iff PathProcessor with the same start and bound enumerates walks to the vertex
+    ///          without hitting its limits, so that it finds exactly the lengths returned by Lengths()
+    bool Complete(VertexId v) const {
+        auto it = ids_.find(v);
+        return it == ids_.end() || walk_cnts_[it->second] < WALK_CNT_LIMIT;
+    }
+
+private:
+    // PathProcessor checks the vertex usage only after this number of calls, and both limits are
+    // above it, so the enumeration is complete if it makes fewer calls
+    static const size_t WALK_CNT_LIMIT = PathProcessor<Graph>::VERTEX_USAGE_ENABLE_THRESHOLD;
+
+    // The enumeration to the vertex makes one call per walk ending there from any reached vertex u
+    // with dist(u) + walk length not above the bound. The walks are counted for all the vertices at once
+    // in the order of dist(u) + walk length, the counts saturate at the limit. Counts reaching the same
+    // vertex at the same length are summed up when the length is processed.
+    void CountWalks(const std::vector<size_t> &distances) {
+        typedef std::pair<size_t, uint16_t> Entry;
+        auto add = [](uint16_t &count, size_t value) {
+            count = uint16_t(std::min(WALK_CNT_LIMIT, count + value));
+        };
+
+        // Walks of zero length start at every vertex when its distance is reached
+        size_t n = vertices_.size();
+        std::vector<size_t> order(n);
+        for (size_t id = 0; id < n; ++id)
+            order[id] = id;
+        std::sort(order.begin(), order.end(),
+                  [&](size_t a, size_t b) { return distances[a] < distances[b]; });
+
+        std::vector<std::vector<Entry>> buckets(buckets_);
+        size_t pending = 0;
+        auto next_start = order.begin();
+        walk_cnts_.assign(n, 0);
+        for (size_t len = 0; len <= length_bound_ && (pending || next_start != order.end()); ++len) {
+            std::vector<Entry> &bucket = buckets[len % buckets_];
+            for (; next_start != order.end() && distances[*next_start] == len; ++next_start) {
+                bucket.emplace_back(*next_start, 1);
+                ++pending;
+            }
+            if (bucket.empty())
+                continue;
+
+            std::sort(bucket.begin(), bucket.end(),
+                      [](const Entry &a, const Entry &b) { return a.first < b.first; });
+            pending -= bucket.size();
+            for (size_t i = 0; i < bucket.size(); ) {
+                size_t id = bucket[i].first;
+                uint16_t count = 0;
+                for (; i < bucket.size() && bucket[i].first == id; ++i)
+                    add(count, bucket[i].second);
+
+                add(walk_cnts_[id], count);
+                for (EdgeId e : g_.OutgoingEdges(vertices_[id])) {
+                    size_t next_len = len + g_.length(e);
+                    if (next_len > length_bound_)
+                        continue;
+                    auto it = ids_.find(g_.EdgeEnd(e));
+                    if (it == ids_.end())
+                        continue;
+                    buckets[next_len % buckets_].emplace_back(it->second, count);
+                    ++pending;
+                }
+            }
+            bucket.clear();
+        }
+    }
+
+    // Lengths are found in increasing order, every (length, vertex) pair is queued once, when the length
+    // is added to the set of the vertex. Edge lengths are positive, so the pairs of the current length
+    // are final when it is processed.
+    void Count() {
+        size_t n = vertices_.size();
+        lengths_.assign(n * words_, 0);
+        std::vector<std::vector<size_t>> buckets(buckets_);
+        size_t pending = 1;
+
+        size_t start_id = ids_.at(start_);
+        AddLength(start_id, 0);
+        buckets[0].push_back(start_id);
+        for (size_t len = 0; len <= length_bound_ && pending; ++len) {
+            std::vector<size_t> &bucket = buckets[len % buckets_];
+            pending -= bucket.size();
+            for (size_t id : bucket) {
+                for (EdgeId e : g_.OutgoingEdges(vertices_[id])) {
+                    size_t next_len = len + g_.length(e);
+                    if (next_len > length_bound_)
+                        continue;
+                    auto it = ids_.find(g_.EdgeEnd(e));
+                    if (it == ids_.end() || !AddLength(it->second, next_len))
+                        continue;
+                    buckets[next_len % buckets_].push_back(it->second);
+                    ++pending;
+                }
+            }
+            bucket.clear();
+        }
+    }
+
+    // Adds the length to the set of the vertex, returns true iff it was not there
+    bool AddLength(size_t id, size_t length) {
+        Word &word = lengths_[id * words_ + length / WORD_BITS];
+        Word bit = Word(1) << (length % WORD_BITS);
+        if (word & bit)
+            return false;
+        word |= bit;
+        return true;
+    }
+
+    const Graph &g_;
+    const VertexId start_;
+    const size_t length_bound_;
+    const size_t words_;
+    // Pending lengths are within the longest edge from the current one, so they are kept cyclically
+    size_t buckets_ = 1;
+    std::vector<VertexId> vertices_;
+    phmap::flat_hash_map<VertexId, size_t> ids_;
+    std::vector<Word> lengths_;
+    std::vector<uint16_t> walk_cnts_;
+
+    DECL_LOGGER("BoundedPathLengths");
+};
+
+}
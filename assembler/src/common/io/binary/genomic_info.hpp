@@ -27,6 +27,10 @@ public:
         return value.Load(basename + ext_);
     }
 
+    void Snapshot(const std::string &basename, const GenomicInfo &value, FileImages &images) override {
+        value.BinWrite(images.Add(basename + ext_));
+    }
+
     void Write(io::binary::BinOStream &os, const GenomicInfo &value) {
         os << value;
     }
@@ -80,7 +80,7 @@ private:
                 TryAddVertex(end_ids);
 
                 auto new_id = graph.AddEdge(start_ids[0], end_ids[0],
-                        typename Graph::EdgeData(seq), edge_ids[0], edge_ids[1]);
+                        typename Graph::EdgeData(graph.master().arena().Copy(seq)), edge_ids[0], edge_ids[1]);
                 VERIFY(new_id == edge_ids[0]);
                 VERIFY(graph.conjugate(new_id) == edge_ids[1]);
             }
@@ -17,25 +17,37 @@
 #include "positions.hpp"
 #include "trusted_paths.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace io {
 
 namespace binary {
 
 namespace {
 
+using Jobs = std::vector<std::function<void()>>;
+
 class Saver {
     const std::string &basename;
     const BasePackIO::Type &gp;
-    std::ofstream infoStream;
+    Jobs &jobs;
+    FileImages *images;
+    std::ofstream infoFile;
+    std::ostream &infoStream;
 public:
-    Saver(const std::string &basename, const BasePackIO::Type &gp)
+    Saver(const std::string &basename, const BasePackIO::Type &gp, Jobs &jobs, FileImages *images)
         : basename(basename)
         , gp(gp)
-        , infoStream(basename + ".att")
-    {}
+        , jobs(jobs)
+        , images(images)
+        , infoStream(images ? images->Add(basename + ".att") : infoFile)
+    {
+        if (!images)
+            infoFile.open(basename + ".att");
+    }
 
     /**
-     * @brief  Saves the component only if it was attached.
+     * @brief  Schedules saving of the component only if it was attached.
      *         Also adds its attachment flag to the attached metadata.
      */
     template<class T>
@@ -43,8 +55,13 @@ public:
         const auto &component = gp.get<T>();
         io::binary::BinWrite<char>(infoStream, component.IsAttached());
         if (component.IsAttached()) {
-            typename IOTraits<T>::Type io;
-            io.Save(basename, component); 
+            jobs.emplace_back([basename = basename, &component, images = images] {
+                typename IOTraits<T>::Type io;
+                if (images)
+                    io.Snapshot(basename, component, *images);
+                else
+                    io.Save(basename, component);
+            });
         }
     }
 };
@@ -59,7 +76,7 @@ public:
     {}
 
     /**
-     * @brief  Write the component only if it was attached.
+     * @brief  Writes the component only if it was attached.
      *         Also adds its attachment flag to the attached metadata.
      */
     template<class T>
@@ -68,7 +85,7 @@ public:
         io::binary::BinWrite<char>(os, component.IsAttached());
         if (component.IsAttached()) {
             typename IOTraits<T>::Type io;
-            io.BinWrite(os, component); 
+            io.BinWrite(os, component);
         }
     }
 };
@@ -134,12 +151,18 @@ public:
 };
 
 /**
- * @brief  Saves the component.
+ * @brief  Schedules saving of the component.
  */
 template<typename T>
-void SaveComponent(const std::string &basename, const BasePackIO::Type &gp, const std::string &name = "") {
+void SaveComponent(const std::string &basename, const BasePackIO::Type &gp, Jobs &jobs, FileImages *images,
+                   const std::string &name = "") {
     const auto &component = gp.get<T>(name);
-    io::binary::Save(basename, component);
+    jobs.emplace_back([basename, &component, images] {
+        if (images)
+            io::binary::Snapshot(basename, component, *images);
+        else
+            io::binary::Save(basename, component);
+    });
 }
 
 /**
@@ -169,10 +192,19 @@ void BinReadComponent(std::istream &is, BasePackIO::Type &gp, const std::string
     io::binary::Read(is, component);
 }
 
+/**
+ * @brief  Runs the jobs in parallel. Jobs are independent, so they are just distributed over threads.
+ */
+void RunJobs(const Jobs &jobs) {
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < jobs.size(); ++i)
+        jobs[i]();
+}
+
 } // namespace
 
-void BasePackIO::Save(const std::string &basename, const Type &gp) {
-    Saver saver(basename, gp);
+void BasePackIO::CollectSaves(const std::string &basename, const Type &gp, Jobs &jobs, FileImages *images) {
+    Saver saver(basename, gp, jobs, images);
 
     using namespace omnigraph;
     using namespace debruijn_graph;
@@ -180,7 +212,12 @@ void BasePackIO::Save(const std::string &basename, const Type &gp) {
     if (gp.invalidated<Graph>()) {
         //1. Save basic graph with coverage
         const auto &g = gp.get<Graph>();
-        graph_io_.Save(basename, g);
+        jobs.emplace_back([this, basename, &g, images] {
+            if (images)
+                mapped_graph_io_.Snapshot(basename, g, *images);
+            else
+                mapped_graph_io_.Save(basename, g);
+        });
     }
 
     //2. Save edge positions
@@ -196,15 +233,29 @@ void BasePackIO::Save(const std::string &basename, const Type &gp) {
     saver.Save<FlankingCoverage<Graph>>();
 }
 
+void BasePackIO::Save(const std::string &basename, const Type &gp) {
+    Jobs jobs;
+    BasePackIO::CollectSaves(basename, gp, jobs, nullptr);
+    RunJobs(jobs);
+}
+
+void BasePackIO::Snapshot(const std::string &basename, const Type &gp, FileImages &images) {
+    Jobs jobs;
+    BasePackIO::CollectSaves(basename, gp, jobs, &images);
+    RunJobs(jobs);
+}
+
 bool BasePackIO::Load(const std::string &basename, Type &gp) {
     Loader loader(basename, gp);
 
     using namespace omnigraph;
     using namespace debruijn_graph;
 
-    //1. Load basic graph with coverage
+    //1. Load basic graph with coverage, falling back to the stream layout of older saves.
+    //   The components below are stream-decoded in either case
     auto &g = gp.get_mutable<Graph>();
-    graph_io_.Load(basename, g);
+    if (!mapped_graph_io_.Load(basename, g))
+        graph_io_.Load(basename, g);
 
     //2. Load edge positions
     loader.Load<EdgesPositionHandler<Graph>>();
@@ -267,33 +318,45 @@ bool BasePackIO::BinRead(std::istream &is, Type &gp) {
     return true;
 }
 
-void FullPackIO::Save(const std::string &basename, const Type &gp) {
+void FullPackIO::CollectSaves(const std::string &basename, const Type &gp, Jobs &jobs, FileImages *images) {
     using namespace omnigraph::de;
     using namespace debruijn_graph;
 
     //1. Save basic graph pack
-    base::Save(basename, gp);
+    base::CollectSaves(basename, gp, jobs, images);
 
     //2. Save unclustered paired indices
-    SaveComponent<UnclusteredPairedInfoIndicesT<Graph>>(basename, gp);
+    SaveComponent<UnclusteredPairedInfoIndicesT<Graph>>(basename, gp, jobs, images);
 
     //3. Save clustered indices
-    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_cl", gp, "clustered_indices");
+    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_cl", gp, jobs, images, "clustered_indices");
 
     //4. Save scaffolding indices
-    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_scf", gp, "scaffolding_indices");
+    SaveComponent<PairedInfoIndicesT<Graph>>(basename + "_scf", gp, jobs, images, "scaffolding_indices");
 
     //5. Save long reads
-    SaveComponent<LongReadContainer<Graph>>(basename, gp);
+    SaveComponent<LongReadContainer<Graph>>(basename, gp, jobs, images);
 
     //6. Save genomic info
-    SaveComponent<GenomicInfo>(basename, gp);
+    SaveComponent<GenomicInfo>(basename, gp, jobs, images);
 
     //7. Save SS coverage
-    SaveComponent<SSCoverageContainer>(basename, gp);
+    SaveComponent<SSCoverageContainer>(basename, gp, jobs, images);
 
     //8. Save trusted paths
-    SaveComponent<path_extend::TrustedPathsContainer>(basename, gp);
+    SaveComponent<path_extend::TrustedPathsContainer>(basename, gp, jobs, images);
+}
+
+void FullPackIO::Save(const std::string &basename, const Type &gp) {
+    Jobs jobs;
+    FullPackIO::CollectSaves(basename, gp, jobs, nullptr);
+    RunJobs(jobs);
+}
+
+void FullPackIO::Snapshot(const std::string &basename, const Type &gp, FileImages &images) {
+    Jobs jobs;
+    FullPackIO::CollectSaves(basename, gp, jobs, &images);
+    RunJobs(jobs);
 }
 
 bool FullPackIO::Load(const std::string &basename, Type &gp) {
@@ -336,7 +399,6 @@ void FullPackIO::BinWrite(std::ostream &os, const Type &gp) {
     base::BinWrite(os, gp);
 
     //2. Write unclustered paired indices
-    using namespace omnigraph::de;
     BinWriteComponent<UnclusteredPairedInfoIndicesT<Graph>>(os, gp);
 
     //3. Write clustered indices
@@ -353,6 +415,9 @@ void FullPackIO::BinWrite(std::ostream &os, const Type &gp) {
 
     //7. Write SS coverage
     BinWriteComponent<SSCoverageContainer>(os, gp);
+
+    //8. Write trusted paths
+    BinWriteComponent<path_extend::TrustedPathsContainer>(os, gp);
 }
 
 bool FullPackIO::BinRead(std::istream &is, Type &gp) {
@@ -382,6 +447,9 @@ bool FullPackIO::BinRead(std::istream &is, Type &gp) {
     //7. Read SS coverage
     BinReadComponent<SSCoverageContainer>(is, gp);
 
+    //8. Read trusted paths
+    BinReadComponent<path_extend::TrustedPathsContainer>(is, gp);
+
     return true;
 }
 
@@ -7,14 +7,19 @@
 #pragma once
 
 #include "basic.hpp"
+#include "mapped_graph.hpp"
 #include "pipeline/graph_pack.hpp"
 
+#include <functional>
+
 namespace io {
 
 namespace binary {
 
 /**
  * @brief  This IOer processes the graph pack including only graph-related components.
+ *         The graph with its coverage is saved in the memory-mapped layout (see MappedGraphIO),
+ *         saves having the graph in the stream layout are still loaded.
  */
 class BasePackIO : public IOBase<debruijn_graph::GraphPack> {
 public:
@@ -29,8 +34,21 @@ public:
 
     virtual bool BinRead(std::istream &is, Type &gp);
 
+    /**
+     * @brief  Serializes the components in parallel into the images of the same files Save() writes,
+     *         so the pack could be modified while the images are written.
+     */
+    void Snapshot(const std::string &basename, const Type &gp, FileImages &images) override;
+
 protected:
+    // Components are saved independently, so the collected jobs are run in parallel.
+    // The files are written right away or, if images are given, serialized into them
+    typedef std::vector<std::function<void()>> Jobs;
+
+    void CollectSaves(const std::string &basename, const Type &gp, Jobs &jobs, FileImages *images);
+
     BasicGraphIO<Graph> graph_io_;
+    MappedGraphIO<Graph> mapped_graph_io_;
 };
 
 /**
@@ -47,6 +65,11 @@ public:
     void BinWrite(std::ostream &os, const Type &gp) override;
 
     bool BinRead(std::istream &is, Type &gp) override;
+
+    void Snapshot(const std::string &basename, const Type &gp, FileImages &images) override;
+
+protected:
+    void CollectSaves(const std::string &basename, const Type &gp, Jobs &jobs, FileImages *images);
 };
 
 } // namespace binary
@@ -11,8 +11,11 @@
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_opener.hpp"
 
+#include <deque>
 #include <fstream>
 #include <memory>
+#include <mutex>
+#include <sstream>
 #include <string>
 #include <vector>
 
@@ -20,6 +23,50 @@ namespace io {
 
 namespace binary {
 
+/**
+ * @brief  Contents of saved files kept in memory. Components could be modified as soon as they are
+ *         serialized, the files are written to disk later (e.g. in background).
+ */
+class FileImages {
+public:
+    /**
+     * @brief  Adds an image of the file, could be called concurrently. The stream remains valid
+     *         when other images are added.
+     */
+    std::ostream &Add(const std::string &filename) {
+        std::lock_guard<std::mutex> guard(lock_);
+        images_.emplace_back();
+        images_.back().first = filename;
+        return images_.back().second;
+    }
+
+    /**
+     * @brief  Writes the files, images are released as soon as they are written.
+     */
+    void Write() {
+        for (auto &image : images_) {
+            std::ofstream file(image.first, std::ios::binary);
+            CHECK_FATAL_ERROR(file, "Failed to open " << image.first);
+            if (image.second.tellp() > 0)
+                file << image.second.rdbuf();
+            CHECK_FATAL_ERROR(file, "Failed to write " << image.first);
+            image.second = std::stringstream();
+        }
+        images_.clear();
+    }
+
+    size_t size() {
+        size_t res = 0;
+        for (auto &image : images_)
+            res += image.second.tellp();
+        return res;
+    }
+
+private:
+    std::mutex lock_;
+    std::deque<std::pair<std::string, std::stringstream>> images_;
+};
+
 /**
  * @brief  An interface that can consistently save and load some component T.
  */
@@ -27,6 +74,10 @@ template<typename T>
 struct IOBase {
     virtual void Save(const std::string &basename, const T &value) = 0;
     virtual bool Load(const std::string &basename, T &value) = 0;
+    /**
+     * @brief  Serializes the component into the images of the files Save() writes.
+     */
+    virtual void Snapshot(const std::string &basename, const T &value, FileImages &images) = 0;
     virtual ~IOBase() {}
 };
 
@@ -56,6 +107,16 @@ bool Load(const std::string &basename, T &value) {
     return io.Load(basename, value);
 }
 
+/**
+ * @brief  A convenient template function that serializes a component into file images
+ *         calling an appropriate ComponentIO.
+ */
+template<typename T>
+void Snapshot(const std::string &basename, const T &value, FileImages &images) {
+    typename IOTraits<T>::Type io;
+    io.Snapshot(basename, value, images);
+}
+
 /**
  * @brief  An interface that can consistently (de)serialize some component T using a binary stream wrapper.
  */
@@ -106,6 +167,11 @@ public:
         this->SaveImpl(writer, value);
     }
 
+    void Snapshot(const std::string &basename, const T &value, FileImages &images) override {
+        BinOStream writer(images.Add(basename + this->ext_));
+        this->SaveImpl(writer, value);
+    }
+
     void SaveEmpty(const std::string &basename) {
         std::string filename = basename + this->ext_;
         std::ofstream file(filename, std::ios::binary);
@@ -224,6 +290,12 @@ public:
         return res;
     }
 
+    void Snapshot(const std::string &basename, const T &value, FileImages &images) override {
+        for (size_t i = 0; i < value.size(); ++i) {
+            io_->Snapshot(basename + "_" + std::to_string(i), value[i], images);
+        }
+    }
+
     void Write(BinOStream &stream, const T &value) {
         for (size_t i = 0; i < value.size(); ++i) {
             io_->Write(stream, value[i]);
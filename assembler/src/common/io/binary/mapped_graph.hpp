@@ -0,0 +1,236 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io_base.hpp"
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/construction_helper.hpp"
+#include "io/kmers/mmapped_reader.hpp"
+#include "sequence/sequence.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace io {
+
+namespace binary {
+
+/**
+ * @brief  Saver/loader of the graph with its coverage using the fixed-width layout. On load the file is
+ *         memory-mapped and the graph is restored in parallel, nucleotides of edges are adopted by
+ *         bulk copies instead of decoding them sequence by sequence.
+ *
+ *         The file consists of 64-bit words:
+ *          - header;
+ *          - records of canonical vertices;
+ *          - adjacency: ids of edges outgoing from the vertex followed by the ones outgoing from
+ *            its conjugate, for all vertex records in order;
+ *          - records of canonical edges;
+ *          - packed nucleotides of canonical edges in order.
+ *
+ *         Only the graph itself uses this layout. Other components of the graph pack keep their stream
+ *         formats and are still decoded record by record on load: the edge index (LEB128-encoded values
+ *         and the perfect hash), the kmer mapper (rebuilt by a hash map insertion per k-mer) and the
+ *         flanking coverage (per-edge records).
+ */
+template<typename Graph>
+class MappedGraphIO : public IOBase<Graph> {
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeData EdgeData;
+    typedef typename Graph::VertexData VertexData;
+
+    // "SPGRMAP" + format version, bump on any layout change
+    static constexpr uint64_t MAGIC = 0x0050414d52475053ull;
+    static constexpr uint64_t VERSION = 1;
+    // Number of nucleotides per packed element
+    static constexpr size_t NUCLS_PER_ELEMENT = sizeof(seq_element_type) * 4;
+    // Maximal size of nucleotide slab (in elements) shared by adopted edges. Kept small, since a single
+    // surviving edge keeps its whole slab alive
+    static constexpr uint64_t MAX_SLAB = 1 << 15;
+
+    struct Header {
+        uint64_t magic, version;
+        uint64_t k;
+        uint64_t vreserved, ereserved;
+        uint64_t vertex_cnt, adjacency_size, edge_cnt, nucls_size;
+    };
+
+    struct VertexRecord {
+        uint64_t id, conj;
+        uint64_t adjacency_offset;
+        uint64_t out_cnt, conj_out_cnt;
+    };
+
+    struct EdgeRecord {
+        uint64_t id, conj;
+        uint64_t nucls_offset, nucls_size;
+        uint64_t coverage;
+    };
+
+public:
+    MappedGraphIO()
+            : ext_(".grmap") {}
+
+    void Save(const std::string &basename, const Graph &graph) override {
+        std::string filename = basename + ext_;
+        DEBUG("Saving mapped graph into " << filename);
+        std::ofstream file(filename, std::ios::binary);
+        CHECK_FATAL_ERROR(file, "Failed to open " << filename);
+        SaveImpl(file, graph);
+        CHECK_FATAL_ERROR(file, "Failed to write " << filename);
+    }
+
+    void Snapshot(const std::string &basename, const Graph &graph, FileImages &images) override {
+        SaveImpl(images.Add(basename + ext_), graph);
+    }
+
+    /**
+     * @return false if the file is missing. true if the graph was successfully loaded.
+     *         Fails if the file is present but cannot be read.
+     */
+    bool Load(const std::string &basename, Graph &graph) override {
+        std::string filename = basename + ext_;
+        if (!fs::check_existence(filename))
+            return false;
+
+        DEBUG("Loading mapped graph from " << filename);
+        MMappedReader file(filename, false, -1ULL);
+        const char *data = static_cast<const char*>(file.data());
+
+        Header header;
+        CHECK_FATAL_ERROR(file.size() >= sizeof(header), "Truncated graph file " << filename);
+        memcpy(&header, data, sizeof(header));
+        CHECK_FATAL_ERROR(header.magic == MAGIC && header.version == VERSION,
+                          "Unsupported format of graph file " << filename);
+        CHECK_FATAL_ERROR(header.k == graph.k(), "Cannot read graph, different Ks");
+
+        auto vertices = reinterpret_cast<const VertexRecord*>(data + sizeof(Header));
+        auto adjacency = reinterpret_cast<const uint64_t*>(vertices + header.vertex_cnt);
+        auto edges = reinterpret_cast<const EdgeRecord*>(adjacency + header.adjacency_size);
+        auto nucls = reinterpret_cast<const seq_element_type*>(edges + header.edge_cnt);
+        CHECK_FATAL_ERROR(reinterpret_cast<const char*>(nucls + header.nucls_size) == data + file.size(),
+                          "Truncated graph file " << filename);
+
+        graph.clear();
+        graph.reserve(header.vreserved, header.ereserved);
+        auto helper = graph.GetConstructionHelper();
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.vertex_cnt; ++i) {
+            VertexId v = helper.CreateVertex(VertexData(), vertices[i].id, vertices[i].conj);
+            VERIFY_DEV(v == vertices[i].id);
+        }
+
+        // Consecutive edges share the slab, so their nucleotides are copied at once
+        std::vector<size_t> slabs(1, 0);
+        for (size_t i = 1; i < header.edge_cnt; ++i) {
+            if (edges[i].nucls_offset - edges[slabs.back()].nucls_offset + edges[i].nucls_size / NUCLS_PER_ELEMENT + 1 > MAX_SLAB)
+                slabs.push_back(i);
+        }
+        slabs.push_back(header.edge_cnt);
+
+        NuclArena &arena = graph.master().arena();
+        size_t nslabs = slabs.size() - 1;
+#       pragma omp parallel for schedule(guided)
+        for (size_t s = 0; s < nslabs; ++s) {
+            size_t first = slabs[s], last = slabs[s + 1];
+            if (first == last)
+                continue;
+
+            uint64_t start = edges[first].nucls_offset;
+            uint64_t end = (last < header.edge_cnt ? edges[last].nucls_offset : header.nucls_size);
+            Sequence slab = arena.Adopt(nucls + start, (end - start) * NUCLS_PER_ELEMENT);
+            for (size_t i = first; i < last; ++i) {
+                const EdgeRecord &rec = edges[i];
+                size_t from = (rec.nucls_offset - start) * NUCLS_PER_ELEMENT;
+                EdgeId e = helper.AddEdge(EdgeData(slab.Subseq(from, from + rec.nucls_size)), rec.id, rec.conj);
+                VERIFY(e == rec.id && graph.conjugate(e) == rec.conj);
+
+                graph.coverage_index().SetRawCoverage(e, unsigned(rec.coverage));
+                if (rec.conj != rec.id)
+                    graph.coverage_index().SetRawCoverage(graph.conjugate(e), unsigned(rec.coverage));
+            }
+        }
+
+        // Every vertex is linked by a single thread. Adjacency lists of different vertices are independent
+        // in the default layout, and are modified concurrently safely in the compact one (see CompactAdjacency)
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < header.vertex_cnt; ++i) {
+            const VertexRecord &rec = vertices[i];
+            const uint64_t *out = adjacency + rec.adjacency_offset;
+            for (size_t j = 0; j < rec.out_cnt; ++j)
+                helper.LinkOutgoingEdge(VertexId(rec.id), EdgeId(out[j]));
+            for (size_t j = 0; j < rec.conj_out_cnt; ++j)
+                helper.LinkOutgoingEdge(VertexId(rec.conj), EdgeId(out[rec.out_cnt + j]));
+        }
+
+        return true;
+    }
+
+private:
+    void SaveImpl(std::ostream &file, const Graph &graph) {
+        std::vector<VertexRecord> vertices;
+        std::vector<uint64_t> adjacency;
+        for (VertexId v : graph.canonical_vertices()) {
+            VertexId cv = graph.conjugate(v);
+            VertexRecord rec = { v.int_id(), cv.int_id(), adjacency.size(), 0, 0 };
+            for (EdgeId e : graph.OutgoingEdges(v)) {
+                adjacency.push_back(e.int_id());
+                rec.out_cnt += 1;
+            }
+            if (cv != v) {
+                for (EdgeId e : graph.OutgoingEdges(cv)) {
+                    adjacency.push_back(e.int_id());
+                    rec.conj_out_cnt += 1;
+                }
+            }
+            vertices.push_back(rec);
+        }
+
+        std::vector<EdgeRecord> edges;
+        uint64_t nucls_size = 0;
+        for (EdgeId e : graph.canonical_edges()) {
+            const Sequence &nucls = graph.EdgeNucls(e);
+            edges.push_back({ e.int_id(), graph.conjugate(e).int_id(),
+                              nucls_size, nucls.size(), graph.coverage_index().RawCoverage(e) });
+            nucls_size += nucls.data_size();
+        }
+
+        Header header = { MAGIC, VERSION, graph.k(),
+                          graph.vreserved(), graph.ereserved(),
+                          vertices.size(), adjacency.size(), edges.size(), nucls_size };
+        Write(file, &header, 1);
+        Write(file, vertices.data(), vertices.size());
+        Write(file, adjacency.data(), adjacency.size());
+        Write(file, edges.data(), edges.size());
+
+        std::vector<seq_element_type> buf;
+        for (const EdgeRecord &rec : edges) {
+            const Sequence &nucls = graph.EdgeNucls(EdgeId(rec.id));
+            buf.resize(nucls.data_size());
+            nucls.copy_data(buf.data());
+            Write(file, buf.data(), buf.size());
+        }
+    }
+
+    template<class T>
+    static void Write(std::ostream &os, const T *data, size_t cnt) {
+        os.write(reinterpret_cast<const char*>(data), cnt * sizeof(T));
+    }
+
+    const char *ext_;
+
+    DECL_LOGGER("MappedGraphIO");
+};
+
+} // namespace binary
+
+} // namespace io
@@ -13,6 +13,12 @@ namespace io {
 
 class SequencingLibraryBase;
 
+ReadStreamList<PairedRead> paired_easy_readers(const SequencingLibraryBase &lib,
+                                               bool followed_by_rc,
+                                               size_t insert_size,
+                                               bool use_orientation = true,
+                                               FileReadFlags flags = FileReadFlags(),
+                                               ThreadPool::ThreadPool *pool = nullptr);
 PairedStream paired_easy_reader(const SequencingLibraryBase &lib,
                                 bool followed_by_rc,
                                 size_t insert_size,
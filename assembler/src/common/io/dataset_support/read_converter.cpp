@@ -62,32 +62,42 @@ bool ReadConverter::LoadLibIfExists(SequencingLibraryT& lib) {
 }
 
 void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
-                                    ThreadPool::ThreadPool *pool) {
+                                    ThreadPool::ThreadPool *pool,
+                                    unsigned nthreads) {
     auto& data = lib.data();
     std::ofstream info;
     info.open(data.binary_reads_info.bin_reads_info_file, std::ios_base::out);
     info << "0 0 0";
     info.close();
 
+    // Files are converted concurrently, the rest of threads (if any) are used
+    // for decompression of every file
+    auto read_flags = [nthreads](const auto &files) {
+        size_t nfiles = std::distance(files.begin(), files.end());
+        unsigned decompress_threads = 0;
+        if (nthreads > 1)
+            decompress_threads = unsigned(nthreads / std::max<size_t>(1, std::min<size_t>(nthreads, nfiles)));
+        return FileReadFlags{ PhredOffset, /* use name */ false, /* use quality */ false, /* validate */ false,
+                              decompress_threads };
+    };
+
     INFO("Converting reads to binary format for library #" << data.lib_index << " (takes a while)");
     INFO("Converting paired reads");
     BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix);
-
-    FileReadFlags flags{ PhredOffset, /* use name */ false, /* use quality */ false, /* validate */ false };
-    PairedStream paired_reader = paired_easy_reader(lib, false, 0, false, flags, pool);
-    ReadStreamStat read_stat = paired_converter.ToBinary(paired_reader, lib.orientation(), pool);
+    PairedStreams paired_readers = paired_easy_readers(lib, false, 0, false, read_flags(lib.paired_reads()), pool);
+    ReadStreamStat read_stat = paired_converter.ToBinary(paired_readers, nthreads, lib.orientation(), pool);
     read_stat.read_count *= 2;
 
     INFO("Converting single reads");
     BinaryWriter single_converter(data.binary_reads_info.single_read_prefix);
-    SingleStream single_reader = single_easy_reader(lib, false, false, true, flags, pool);
-    read_stat.merge(single_converter.ToBinary(single_reader, pool));
+    SingleStreams single_readers = single_easy_readers(lib, false, false, true, read_flags(lib.single_reads()), pool);
+    read_stat.merge(single_converter.ToBinary(single_readers, nthreads, pool));
 
     data.unmerged_read_length = read_stat.max_len;
     INFO("Converting merged reads");
     BinaryWriter merged_converter(data.binary_reads_info.merged_read_prefix);
-    SingleStream merged_reader = merged_easy_reader(lib, false, true, flags, pool);
-    auto merged_stats = merged_converter.ToBinary(merged_reader, pool);
+    SingleStreams merged_readers = merged_easy_readers(lib, false, true, read_flags(lib.merged_reads()), pool);
+    auto merged_stats = merged_converter.ToBinary(merged_readers, nthreads, pool);
 
     data.merged_read_length = merged_stats.max_len;
     read_stat.merge(merged_stats);
@@ -140,7 +150,7 @@ void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads) {
 
     for (auto &lib : data) {
         if (!ReadConverter::LoadLibIfExists(lib))
-            ReadConverter::ConvertToBinary(lib, pool.get());
+            ReadConverter::ConvertToBinary(lib, pool.get(), nthreads);
     }
 }
 
@@ -28,39 +28,37 @@ class AsyncReadStream {
     AsyncReadStream<ReadType> &operator>>(ReadType &t) {
         VERIFY(!eof());
 
-        auto wait_writing_buffer = [this]() {
-            // Wait for completion of the write task, if any
-            bool has_more = false;
-            if (write_task_.valid())
-                has_more = write_task_.get();
-
-            // Swap buffers
-            std::swap(read_buffer_, write_buffer_);
-            read_pos_ = 0;
-            write_buffer_.clear();
-
-            // See, if there is still something to read
-            eof_ = (read_buffer_.size() == 0);
-
-            // Submit new job
-            if (has_more) dispatch_write_job();
-        };
-
-        if (start_) {
-            dispatch_write_job();
-            start_ = false;
-            wait_writing_buffer();
-        }
+        if (start_)
+            start();
 
         t = std::move(read_buffer_[read_pos_++]);
 
-        if (read_pos_ == read_buffer_.size()) {
+        if (read_pos_ == read_buffer_.size())
             wait_writing_buffer();
-        }
 
         return *this;
     }
 
+    // Move the whole ranges of the read buffer at once
+    size_t read_batch(std::vector<ReadType> &batch) {
+        if (start_ && !eof_)
+            start();
+
+        size_t n = 0;
+        while (n < batch.size() && !eof_) {
+            size_t cnt = std::min(batch.size() - n, read_buffer_.size() - read_pos_);
+            std::move(read_buffer_.begin() + read_pos_, read_buffer_.begin() + read_pos_ + cnt,
+                      batch.begin() + n);
+            read_pos_ += cnt;
+            n += cnt;
+
+            if (read_pos_ == read_buffer_.size())
+                wait_writing_buffer();
+        }
+
+        return n;
+    }
+
     void close() {
         if (write_task_.valid())
             write_task_.wait();
@@ -91,6 +89,30 @@ class AsyncReadStream {
     }
 
   private:
+    void start() {
+        dispatch_write_job();
+        start_ = false;
+        wait_writing_buffer();
+    }
+
+    void wait_writing_buffer() {
+        // Wait for completion of the write task, if any
+        bool has_more = false;
+        if (write_task_.valid())
+            has_more = write_task_.get();
+
+        // Swap buffers
+        std::swap(read_buffer_, write_buffer_);
+        read_pos_ = 0;
+        write_buffer_.clear();
+
+        // See, if there is still something to read
+        eof_ = (read_buffer_.size() == 0);
+
+        // Submit new job
+        if (has_more) dispatch_write_job();
+    }
+
     void init() {
         read_buffer_.clear();
         write_buffer_.clear();
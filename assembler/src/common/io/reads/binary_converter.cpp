@@ -7,6 +7,7 @@
 #include "binary_converter.hpp"
 
 #include "read_stream.hpp"
+#include "multifile_reader.hpp"
 #include "single_read.hpp"
 #include "paired_read.hpp"
 #include "orientation.hpp"
@@ -15,8 +16,16 @@
 #include "utils/logger/logger.hpp"
 #include "utils/verify.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 #include "threadpool/threadpool.hpp"
 
+#include <atomic>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <sstream>
+
 namespace io {
 
 template<class Read>
@@ -112,6 +121,149 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     return read_stats;
 }
 
+template<class Writer, class Read>
+ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStreamList<Read> &streams,
+                                      unsigned nthreads, ThreadPool::ThreadPool *pool) {
+    if (nthreads <= 1) {
+        auto stream = MultifileWrap<Read>(std::move(streams));
+        return ToBinary(writer, stream, pool);
+    }
+
+    // Reserve space for stats
+    ReadStreamStat read_stats;
+    read_stats.write(*file_ds_);
+
+    // Reads are written in the order of streams, so the result is the same as for the sequential
+    // conversion. Threads take batches of reads from the streams (a single stream is split between
+    // threads as well) and encode them into own buffers. A buffer is appended to the file as soon as
+    // all the preceding batches are written, otherwise it is kept until then. At most max_pending
+    // buffers are kept, after that threads only take batches of the first unfinished stream.
+    struct Batch {
+        std::stringstream data;
+        std::vector<size_t> starts;
+    };
+    typedef std::pair<size_t, size_t> BatchId; // Stream and the index of the batch in it
+
+    std::vector<std::mutex> stream_locks(streams.size());
+    std::vector<size_t> taken(streams.size(), 0); // Guarded by stream locks
+    std::vector<uint8_t> exhausted(streams.size(), false); // Guarded by stream locks
+
+    const size_t max_pending = 4 * nthreads;
+    std::mutex write_lock;
+    std::map<BatchId, Batch> pending; // Guarded by write_lock along with the fields below
+    // Number of batches in the exhausted streams
+    std::vector<size_t> batches(streams.size(), std::numeric_limits<size_t>::max());
+    BatchId next(0, 0);
+    size_t written = 0;
+
+    auto write_batch = [&](const Batch &batch) {
+        auto offset = (size_t)file_ds_->tellp();
+        for (size_t start : batch.starts) {
+            if (written++ % CHUNK == 0) {
+                size_t read_offset = offset + start;
+                offset_ds_->write(reinterpret_cast<const char*>(&read_offset), sizeof(read_offset));
+            }
+        }
+        *file_ds_ << batch.data.rdbuf();
+    };
+
+    // Writes all the kept batches that are next in turn, should be called under write_lock
+    auto write_pending = [&]() {
+        while (true) {
+            while (next.first < streams.size() && next.second == batches[next.first])
+                next = BatchId(next.first + 1, 0);
+
+            auto it = pending.find(next);
+            if (it == pending.end())
+                return;
+            write_batch(it->second);
+            pending.erase(it);
+            next.second += 1;
+        }
+    };
+
+    // Takes the next batch of reads from the stream, should be called under the stream lock
+    std::atomic<size_t> read_count(0);
+    auto take_batch = [&](size_t i, std::vector<Read> &reads) {
+        auto &stream = streams[i];
+        Read read;
+        while (reads.size() < BATCH_SIZE && !stream.eof()) {
+            stream >> read;
+            reads.push_back(read);
+            VERBOSE_POWER(++read_count, " reads processed");
+        }
+
+        if (stream.eof()) {
+            exhausted[i] = true;
+            std::lock_guard<std::mutex> guard(write_lock);
+            batches[i] = taken[i] + !reads.empty();
+            write_pending();
+        }
+        return reads.empty() ? 0 : taken[i]++;
+    };
+
+    std::vector<ReadStreamStat> stats(nthreads);
+
+#   pragma omp parallel num_threads(nthreads)
+    {
+        std::vector<Read> reads;
+        reads.reserve(BATCH_SIZE);
+        auto &stat = stats[omp_get_thread_num()];
+        while (true) {
+            bool ahead;
+            {
+                std::lock_guard<std::mutex> guard(write_lock);
+                ahead = pending.size() < max_pending;
+            }
+
+            // Take the batch from the first stream not read by another thread at the moment. Wait for the
+            // first unfinished stream if there are no such streams or too many batches are kept already.
+            reads.clear();
+            BatchId id;
+            for (bool wait : { false, true }) {
+                if (!wait && !ahead)
+                    continue;
+                for (size_t i = 0; i < streams.size() && reads.empty(); ++i) {
+                    std::unique_lock<std::mutex> lock(stream_locks[i], std::defer_lock);
+                    if (wait)
+                        lock.lock();
+                    else if (!lock.try_lock())
+                        continue;
+                    if (!exhausted[i])
+                        id = BatchId(i, take_batch(i, reads));
+                }
+                if (!reads.empty())
+                    break;
+            }
+            if (reads.empty())
+                break;
+
+            Batch batch;
+            batch.starts.reserve(reads.size());
+            for (const Read &read : reads) {
+                stat.increase(read);
+                batch.starts.push_back((size_t)batch.data.tellp());
+                writer.Write(batch.data, read);
+            }
+
+            std::lock_guard<std::mutex> guard(write_lock);
+            pending.emplace(id, std::move(batch));
+            write_pending();
+        }
+    }
+    VERIFY(pending.empty());
+
+    for (const auto &stat : stats)
+        read_stats.merge(stat);
+
+    // Rewrite the reserved space with actual stats
+    file_ds_->seekp(0);
+    read_stats.write(*file_ds_);
+
+    INFO(written << " reads written");
+    return read_stats;
+}
+
 BinaryWriter::BinaryWriter(const std::string &file_name_prefix)
             : file_name_prefix_(file_name_prefix),
               file_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".seq", std::ios_base::binary)),
@@ -144,4 +296,17 @@ ReadStreamStat BinaryWriter::ToBinary(io::ReadStream<io::PairedRead>& stream,
     return ToBinary(read_writer, stream, pool);
 }
 
+ReadStreamStat BinaryWriter::ToBinary(io::ReadStreamList<io::SingleRead>& streams, unsigned nthreads,
+                                      ThreadPool::ThreadPool *pool) {
+    ReadBinaryWriter<io::SingleRead> read_writer;
+    return ToBinary(read_writer, streams, nthreads, pool);
+}
+
+ReadStreamStat BinaryWriter::ToBinary(io::ReadStreamList<io::PairedRead>& streams, unsigned nthreads,
+                                      LibraryOrientation orientation,
+                                      ThreadPool::ThreadPool *pool) {
+    PairedReadBinaryWriter<io::PairedRead> read_writer(orientation);
+    return ToBinary(read_writer, streams, nthreads, pool);
+}
+
 }
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "read_stream.hpp"
+#include "read_stream_vector.hpp"
 #include "single_read.hpp"
 #include "paired_read.hpp"
 #include "orientation.hpp"
@@ -29,11 +30,16 @@ class BinaryWriter {
     template<class Writer, class Read>
     ReadStreamStat ToBinary(const Writer &writer, io::ReadStream<Read> &stream,
                             ThreadPool::ThreadPool *pool = nullptr);
+    template<class Writer, class Read>
+    ReadStreamStat ToBinary(const Writer &writer, io::ReadStreamList<Read> &streams,
+                            unsigned nthreads, ThreadPool::ThreadPool *pool = nullptr);
 
 public:
     typedef size_t CountType;
     static constexpr size_t CHUNK = 100;
     static constexpr size_t BUF_SIZE = 50000;
+    // Number of reads a thread takes from a stream at once during concurrent conversion
+    static constexpr size_t BATCH_SIZE = 10 * CHUNK;
 
     BinaryWriter(const std::string &file_name_prefix);
 
@@ -49,6 +55,14 @@ public:
     ReadStreamStat ToBinary(io::ReadStream<io::PairedRead>& stream,
                             LibraryOrientation orientation = LibraryOrientation::Undefined,
                             ThreadPool::ThreadPool *pool = nullptr);
+
+    // Convert the streams using nthreads threads, a single stream is split between
+    // threads as well. Reads are written in the order of streams regardless of nthreads.
+    ReadStreamStat ToBinary(io::ReadStreamList<io::SingleRead>& streams, unsigned nthreads,
+                            ThreadPool::ThreadPool *pool = nullptr);
+    ReadStreamStat ToBinary(io::ReadStreamList<io::PairedRead>& streams, unsigned nthreads,
+                            LibraryOrientation orientation = LibraryOrientation::Undefined,
+                            ThreadPool::ThreadPool *pool = nullptr);
 };
 
 }
@@ -13,15 +13,15 @@
 
 namespace io {
 
-bool BinaryFileSingleStream::ReadImpl(SingleReadSeq &read) {
-    return read.BinRead(stream_);
+const char *BinaryFileSingleStream::ReadImpl(const char *buf, SingleReadSeq &read) {
+    return read.BinRead(buf);
 }
 
 BinaryFileSingleStream::BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
         : BinaryFileStream(file_name_prefix, portion_count, portion_num) {}
 
-bool BinaryFilePairedStream::ReadImpl(PairedReadSeq& read) {
-    return read.BinRead(stream_, insert_size_);
+const char *BinaryFilePairedStream::ReadImpl(const char *buf, PairedReadSeq &read) {
+    return read.BinRead(buf, insert_size_);
 }
 
 BinaryFilePairedStream::BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
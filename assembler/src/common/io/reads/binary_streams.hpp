@@ -19,22 +19,67 @@
 
 #include <fstream>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include <cerrno>
+#include <cstring>
+
 namespace io {
 
+/*
+ * Reader of a portion of binary reads file. The portion is memory-mapped once
+ * and reads are decoded directly from the mapping, so repeated passes over the
+ * library (reset()) are served from the page cache without any stream I/O.
+ */
 template<typename SeqT>
 class BinaryFileStream {
 protected:
-    std::ifstream stream_;
-
-    virtual bool ReadImpl(SeqT &read) = 0;
+    virtual const char *ReadImpl(const char *buf, SeqT &read) = 0;
 
 private:
-    size_t offset_, count_, current_;
+    std::string fname_;
+    size_t offset_, end_offset_, count_, current_;
+    char *mapped_;
+    size_t mapped_size_;
+    const char *pos_;
+
+    void Map() {
+        mapped_ = nullptr;
+        mapped_size_ = 0;
+        if (offset_ == end_offset_)
+            return;
+
+        // mmap() offset must be page-aligned
+        size_t page_size = getpagesize();
+        size_t map_offset = offset_ / page_size * page_size;
+        mapped_size_ = end_offset_ - map_offset;
+
+        int fd = ::open(fname_.c_str(), O_RDONLY);
+        if (fd == -1)
+            FATAL_ERROR("open(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << fname_);
+        void *res = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, fd, off_t(map_offset));
+        ::close(fd);
+        if (res == MAP_FAILED)
+            FATAL_ERROR("mmap(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno << ". File: " << fname_);
+        madvise(res, mapped_size_, MADV_SEQUENTIAL);
+
+        mapped_ = static_cast<char*>(res) + (offset_ - map_offset);
+    }
+
+    void Unmap() {
+        if (!mapped_size_)
+            return;
+
+        size_t page_size = getpagesize();
+        munmap(mapped_ - offset_ % page_size, mapped_size_);
+        mapped_ = nullptr;
+        mapped_size_ = 0;
+    }
 
     void Init() {
-        stream_.clear();
-        stream_.seekg(offset_);
-        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
+        pos_ = mapped_;
         current_ = 0;
     }
 
@@ -45,13 +90,14 @@ public:
      * @param portion_count Total number of (roughly equal) portions.
      * @param portion_num Index of the portion (0..portion_count - 1).
      */
-    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num) {
+    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
+            : fname_(file_name_prefix + ".seq") {
         DEBUG("Preparing binary stream #" << portion_num << "/" << portion_count);
         VERIFY(portion_num < portion_count);
-        const std::string fname = file_name_prefix + ".seq";
-        stream_.open(fname, std::ios_base::binary | std::ios_base::in);
+        auto stream = fs::open_file(fname_, std::ios_base::binary | std::ios_base::in);
         ReadStreamStat stat;
-        stat.read(stream_);
+        stat.read(stream);
+        const size_t file_size = fs::filesize(fname_);
 
         const std::string offset_name = file_name_prefix + ".off";
         const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
@@ -73,29 +119,55 @@ public:
         VERIFY_MSG(chunk_num <= chunk_count, "chunk_num " << chunk_num << " chunk_count " << chunk_count << " big_portion_before " << big_portion_before << " big_portion_size " << big_portion_size << " small_portion_size " << small_portion_size << " portion_num " << portion_num);
 
         if (chunk_num < chunk_count) {  // if we start from existing chunk
-            // Calculating the absolute offset in the reads file
+            // Calculating the absolute offsets of the portion in the reads file
+            const bool is_big_portion = portion_num < big_portion_count;
+            const size_t portion_size = is_big_portion ? big_portion_size : small_portion_size;
             auto offset_stream = fs::open_file(offset_name, std::ios_base::binary | std::ios_base::in);
             offset_stream.seekg(chunk_num * sizeof(size_t));
             offset_stream.read(reinterpret_cast<char *>(&offset_), sizeof(offset_));
-            DEBUG("Offset read: " << offset_ << " chunk_count " << chunk_count << " chunk_num " << chunk_num << " portion_count " << portion_count << " portion_num " << portion_num << " prefix " << file_name_prefix << " name " << offset_name);
+            if (chunk_num + portion_size < chunk_count) {
+                offset_stream.seekg((chunk_num + portion_size) * sizeof(size_t));
+                offset_stream.read(reinterpret_cast<char *>(&end_offset_), sizeof(end_offset_));
+            } else {
+                end_offset_ = file_size;
+            }
+            DEBUG("Offsets read: " << offset_ << "-" << end_offset_ << " chunk_count " << chunk_count << " chunk_num " << chunk_num << " portion_count " << portion_count << " portion_num " << portion_num << " prefix " << file_name_prefix << " name " << offset_name);
             VERIFY(offset_stream);
-            const bool is_big_portion = portion_num < big_portion_count;
+            VERIFY_MSG(offset_ <= end_offset_ && end_offset_ <= file_size,
+                       "Invalid offsets " << offset_ << "-" << end_offset_ << " in file of size " << file_size);
             const size_t start_num = chunk_num * BinaryWriter::CHUNK;
             // Last chunk could be incomplete => we should truncate count_ for last portions
-            count_ = std::min(stat.read_count - start_num,
-                              (is_big_portion ? big_portion_size : small_portion_size) * BinaryWriter::CHUNK);
+            count_ = std::min(stat.read_count - start_num, portion_size * BinaryWriter::CHUNK);
 
             DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << offset_);
         } else {  // current portion has size 0 (the case of chunk_count == 0 is also included here)
             // Setup safe offset value
-            offset_ = sizeof(ReadStreamStat);
+            offset_ = end_offset_ = sizeof(ReadStreamStat);
             count_ = 0;
             DEBUG("Empty BinaryFileStream constructed");
         }
 
+        Map();
         Init();
     }
 
+    BinaryFileStream(BinaryFileStream &&other) noexcept
+            : fname_(std::move(other.fname_)),
+              offset_(other.offset_), end_offset_(other.end_offset_),
+              count_(other.count_), current_(other.current_),
+              mapped_(other.mapped_), mapped_size_(other.mapped_size_),
+              pos_(other.pos_) {
+        other.mapped_ = nullptr;
+        other.mapped_size_ = 0;
+    }
+
+    BinaryFileStream(const BinaryFileStream &) = delete;
+    BinaryFileStream &operator=(const BinaryFileStream &) = delete;
+
+    virtual ~BinaryFileStream() {
+        Unmap();
+    }
+
     /**
      * @brief Constructs a reader of all available reads.
      */
@@ -103,14 +175,15 @@ public:
             : BinaryFileStream(file_name_prefix, 1, 0) {}
 
     BinaryFileStream<SeqT>& operator>>(SeqT &read) {
-        ReadImpl(read);
         VERIFY(current_ < count_);
+        pos_ = ReadImpl(pos_, read);
+        VERIFY_DEV(pos_ <= mapped_ + (end_offset_ - offset_));
         ++current_;
         return *this;
     }
 
     bool is_open() {
-        return stream_.is_open();
+        return !fname_.empty();
     }
 
     bool eof() {
@@ -118,8 +191,10 @@ public:
     }
 
     void close() {
-        current_ = 0;
-        stream_.close();
+        current_ = count_ = 0;
+        Unmap();
+        pos_ = nullptr;
+        fname_.clear();
     }
 
     void reset() {
@@ -130,7 +205,7 @@ public:
 
 class BinaryFileSingleStream : public BinaryFileStream<SingleReadSeq>  {
 protected:
-    bool ReadImpl(SingleReadSeq &read) override;
+    const char *ReadImpl(const char *buf, SingleReadSeq &read) override;
 public:
     BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num);
 };
@@ -138,7 +213,7 @@ public:
 class BinaryFilePairedStream: public BinaryFileStream<PairedReadSeq> {
     size_t insert_size_;
 protected:
-    bool ReadImpl(PairedReadSeq& read) override;
+    const char *ReadImpl(const char *buf, PairedReadSeq &read) override;
 public:
     BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
                            size_t portion_count, size_t portion_num);
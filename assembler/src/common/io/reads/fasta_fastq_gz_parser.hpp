@@ -8,6 +8,7 @@
 #pragma once
 
 #include "single_read.hpp"
+#include "gz_reader.hpp"
 
 #include "utils/verify.hpp"
 #include "io/reads/parser.hpp"
@@ -16,7 +17,7 @@
 
 #include "kseq/kseq.h"
 
-#include <zlib.h>
+#include <memory>
 #include <string>
 
 namespace io {
@@ -27,7 +28,7 @@ namespace fastafastqgz {
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 // STEP 1: declare the type of file handler and the read() function
-KSEQ_INIT(gzFile, gzread)
+KSEQ_INIT(GzReader*, gzreader_read)
 #pragma GCC diagnostic pop
 }
 
@@ -41,7 +42,7 @@ public:
      */
     FastaFastqGzParser(const std::string& filename,
                        FileReadFlags flags = FileReadFlags())
-            : Parser(filename, flags), fp_(), seq_(NULL) {
+            : Parser(filename, flags), fp_(nullptr), seq_(NULL) {
         open();
     }
 
@@ -90,7 +91,7 @@ public:
         // STEP 5: destroy seq
         fastafastqgz::kseq_destroy(seq_);
         // STEP 6: close the file handler
-        gzclose(fp_);
+        fp_.reset();
         is_open_ = false;
         eof_ = true;
     }
@@ -99,7 +100,7 @@ private:
     /*
      * @variable File that is associated with gzipped data file.
      */
-    gzFile fp_;
+    std::unique_ptr<GzReader> fp_;
     /*
      * @variable Data element that stores last SingleRead got from
      * stream.
@@ -112,13 +113,14 @@ private:
     /* virtual */
     void open() {
         // STEP 2: open the file handler
-        fp_ = gzopen(filename_.c_str(), "r");
-        if (!fp_) {
+        fp_.reset(new GzReader(filename_, flags_.decompress_threads));
+        if (!fp_->is_open()) {
+            fp_.reset();
             is_open_ = false;
             return;
         }
         // STEP 3: initialize seq
-        seq_ = fastafastqgz::kseq_init(fp_);
+        seq_ = fastafastqgz::kseq_init(fp_.get());
         eof_ = false;
         is_open_ = true;
         ReadAhead();
@@ -6,6 +6,8 @@
 
 #pragma once
 
+#include <algorithm>
+
 namespace io {
 
 /*
@@ -26,15 +28,19 @@ struct FileReadFlags {
     bool use_name     : 1;
     bool use_quality  : 1;
     bool validate     : 1;
+    // Number of threads to decompress input in the background, 0 means
+    // synchronous decompression
+    unsigned decompress_threads : 8;
 
     FileReadFlags()
-            : offset(PhredOffset), use_name(true), use_quality(true), validate(true) {}
+            : offset(PhredOffset), use_name(true), use_quality(true), validate(true), decompress_threads(0) {}
     FileReadFlags(OffsetType o)
-            : offset(o), use_name(true), use_quality(true) {}
+            : offset(o), use_name(true), use_quality(true), decompress_threads(0) {}
     FileReadFlags(OffsetType o, bool n, bool q)
-            : offset(o), use_name(n), use_quality(q) {}
-    FileReadFlags(OffsetType o, bool n, bool q, bool v)
-            : offset(o), use_name(n), use_quality(q), validate(v) {}
+            : offset(o), use_name(n), use_quality(q), decompress_threads(0) {}
+    FileReadFlags(OffsetType o, bool n, bool q, bool v, unsigned t = 0)
+            : offset(o), use_name(n), use_quality(q), validate(v),
+              decompress_threads(static_cast<unsigned char>(std::min(t, 255u))) {}
 
 };
 
@@ -0,0 +1,283 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "gz_reader.hpp"
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace io {
+
+namespace {
+// Size of decompressed chunk passed from the producer
+constexpr size_t CHUNK_SIZE = 4 * 1024 * 1024;
+// Number of BGZF blocks (up to 64 Kb each) inflated in a single batch per thread
+constexpr size_t BLOCKS_PER_THREAD = 16;
+// Upper bound for the number of BGZF blocks in a single batch regardless of the number of threads
+constexpr size_t MAX_BATCH_BLOCKS = 256;
+// Upper bound for the size of decompressed chunks waiting in the queue. A single chunk is
+// always allowed, so the producer could not get stuck on a chunk larger than that
+constexpr size_t MAX_QUEUED_SIZE = 32 * 1024 * 1024;
+// Size of fixed part of gzip header: ID1, ID2, CM, FLG, MTIME, XFL, OS, XLEN
+constexpr size_t GZ_HEADER_SIZE = 12;
+// Size of gzip footer: CRC32, ISIZE
+constexpr size_t GZ_FOOTER_SIZE = 8;
+
+uint16_t get_le16(const unsigned char *p) {
+    return uint16_t(p[0] | (p[1] << 8));
+}
+
+uint32_t get_le32(const unsigned char *p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+// Returns total BGZF block size (BSIZE + 1) or 0 if the header is not a BGZF one
+size_t bgzf_block_size(const unsigned char *header, const unsigned char *extra, size_t xlen) {
+    if (header[0] != 31 || header[1] != 139 || header[2] != 8 || !(header[3] & 4))
+        return 0;
+
+    // Look for 'BC' subfield
+    size_t pos = 0;
+    while (pos + 4 <= xlen) {
+        uint16_t slen = get_le16(extra + pos + 2);
+        if (extra[pos] == 'B' && extra[pos + 1] == 'C' && slen == 2 && pos + 6 <= xlen)
+            return size_t(get_le16(extra + pos + 4)) + 1;
+        pos += 4 + slen;
+    }
+
+    return 0;
+}
+}
+
+GzReader::GzReader(const std::string &filename, unsigned nthreads)
+        : filename_(filename), nthreads_(nthreads),
+          is_open_(false), bgzf_(false),
+          gz_(nullptr), raw_(nullptr),
+          queued_size_(0), stop_(false), pos_(0), eof_(false) {
+    if (nthreads_) {
+        // Check whether we're having BGZF file
+        raw_ = fopen(filename_.c_str(), "rb");
+        if (!raw_)
+            return;
+
+        unsigned char header[GZ_HEADER_SIZE];
+        if (fread(header, 1, GZ_HEADER_SIZE, raw_) == GZ_HEADER_SIZE &&
+            header[0] == 31 && header[1] == 139 && (header[3] & 4)) {
+            size_t xlen = get_le16(header + 10);
+            std::vector<unsigned char> extra(xlen);
+            bgzf_ = (fread(extra.data(), 1, xlen, raw_) == xlen &&
+                     bgzf_block_size(header, extra.data(), xlen) > 0);
+        }
+
+        if (bgzf_) {
+            rewind(raw_);
+        } else {
+            fclose(raw_);
+            raw_ = nullptr;
+        }
+    }
+
+    if (!bgzf_) {
+        gz_ = gzopen(filename_.c_str(), "r");
+        if (!gz_)
+            return;
+        gzbuffer(gz_, 1 << 20);
+    }
+
+    is_open_ = true;
+}
+
+GzReader::~GzReader() {
+    if (producer_.joinable()) {
+        {
+            std::lock_guard<std::mutex> guard(lock_);
+            stop_ = true;
+        }
+        not_full_.notify_all();
+        producer_.join();
+    }
+
+    if (gz_)
+        gzclose(gz_);
+    if (raw_)
+        fclose(raw_);
+}
+
+int GzReader::read(void *buf, unsigned len) {
+    if (!nthreads_)
+        return gzread(gz_, buf, len);
+
+    // Start decompression lazily, so opened but not yet consumed files (e.g.
+    // the tail of multi-file stream) do not hold decompressed chunks
+    if (!producer_.joinable())
+        producer_ = std::thread(&GzReader::Producer, this);
+
+    char *out = static_cast<char*>(buf);
+    size_t read = 0;
+    while (read < len && !eof_) {
+        if (pos_ == current_.size()) {
+            std::unique_lock<std::mutex> guard(lock_);
+            not_empty_.wait(guard, [this] { return !queue_.empty(); });
+            current_ = std::move(queue_.front());
+            queue_.pop_front();
+            queued_size_ -= current_.size();
+            guard.unlock();
+            not_full_.notify_one();
+
+            pos_ = 0;
+            // Empty chunk marks the end of data
+            eof_ = current_.empty();
+            continue;
+        }
+
+        size_t cnt = std::min(len - read, current_.size() - pos_);
+        memcpy(out + read, current_.data() + pos_, cnt);
+        read += cnt;
+        pos_ += cnt;
+    }
+
+    return int(read);
+}
+
+bool GzReader::Push(Chunk chunk) {
+    std::unique_lock<std::mutex> guard(lock_);
+    // Bound the memory held by decompressed data independently of the number of threads
+    not_full_.wait(guard, [this, &chunk] {
+        return stop_ || queue_.empty() || queued_size_ + chunk.size() <= MAX_QUEUED_SIZE;
+    });
+    if (stop_)
+        return false;
+
+    queued_size_ += chunk.size();
+    queue_.push_back(std::move(chunk));
+    guard.unlock();
+    not_empty_.notify_one();
+    return true;
+}
+
+void GzReader::Producer() {
+    if (bgzf_)
+        ProduceBGZF();
+    else
+        ProduceGz();
+
+    // Signal EOF
+    Push(Chunk());
+}
+
+void GzReader::ProduceGz() {
+    while (true) {
+        Chunk chunk(CHUNK_SIZE);
+        int res = gzread(gz_, chunk.data(), unsigned(chunk.size()));
+        if (res < 0) {
+            int err;
+            FATAL_ERROR("Error decompressing file " << filename_ << ": " << gzerror(gz_, &err));
+        }
+        if (res == 0)
+            return;
+
+        chunk.resize(size_t(res));
+        if (!Push(std::move(chunk)))
+            return;
+    }
+}
+
+bool GzReader::ReadBGZFBlock(Chunk &block) {
+    block.resize(GZ_HEADER_SIZE);
+    size_t res = fread(block.data(), 1, GZ_HEADER_SIZE, raw_);
+    if (res == 0 && feof(raw_))
+        return false;
+    if (res != GZ_HEADER_SIZE)
+        FATAL_ERROR("Truncated BGZF block header in file " << filename_);
+
+    size_t xlen = get_le16(reinterpret_cast<unsigned char*>(block.data()) + 10);
+    block.resize(GZ_HEADER_SIZE + xlen);
+    if (fread(block.data() + GZ_HEADER_SIZE, 1, xlen, raw_) != xlen)
+        FATAL_ERROR("Truncated BGZF block header in file " << filename_);
+
+    auto *header = reinterpret_cast<unsigned char*>(block.data());
+    size_t bsize = bgzf_block_size(header, header + GZ_HEADER_SIZE, xlen);
+    if (bsize < GZ_HEADER_SIZE + xlen + GZ_FOOTER_SIZE)
+        FATAL_ERROR("Invalid BGZF block in file " << filename_ << ". Mixed BGZF and plain gzip members are not supported");
+
+    size_t rest = bsize - GZ_HEADER_SIZE - xlen;
+    block.resize(bsize);
+    if (fread(block.data() + GZ_HEADER_SIZE + xlen, 1, rest, raw_) != rest)
+        FATAL_ERROR("Truncated BGZF block in file " << filename_);
+
+    return true;
+}
+
+void GzReader::InflateBGZFBlock(const Chunk &block, char *out, size_t out_size) const {
+    // Empty blocks (e.g. the EOF marker) have nothing to inflate, out may be null for them
+    if (!out_size)
+        return;
+
+    auto *data = reinterpret_cast<const unsigned char*>(block.data());
+    size_t xlen = get_le16(data + 10);
+    size_t cdata_size = block.size() - GZ_HEADER_SIZE - xlen - GZ_FOOTER_SIZE;
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -15) != Z_OK)
+        FATAL_ERROR("Cannot initialize zlib inflate stream");
+
+    zs.next_in = const_cast<unsigned char*>(data + GZ_HEADER_SIZE + xlen);
+    zs.avail_in = uInt(cdata_size);
+    zs.next_out = reinterpret_cast<unsigned char*>(out);
+    zs.avail_out = uInt(out_size);
+    int res = inflate(&zs, Z_FINISH);
+    inflateEnd(&zs);
+
+    if (res != Z_STREAM_END || zs.total_out != out_size)
+        FATAL_ERROR("Error decompressing BGZF block in file " << filename_);
+
+    uint32_t crc = uint32_t(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<unsigned char*>(out), uInt(out_size)));
+    if (crc != get_le32(data + block.size() - GZ_FOOTER_SIZE))
+        FATAL_ERROR("CRC mismatch in BGZF block in file " << filename_);
+}
+
+void GzReader::ProduceBGZF() {
+    std::vector<Chunk> blocks(std::min(nthreads_ * BLOCKS_PER_THREAD, MAX_BATCH_BLOCKS));
+    std::vector<size_t> offsets(blocks.size() + 1);
+
+    bool more = true;
+    while (more) {
+        // Read the batch of compressed blocks sequentially...
+        size_t n = 0;
+        for (; n < blocks.size(); ++n) {
+            if (!ReadBGZFBlock(blocks[n])) {
+                more = false;
+                break;
+            }
+        }
+        if (n == 0)
+            return;
+
+        // ... and inflate them in parallel into one contiguous chunk
+        for (size_t i = 0; i < n; ++i) {
+            const auto &block = blocks[i];
+            auto *footer = reinterpret_cast<const unsigned char*>(block.data() + block.size() - GZ_FOOTER_SIZE);
+            offsets[i + 1] = offsets[i] + get_le32(footer + 4);
+        }
+        // The batch may consist of the EOF marker block only
+        if (!offsets[n])
+            continue;
+
+        Chunk chunk(offsets[n]);
+#       pragma omp parallel for num_threads(nthreads_) schedule(dynamic)
+        for (size_t i = 0; i < n; ++i)
+            InflateBGZFBlock(blocks[i], chunk.data() + offsets[i], offsets[i + 1] - offsets[i]);
+
+        if (!Push(std::move(chunk)))
+            return;
+    }
+}
+
+}
@@ -0,0 +1,84 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/logger/logger.hpp"
+
+#include <zlib.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdio>
+
+namespace io {
+
+/*
+ * Reader of (possibly) gzip-compressed data. In synchronous mode it is a thin
+ * wrapper over gzread(). Otherwise decompression is performed by a background
+ * thread that feeds a bounded queue of decompressed chunks:
+ *  - BGZF blocks (as produced by bgzip) are inflated in parallel by
+ *    nthreads threads;
+ *  - plain gzip (and uncompressed) files are inflated by a single background
+ *    thread, so inflation is pipelined with record parsing.
+ */
+class GzReader {
+  public:
+    GzReader(const std::string &filename, unsigned nthreads = 0);
+    ~GzReader();
+
+    bool is_open() const { return is_open_; }
+    bool is_bgzf() const { return bgzf_; }
+
+    // Returns the number of bytes read, 0 on EOF
+    int read(void *buf, unsigned len);
+
+  private:
+    typedef std::vector<char> Chunk;
+
+    void Producer();
+    void ProduceGz();
+    void ProduceBGZF();
+    bool ReadBGZFBlock(Chunk &block);
+    void InflateBGZFBlock(const Chunk &block, char *out, size_t out_size) const;
+    // Returns false if the reader was stopped
+    bool Push(Chunk chunk);
+
+    std::string filename_;
+    unsigned nthreads_;
+    bool is_open_;
+    bool bgzf_;
+
+    // Synchronous mode / plain gzip producer
+    gzFile gz_;
+    // BGZF producer
+    FILE *raw_;
+
+    std::thread producer_;
+    std::mutex lock_;
+    std::condition_variable not_empty_, not_full_;
+    std::deque<Chunk> queue_;
+    // Total size of chunks in the queue
+    size_t queued_size_;
+    bool stop_;
+
+    // Chunk being consumed
+    Chunk current_;
+    size_t pos_;
+    bool eof_;
+
+    DECL_LOGGER("GzReader");
+};
+
+inline int gzreader_read(GzReader *reader, void *buf, unsigned len) {
+    return reader->read(buf, len);
+}
+
+}
@@ -97,6 +97,14 @@ public:
         return !file.fail();
     }
 
+    const char *BinRead(const char *buf, size_t estimated_is) {
+        buf = first_.BinRead(buf);
+        buf = second_.BinRead(buf);
+
+        insert_size_ = estimated_is;
+        return buf;
+    }
+
     bool BinWrite(std::ostream &file, bool rc1 = false, bool rc2 = false) const {
         first_.BinWrite(file, rc1);
         second_.BinWrite(file, rc2);
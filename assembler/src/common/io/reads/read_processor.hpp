@@ -9,9 +9,12 @@
 #define __HAMMER_READ_PROCESSOR_HPP__
 
 #include "io/reads/mpmc_bounded.hpp"
+#include "io/reads/read_stream.hpp"
 #include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
 
 #include <memory>
+#include <vector>
 #include <sched.h>
 
 #pragma GCC diagnostic push
@@ -22,6 +25,8 @@ namespace hammer {
 class ReadProcessor {
     static size_t constexpr cacheline_size = 64;
     typedef char cacheline_pad_t[cacheline_size];
+    // Number of reads passed between the reader and processing threads at once
+    static size_t constexpr block_size = 128;
 
     unsigned nthreads_;
     cacheline_pad_t pad0;
@@ -30,18 +35,87 @@ class ReadProcessor {
     size_t processed_;
     cacheline_pad_t pad2;
 
+    // Operations taking the read by reference are called directly on the
+    // elements of the block. Operations that want to take the ownership of
+    // the read are provided with the heap-allocated copy.
+    template<class Op, class ReadT>
+    static auto Apply(Op &op, ReadT &r, int) -> decltype(op(r)) {
+        return op(r);
+    }
+
+    template<class Op, class ReadT>
+    static auto Apply(Op &op, ReadT &r, long) -> decltype(op(std::unique_ptr<ReadT>())) {
+        return op(std::unique_ptr<ReadT>(new ReadT(std::move(r))));
+    }
+
+    template<class Op, class ReadT>
+    static auto Apply(Op &op, ReadT &r) -> decltype(Apply(op, r, 0)) {
+        return Apply(op, r, 0);
+    }
+
+    // Set of reusable read blocks. Ids of free blocks are kept in the queue.
+    template<class ReadT>
+    class BlockPool {
+      public:
+        BlockPool(size_t num_blocks)
+                : blocks_(num_blocks, std::vector<ReadT>(block_size)),
+                  sizes_(num_blocks, 0),
+                  free_(num_blocks) {
+            for (size_t i = 0; i < num_blocks; ++i)
+                free_.enqueue(i);
+        }
+
+        size_t acquire() {
+            size_t id;
+            while (!free_.dequeue(id))
+                sched_yield();
+            return id;
+        }
+
+        void release(size_t id) {
+            // Queue is large enough to keep all the blocks
+            while (!free_.enqueue(id))
+                sched_yield();
+        }
+
+        template<class Reader>
+        size_t fill(size_t id, Reader &irs) {
+            return sizes_[id] = io::read_batch(irs, blocks_[id]);
+        }
+
+        std::vector<ReadT> &block(size_t id) { return blocks_[id]; }
+        size_t size(size_t id) const { return sizes_[id]; }
+
+      private:
+        std::vector<std::vector<ReadT>> blocks_;
+        std::vector<size_t> sizes_;
+        mpmc_bounded_queue<size_t> free_;
+    };
+
+    static unsigned QueueSize(unsigned nthreads) {
+        // Round nthreads to next power of two
+        unsigned bufsize = nthreads - 1;
+        bufsize = (bufsize >> 1) | bufsize;
+        bufsize = (bufsize >> 2) | bufsize;
+        bufsize = (bufsize >> 4) | bufsize;
+        bufsize = (bufsize >> 8) | bufsize;
+        bufsize = (bufsize >> 16) | bufsize;
+        bufsize += 1;
+
+        return bufsize;
+    }
+
 private:
     template<class Reader, class Op>
     bool RunSingle(Reader &irs, Op &op) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        typename Reader::ReadT r;
 
         while (!irs.eof()) {
-            ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-            irs >> *r;
+            irs >> r;
             read_ += 1;
 
             processed_ += 1;
-            if (op(std::move(r))) // Pass ownership of read down to processor
+            if (Apply(op, r))
                 return true;
         }
 
@@ -50,14 +124,13 @@ private:
 
     template<class Reader, class Op, class Writer>
     void RunSingle(Reader &irs, Op &op, Writer &writer) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        typename Reader::ReadT r;
 
         while (!irs.eof()) {
-            ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-            irs >> *r;
+            irs >> r;
             read_ += 1;
 
-            auto res = op(std::move(r)); // Pass ownership of read down to processor
+            auto res = Apply(op, r);
             processed_ += 1;
 
             if (res)
@@ -75,34 +148,27 @@ public:
 
     template<class Reader, class Op>
     bool Run(Reader &irs, Op &op) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        using ReadT = typename Reader::ReadT;
 
         if (nthreads_ < 2)
             return RunSingle(irs, op);
 
-        // Round nthreads to next power of two
-        unsigned bufsize = nthreads_ - 1;
-        bufsize = (bufsize >> 1) | bufsize;
-        bufsize = (bufsize >> 2) | bufsize;
-        bufsize = (bufsize >> 4) | bufsize;
-        bufsize = (bufsize >> 8) | bufsize;
-        bufsize = (bufsize >> 16) | bufsize;
-        bufsize += 1;
-
-        mpmc_bounded_queue<ReadPtr> in_queue(2 * bufsize);
+        unsigned bufsize = QueueSize(nthreads_);
+        BlockPool<ReadT> blocks(2 * bufsize);
+        mpmc_bounded_queue<size_t> in_queue(2 * bufsize);
 
         bool stop = false;
-#   pragma omp parallel shared(in_queue, irs, op, stop) num_threads(nthreads_)
+#   pragma omp parallel shared(in_queue, blocks, irs, op, stop) num_threads(nthreads_)
         {
 #     pragma omp master
             {
                 while (!irs.eof()) {
-                    ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-                    irs >> *r;
+                    size_t id = blocks.acquire();
+                    size_t cnt = blocks.fill(id, irs);
 #         pragma omp atomic
-                    read_ += 1;
+                    read_ += cnt;
 
-                    while (!in_queue.enqueue(std::move(r)))
+                    while (!in_queue.enqueue(id))
                         sched_yield();
 
 #         pragma omp flush (stop)
@@ -114,15 +180,21 @@ public:
             }
 
             while (1) {
-                ReadPtr r;
+                size_t id;
 
-                if (!in_queue.wait_dequeue(r))
+                if (!in_queue.wait_dequeue(id))
                     break;
 
+                auto &block = blocks.block(id);
+                size_t cnt = blocks.size(id);
+                bool res = false;
+                for (size_t i = 0; i < cnt; ++i)
+                    res |= Apply(op, block[i]);
+                blocks.release(id);
+
 #       pragma omp atomic
-                processed_ += 1;
+                processed_ += cnt;
 
-                bool res = op(std::move(r));
                 if (res) {
 #         pragma omp atomic
                     stop |= res;
@@ -136,69 +208,74 @@ public:
 
     template<class Reader, class Op, class Writer>
     void Run(Reader &irs, Op &op, Writer &writer) {
-        using ReadPtr = std::unique_ptr<typename Reader::ReadT>;
+        using ReadT = typename Reader::ReadT;
 
         if (nthreads_ < 2) {
             RunSingle(irs, op, writer);
             return;
         }
 
-        // Round nthreads to next power of two
-        unsigned bufsize = nthreads_ - 1;
-        bufsize = (bufsize >> 1) | bufsize;
-        bufsize = (bufsize >> 2) | bufsize;
-        bufsize = (bufsize >> 4) | bufsize;
-        bufsize = (bufsize >> 8) | bufsize;
-        bufsize = (bufsize >> 16) | bufsize;
-        bufsize += 1;
+        using ResultPtr = decltype(Apply(op, std::declval<ReadT&>()));
 
-        mpmc_bounded_queue<ReadPtr> in_queue(bufsize), out_queue(2 * bufsize);
-#   pragma omp parallel shared(in_queue, out_queue, irs, op, writer) num_threads(nthreads_)
+        unsigned bufsize = QueueSize(nthreads_);
+        BlockPool<ReadT> blocks(2 * bufsize);
+        mpmc_bounded_queue<size_t> in_queue(2 * bufsize);
+        mpmc_bounded_queue<ResultPtr> out_queue(2 * bufsize * block_size);
+#   pragma omp parallel shared(in_queue, out_queue, blocks, irs, op, writer) num_threads(nthreads_)
         {
 #     pragma omp master
             {
                 while (!irs.eof()) {
-                    ReadPtr r = ReadPtr(new typename Reader::ReadT) ;
-                    irs >> *r;
+                    size_t id = blocks.acquire();
+                    size_t cnt = blocks.fill(id, irs);
+                    read_ += cnt;
 
-                    // First, try to provide read to the queue. If it's full, never mind.
-                    bool status = in_queue.enqueue(std::move(r));
+                    // First, try to provide block to the queue. If it's full, never mind.
+                    bool status = in_queue.enqueue(id);
 
                     // Flush down the output queue
-                    ReadPtr outr;
+                    ResultPtr outr;
                     while (out_queue.dequeue(outr))
                         writer << *outr;
 
                     // If the input queue was originally full, wait until we can insert
-                    // the read once again.
+                    // the block once again.
                     if (!status)
-                        while (!in_queue.enqueue(std::move(r)))
+                        while (!in_queue.enqueue(id))
                             sched_yield();
                 }
 
                 in_queue.close();
 
                 // Flush down the output queue while in master threads.
-                ReadPtr outr;
+                ResultPtr outr;
                 while (out_queue.dequeue(outr))
                     writer << *outr;
             }
 
             while (1) {
-                ReadPtr r;
+                size_t id;
 
-                if (!in_queue.wait_dequeue(r))
+                if (!in_queue.wait_dequeue(id))
                     break;
 
-                auto res = op(std::move(r));
-                if (res)
-                    while (!out_queue.enqueue(std::move(res)))
-                        sched_yield();
+                auto &block = blocks.block(id);
+                size_t cnt = blocks.size(id);
+                for (size_t i = 0; i < cnt; ++i) {
+                    auto res = Apply(op, block[i]);
+                    if (res)
+                        while (!out_queue.enqueue(std::move(res)))
+                            sched_yield();
+                }
+                blocks.release(id);
+
+#       pragma omp atomic
+                processed_ += cnt;
             }
         }
 
         // Flush down the output queue
-        ReadPtr outr;
+        ResultPtr outr;
         while (out_queue.dequeue(outr))
             writer << *outr;
     }
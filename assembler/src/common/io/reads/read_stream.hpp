@@ -13,9 +13,37 @@
 #include <memory>
 #include <typeinfo>
 #include <typeindex>
+#include <vector>
 
 namespace io {
 
+namespace impl {
+template<class Stream, class ReadType>
+auto read_batch(Stream &stream, std::vector<ReadType> &batch, int) -> decltype(stream.read_batch(batch)) {
+    return stream.read_batch(batch);
+}
+
+template<class Stream, class ReadType>
+size_t read_batch(Stream &stream, std::vector<ReadType> &batch, long) {
+    size_t n = 0;
+    for (; n < batch.size() && !stream.eof(); ++n)
+        stream >> batch[n];
+
+    return n;
+}
+}
+
+/*
+ * Read up to batch.size() reads into the batch reusing its elements. Streams
+ * might provide a faster read_batch() member, otherwise the reads are read one
+ * by one.
+ * @return The number of reads read.
+ */
+template<class Stream, class ReadType>
+size_t read_batch(Stream &stream, std::vector<ReadType> &batch) {
+    return impl::read_batch(stream, batch, 0);
+}
+
 struct ReadStreamStat {
     size_t read_count;
     size_t max_len;
@@ -73,6 +101,7 @@ struct ReadStream {
   bool is_open() const { return self_->is_open(); }
   bool eof() const { return self_->eof(); }
   ReadStream& operator>>(ReadType& read) { (*self_) >> read; return *this; }
+  size_t read_batch(std::vector<ReadType> &batch) { return self_->read_batch(batch); }
   void close() { self_->close(); }
   void reset() { self_->reset(); }
 
@@ -110,6 +139,12 @@ struct ReadStream {
      */
     virtual ReadStreamConcept& operator>>(ReadType& read) = 0;
 
+    /*
+     * Read up to batch.size() reads into the batch.
+     * @return The number of reads read.
+     */
+    virtual size_t read_batch(std::vector<ReadType> &batch) = 0;
+
     /* Close the stream */
     virtual void close() = 0;
 
@@ -128,6 +163,7 @@ struct ReadStream {
     bool is_open() { return self_.is_open(); }
     bool eof() { return self_.eof(); }
     ReadStreamModel& operator>>(ReadType& read) { self_ >> read; return *this; }
+    size_t read_batch(std::vector<ReadType> &batch) { return io::read_batch(self_, batch); }
     void close() { self_.close(); }
     void reset() { self_.reset(); }
     const std::type_info &type_info() const { return typeid(T); }
@@ -17,6 +17,7 @@
 #include "utils/logger/logger.hpp"
 
 #include <string>
+#include <cstring>
 
 namespace io {
 
@@ -283,6 +284,14 @@ public:
         return !file.fail();
     }
 
+    const char *BinRead(const char *buf) {
+        buf = seq_.BinRead(buf);
+        memcpy(&left_offset_, buf, sizeof(left_offset_));
+        buf += sizeof(left_offset_);
+        memcpy(&right_offset_, buf, sizeof(right_offset_));
+        return buf + sizeof(right_offset_);
+    }
+
     bool BinWrite(std::ostream &file, bool rc = false) const {
         if (rc)
             (!seq_).BinWrite(file);
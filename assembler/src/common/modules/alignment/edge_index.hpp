@@ -7,12 +7,15 @@
 
 #pragma once
 
+#include <array>
 #include <limits>
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/action_handlers.hpp"
 #include "assembly_graph/index/edge_info_updater.hpp"
 #include "edge_index_refiller.hpp"
 
+#include <boost/optional.hpp>
+
 
 namespace io { namespace binary {
 template<class Graph>
@@ -34,6 +37,8 @@ class EdgeIndex: public omnigraph::GraphActionHandler<Graph> {
 public:
     typedef RtSeq KMer;
     static constexpr size_t NOT_FOUND = size_t(-1);
+    // Maximal number of k-mers looked up together by batched get()
+    static constexpr size_t LOOKUP_BATCH = 16;
 
 private:
     bool large_index_;
@@ -43,16 +48,39 @@ private:
     EdgeIndexRefiller refiller_;
 
     template<class Index>
-    std::pair<EdgeId, size_t> get(const Index *index, const KMer& kmer) const {
-        auto kwh = index->ConstructKWH(kmer);
+    std::pair<EdgeId, size_t> get(const Index *index, const typename Index::KeyWithHash &kwh) const {
         if (index->contains(kwh)) {
             auto entry = index->get_value(kwh);
             return { entry.edge(), (size_t)entry.offset() };
         }
-        
+
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index>
+    std::pair<EdgeId, size_t> get(const Index *index, const KMer& kmer) const {
+        return get(index, index->ConstructKWH(kmer));
+    }
+
+    template<class Index>
+    void get(const Index *index, const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        std::array<boost::optional<typename Index::KeyWithHash>, LOOKUP_BATCH> kwhs;
+        for (size_t start = 0; start < n; start += LOOKUP_BATCH) {
+            size_t cnt = std::min(n - start, LOOKUP_BATCH);
+            // Compute all the hashes first and prefetch the entries, so the
+            // cache misses of independent lookups overlap
+            for (size_t i = 0; i < cnt; ++i) {
+                kwhs[i].emplace(index->ConstructKWH(kmers[start + i]));
+                const auto &kwh = *kwhs[i];
+                if (index->valid(kwh))
+                    __builtin_prefetch(&index->get_raw_value_reference(kwh));
+            }
+
+            for (size_t i = 0; i < cnt; ++i)
+                res[start + i] = get(index, *kwhs[i]);
+        }
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
         return index->contains(index->ConstructKWH(kmer));
@@ -141,6 +169,10 @@ public:
         DISPATCH_TO(DeleteKmers, e);
     }
 
+    bool IsBatchable() const override {
+        return true;
+    }
+
     bool contains(const KMer& kmer) const {
         DISPATCH_TO(contains, kmer);
     }
@@ -149,6 +181,13 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    /**
+     * Batched version of get(): looks up n k-mers and stores their positions into res.
+     */
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        DISPATCH_TO(get, kmers, n, res);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
@@ -18,6 +18,7 @@
 #include "kmer_mapper.hpp"
 #include "edge_index.hpp"
 
+#include <array>
 #include <cstdlib>
 
 namespace debruijn_graph {
@@ -298,13 +299,13 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   const KmerSubs& kmer_mapper_;
   size_t k_;
   bool optimization_on_;
+  size_t max_lookup_batch_;
 
-  bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
-                RangeMappings& range_mappings) const {
-    const auto& position = index_.get(kmer);
+  bool AddPosition(const std::pair<EdgeId, size_t> &position, size_t kmer_pos, std::vector<EdgeId> &passed,
+                   RangeMappings& range_mappings) const {
     if (position.second == Index::NOT_FOUND)
         return false;
-    
+
     if (passed.empty() || passed.back() != position.first ||
         kmer_pos != range_mappings.back().initial_range.end_pos ||
         position.second + 1 < range_mappings.back().mapped_range.end_pos) {
@@ -351,33 +352,78 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     return false;
   }
 
-  bool ProcessKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
-                   RangeMappings& range_mapping, bool try_thread) const {
-    if (try_thread) {
-        if (!TryThread(kmer, kmer_pos, passed_edges, range_mapping)) {
-            FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
-            return false;
-        }
+  /*
+   * K-mers of the read that are not threaded along the graph are looked up in
+   * the index in batches. Batch size starts from one and is doubled while the
+   * lookups keep failing (e.g. within k positions from a sequencing error),
+   * so the cache misses of consecutive lookups overlap, while k-mers found by
+   * threading are (almost) never looked up. Maximal batch size of 1 gives
+   * plain per-k-mer lookups.
+   */
+  class KmerLookup {
+      const Index &index_;
+      const Sequence &sequence_;
+      size_t k_;
+      size_t max_batch_size_;
+      std::array<Kmer, Index::LOOKUP_BATCH> kmers_;
+      std::array<std::pair<EdgeId, size_t>, Index::LOOKUP_BATCH> positions_;
+      size_t start_ = 0, size_ = 0;
+      size_t batch_size_ = 1;
+
+    public:
+      KmerLookup(const Index &index, const Sequence &sequence, size_t k, size_t max_batch_size)
+              : index_(index), sequence_(sequence), k_(k), max_batch_size_(max_batch_size) {}
+
+      const std::pair<EdgeId, size_t> &get(const Kmer &kmer, size_t kmer_pos) {
+          if (kmer_pos < start_ || kmer_pos >= start_ + size_) {
+              // Continue growing the batch only if the previous one was used up
+              batch_size_ = (size_ && kmer_pos == start_ + size_ ?
+                             std::min(2 * batch_size_, max_batch_size_) : 1);
+              start_ = kmer_pos;
+              size_ = std::min(batch_size_, sequence_.size() - k_ + 1 - kmer_pos);
+              kmers_[0] = kmer;
+              for (size_t i = 1; i < size_; ++i)
+                  kmers_[i] = kmers_[i - 1] << sequence_[kmer_pos + i + k_ - 1];
+              index_.get(kmers_.data(), size_, positions_.data());
+          }
+
+          return positions_[kmer_pos - start_];
+      }
 
+      void found() {
+          // Read is threaded from here, restart with a single lookup
+          batch_size_ = 1;
+      }
+  };
+
+  bool ProcessKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
+                   RangeMappings& range_mapping, bool try_thread, KmerLookup &lookup) const {
+    if (try_thread && TryThread(kmer, kmer_pos, passed_edges, range_mapping))
         return true;
-    }
 
     if (kmer_mapper_.CanSubstitute(kmer)) {
-        FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+        AddPosition(index_.get(kmer_mapper_.Substitute(kmer)), kmer_pos, passed_edges, range_mapping);
         return false;
     }
 
-    return FindKmer(kmer, kmer_pos, passed_edges, range_mapping);
+    bool found = AddPosition(lookup.get(kmer, kmer_pos), kmer_pos, passed_edges, range_mapping);
+    if (found)
+        lookup.found();
+
+    // The read is threaded further only from k-mers found directly
+    return !try_thread && found;
   }
 
  public:
   BasicSequenceMapper(const Graph& g,
                       const Index& index,
                       const KmerSubs& kmer_mapper,
-                      bool optimization_on = true) :
+                      bool optimization_on = true,
+                      size_t max_lookup_batch = Index::LOOKUP_BATCH) :
       AbstractSequenceMapper<Graph>(g), index_(index),
       kmer_mapper_(kmer_mapper), k_(g.k()+1),
-      optimization_on_(optimization_on) { }
+      optimization_on_(optimization_on),
+      max_lookup_batch_(std::max<size_t>(1, std::min(max_lookup_batch, size_t(Index::LOOKUP_BATCH)))) { }
 
   MappingPath<EdgeId> MapSequence(const Sequence &sequence,
                                   bool only_simple = false) const {
@@ -388,14 +434,15 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
       return MappingPath<EdgeId>();
     }
 
+    KmerLookup lookup(index_, sequence, k_, max_lookup_batch_);
     Kmer kmer = sequence.start<Kmer>(k_);
     bool try_thread = false;
     try_thread = ProcessKmer(kmer, 0, passed_edges,
-                             range_mapping, try_thread);
+                             range_mapping, try_thread, lookup);
     for (size_t i = k_; i < sequence.size(); ++i) {
       kmer <<= sequence[i];
       try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
-                               range_mapping, try_thread);
+                               range_mapping, try_thread, lookup);
       if (only_simple && passed_edges.size() > 1)
         return MappingPath<EdgeId>();
     }
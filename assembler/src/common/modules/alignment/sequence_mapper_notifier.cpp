@@ -10,6 +10,8 @@
 #include "io/reads/paired_read.hpp"
 #include "io/reads/read_stream_vector.hpp"
 
+#include <algorithm>
+
 namespace debruijn_graph {
 
 SequenceMapperNotifier::SequenceMapperNotifier(const GraphPack& gp, size_t lib_count)
@@ -39,6 +41,57 @@ void SequenceMapperNotifier::NotifyMergeBuffer(size_t ilib, size_t ithread) cons
         listener->MergeBuffer(ithread);
 }
 
+bool SequenceMapperNotifier::MergeBuffer(size_t ilib, size_t ithread,
+                                         std::vector<std::mutex> &locks, bool wait) const {
+    std::string thread_str = std::to_string(ithread);
+    TIME_TRACE_SCOPE("SequenceMapperNotifier::MergeBuffer", thread_str);
+    const auto &listeners = listeners_[ilib];
+    VERIFY(locks.size() == listeners.size());
+
+    bool merged = true;
+    for (size_t i = 0; i < listeners.size(); ++i) {
+        std::unique_lock<std::mutex> lock(locks[i], std::defer_lock);
+        if (wait)
+            lock.lock();
+        else if (!lock.try_lock()) {
+            merged = false;
+            continue;
+        }
+
+        listeners[i]->MergeBuffer(ithread);
+    }
+
+    return merged;
+}
+
+void SequenceMapperNotifier::ReportProgress(std::atomic<size_t> &counter, size_t size) const {
+    auto log2 = [](size_t x) { return x ? 63 - __builtin_clzll(x) : 0; };
+
+    size_t prev = counter.fetch_add(size), cur = prev + size;
+    if ((cur >> 15) && log2(prev) != log2(cur))
+        INFO("Processed " << cur << " reads");
+}
+
+void SequenceMapperNotifier::ReportUtilization(const std::vector<ThreadStats> &stats, double elapsed) const {
+    if (stats.empty() || elapsed <= 0)
+        return;
+
+    // Utilization is the fraction of the pass spent on mapping the reads,
+    // the rest is spent on reading, merging and waiting for other threads
+    std::string utilization;
+    size_t stolen = 0;
+    for (size_t i = 0; i < stats.size(); ++i) {
+        const auto &stat = stats[i];
+        utilization += " " + std::to_string(unsigned(100 * std::min(stat.process_time / elapsed, 1.0)));
+        stolen += stat.stolen_chunks;
+        DEBUG("Thread #" << i << ": " << stat.reads << " reads, " << stat.stolen_chunks << " stolen chunks, "
+              << "reading " << stat.read_time << " s, mapping " << stat.process_time << " s, "
+              << "merging " << stat.merge_time << " s");
+    }
+
+    INFO("Thread utilization (%):" << utilization << "; " << stolen << " chunks stolen");
+}
+
 template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
                                                const SequenceMapperT& mapper,
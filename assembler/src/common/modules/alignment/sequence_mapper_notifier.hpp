@@ -15,8 +15,12 @@
 #include "io/reads/paired_read.hpp"
 #include "io/reads/read_stream_vector.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
 #include "utils/perf/timetracer.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -42,6 +46,16 @@ public:
 
 class SequenceMapperNotifier {
     static constexpr size_t BUFFER_SIZE = 200000;
+    // Number of reads taken from a stream at once
+    static constexpr size_t CHUNK_SIZE = 1024;
+
+    struct ThreadStats {
+        size_t reads = 0;
+        size_t stolen_chunks = 0;
+        double read_time = 0;
+        double process_time = 0;
+        double merge_time = 0;
+    };
 public:
     typedef SequenceMapper<Graph> SequenceMapperT;
 
@@ -61,38 +75,66 @@ public:
 
         streams.reset();
         NotifyStartProcessLibrary(lib_index, threads_count);
-        size_t counter = 0, n = 15;
 
-        #pragma omp parallel for num_threads(threads_count) shared(counter)
-        for (size_t i = 0; i < streams.size(); ++i) {
+        // Every thread starts from its own stream and, once it is exhausted,
+        // steals chunks of reads from the streams still being processed.
+        std::vector<std::mutex> stream_locks(streams.size());
+        std::vector<std::mutex> merge_locks(listeners_[lib_index].size());
+        std::vector<ThreadStats> stats(threads_count);
+        std::atomic<size_t> counter{0};
+        utils::perf_counter pass_timer;
+
+        #pragma omp parallel num_threads(threads_count)
+        {
+            size_t ithread = omp_get_thread_num();
+            ThreadStats stat;
+            utils::perf_counter timer;
+            std::vector<ReadType> chunk(CHUNK_SIZE);
             size_t size = 0;
-            ReadType r;
-            auto& stream = streams[i];
-            while (!stream.eof()) {
-                if (size == BUFFER_SIZE) {
-                    #pragma omp critical
+
+            for (size_t j = 0; j < streams.size(); ++j) {
+                size_t istream = (ithread + j) % streams.size();
+                auto& stream = streams[istream];
+                while (true) {
+                    timer.reset();
+                    size_t n = 0;
                     {
-                        counter += size;
-                        if (counter >> n) {
-                            INFO("Processed " << counter << " reads");
-                            n += 1;
+                        std::lock_guard<std::mutex> lock(stream_locks[istream]);
+                        if (!stream.eof())
+                            n = io::read_batch(stream, chunk);
+                    }
+                    stat.read_time += timer.time();
+                    if (n == 0)
+                        break;
+
+                    timer.reset();
+                    for (size_t k = 0; k < n; ++k)
+                        NotifyProcessRead(chunk[k], mapper, lib_index, ithread);
+                    stat.process_time += timer.time();
+                    stat.reads += n;
+                    stat.stolen_chunks += (j > 0);
+                    size += n;
+
+                    // Do not wait for busy listeners unless the buffer grew too large
+                    if (size >= BUFFER_SIZE) {
+                        timer.reset();
+                        if (MergeBuffer(lib_index, ithread, merge_locks, size >= 2 * BUFFER_SIZE)) {
+                            ReportProgress(counter, size);
+                            size = 0;
                         }
-                        size = 0;
-                        NotifyMergeBuffer(lib_index, i);
+                        stat.merge_time += timer.time();
                     }
                 }
-                stream >> r;
-                ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
             }
-            #pragma omp atomic
             counter += size;
+            stats[ithread] = stat;
         }
 
         for (size_t i = 0; i < threads_count; ++i)
             NotifyMergeBuffer(lib_index, i);
 
         INFO("Total " << counter << " reads processed");
+        ReportUtilization(stats, pass_timer.time());
         NotifyStopProcessLibrary(lib_index);
     }
 
@@ -106,9 +148,20 @@ private:
 
     void NotifyMergeBuffer(size_t ilib, size_t ithread) const;
 
+    // Merges thread buffers of all the listeners that are not being merged
+    // by other threads right now (or waits for them if wait is set).
+    // Returns true if all the buffers were merged.
+    bool MergeBuffer(size_t ilib, size_t ithread, std::vector<std::mutex> &locks, bool wait) const;
+
+    void ReportProgress(std::atomic<size_t> &counter, size_t size) const;
+
+    void ReportUtilization(const std::vector<ThreadStats> &stats, double elapsed) const;
+
     const GraphPack& gp_;
 
     std::vector<std::vector<SequenceMapperListener*> > listeners_;  //first vector's size = count libs
+
+    DECL_LOGGER("SequenceMapperNotifier");
 };
 
 } // namespace debruijn_graph
@@ -1063,22 +1063,19 @@ private:
 
 class LongReadsExtensionChooser : public ExtensionChooser {
 public:
+    // Unique edge analyzer could be shared by several choosers using the same coverage map
     LongReadsExtensionChooser(const Graph& g,
                               const GraphCoverageMap& read_paths_cov_map,
                               double filtering_threshold,
                               double weight_priority_threshold,
-                              double unique_edge_priority_threshold,
                               size_t min_significant_overlap,
-                              size_t max_repeat_length,
-                              bool uneven_depth)
+                              std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer)
             : ExtensionChooser(g),
               filtering_threshold_(filtering_threshold),
               weight_priority_threshold_(weight_priority_threshold),
               min_significant_overlap_(min_significant_overlap),
               cov_map_(read_paths_cov_map),
-              unique_edge_analyzer_(g, cov_map_, filtering_threshold,
-                                    unique_edge_priority_threshold,
-                                    max_repeat_length, uneven_depth)
+              unique_edge_analyzer_(std::move(unique_edge_analyzer))
     {
     }
 
@@ -1153,7 +1150,7 @@ private:
     bool UniqueBackPath(const BidirectionalPath& path, size_t pos) const {
         int int_pos = (int) pos;
         while (int_pos >= 0) {
-            if (unique_edge_analyzer_.IsUnique(path.At(int_pos)) > 0 && g_.length(path.At(int_pos)) >= min_significant_overlap_)
+            if (unique_edge_analyzer_->IsUnique(path.At(int_pos)) > 0 && g_.length(path.At(int_pos)) >= min_significant_overlap_)
                 return true;
             int_pos--;
         }
@@ -1170,7 +1167,7 @@ private:
     double weight_priority_threshold_;
     size_t min_significant_overlap_;
     const GraphCoverageMap& cov_map_;
-    LongReadsUniqueEdgeAnalyzer unique_edge_analyzer_;
+    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer_;
 
     DECL_LOGGER("LongReadsExtensionChooser");
 };
@@ -1181,19 +1178,15 @@ public:
                                     const GraphCoverageMap& read_paths_cov_map,
                                     double filtering_threshold,
                                     double weight_priority_threshold,
-                                    double unique_edge_priority_threshold,
                                     size_t min_significant_overlap,
-                                    size_t max_repeat_length,
-                                    bool uneven_depth,
+                                    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer,
                                     bool use_low_quality_matching = false)
             : ExtensionChooser(g)
             , filtering_threshold_(filtering_threshold)
             , weight_priority_threshold_(weight_priority_threshold)
             , min_significant_overlap_(min_significant_overlap)
             , cov_map_(read_paths_cov_map)
-            , unique_edge_analyzer_(g, cov_map_, filtering_threshold,
-                                    unique_edge_priority_threshold,
-                                    max_repeat_length, uneven_depth)
+            , unique_edge_analyzer_(std::move(unique_edge_analyzer))
             , use_low_quality_matching_(use_low_quality_matching)
     {}
 
@@ -1313,7 +1306,7 @@ private:
     }
 
     bool IsUniqueEdge(EdgeId edge) const {
-        return unique_edge_analyzer_.IsUnique(edge) && g_.length(edge) >= min_significant_overlap_;
+        return unique_edge_analyzer_->IsUnique(edge) && g_.length(edge) >= min_significant_overlap_;
     }
 
     bool HasUniqueEdge(const BidirectionalPath& path, size_t from, size_t len) const {
@@ -1335,7 +1328,7 @@ private:
     double weight_priority_threshold_;
     size_t min_significant_overlap_;
     const GraphCoverageMap& cov_map_;
-    LongReadsUniqueEdgeAnalyzer unique_edge_analyzer_;
+    std::shared_ptr<const LongReadsUniqueEdgeAnalyzer> unique_edge_analyzer_;
     bool use_low_quality_matching_;
 
     DECL_LOGGER("TrustedContigsExtensionChooser");
@@ -17,6 +17,7 @@
 #include "assembly_graph/graph_support/scaff_supplementary.hpp"
 
 #include <cmath>
+#include <functional>
 
 namespace path_extend {
 
@@ -283,7 +284,7 @@ protected:
 
 public:
     InsertSizeLoopDetector(const Graph& g, size_t is):
-        visited_cycles_coverage_map_(g),
+        visited_cycles_coverage_map_(g, /*reserve*/false),
         path_storage_(),
         min_cycle_len_(is) {
     }
@@ -407,6 +408,24 @@ public:
         DEBUG("add cycle");
         p.first.PrintDEBUG();
     }
+
+    /// @returns the cycles found so far, the detector forgets them
+    PathContainer ReleaseCycles() {
+        for (auto it = path_storage_.begin(); it != path_storage_.end(); ++it)
+            visited_cycles_coverage_map_.Unsubscribe({it.get(), it.getConjugate()});
+
+        PathContainer res(std::move(path_storage_));
+        path_storage_.clear();
+        return res;
+    }
+
+    void AddCycles(const PathContainer &cycles) {
+        for (auto it = cycles.begin(); it != cycles.end(); ++it) {
+            auto p = path_storage_.AddPair(BidirectionalPath::clone(it.get()),
+                                           BidirectionalPath::clone(it.getConjugate()));
+            visited_cycles_coverage_map_.Subscribe(p);
+        }
+    }
 };
 
 class PathExtender {
@@ -417,6 +436,11 @@ public:
     virtual ~PathExtender() = default;
     virtual bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage = nullptr) = 0;
 
+    // State kept by the extender between the paths (cycles detected so far).
+    // Used to pass the state from speculatively growing extender to the main one.
+    virtual PathContainer ReleaseCycles() { return PathContainer(); }
+    virtual void AddCycles(const PathContainer &) {}
+
 protected:
     const Graph &g_;
     DECL_LOGGER("PathExtender")
@@ -424,9 +448,21 @@ protected:
 
 
 class CompositeExtender {
+public:
+    typedef std::vector<std::shared_ptr<PathExtender>> Extenders;
+    // Makes the same extenders as the ones of composite extender, working on the given coverage map and used storage
+    typedef std::function<Extenders(GraphCoverageMap&, UsedUniqueStorage&)> ExtendersFactory;
+
 private:
+    struct Workspace;
+    struct Speculation;
+
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage);
     void GrowAllPaths(PathContainer& paths, PathContainer& result);
+    bool UseSeed(const BidirectionalPath &seed);
+    void GrowSeed(BidirectionalPath &path, PathContainer &result);
+    std::unique_ptr<Speculation> Speculate(const BidirectionalPath &seed, Workspace &workspace) const;
+    void Accept(const Speculation &spec, PathContainer &result);
 
 public:
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
@@ -435,9 +471,23 @@ public:
             : g_(g),
               cover_map_(cov_map),
               used_storage_(unique),
-              extenders_(pes) {}
+              extenders_(pes),
+              nthreads_(1) {}
 
     void GrowAll(PathContainer& paths, PathContainer& result);
+
+    /// Makes GrowAll grow the seeds in parallel, see GrowAllParallel
+    void EnableParallelGrowth(ExtendersFactory factory, size_t nthreads) {
+        factory_ = std::move(factory);
+        nthreads_ = nthreads;
+    }
+
+    /// Same as GrowAll, but seeds are grown in 'nthreads' threads, each one using extenders made by 'factory'.
+    /// Paths grown speculatively are accepted in the order of seeds, ones that touched or looked up in the
+    /// coverage map and used storage the edges of already accepted paths are grown again by own extenders. Thus the result is the same as the one of GrowAll.
+    void GrowAllParallel(PathContainer& paths, PathContainer& result,
+                         const ExtendersFactory &factory, size_t nthreads);
+
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
         while (MakeGrowStep(path, paths_storage)) { }
     }
@@ -447,6 +497,8 @@ private:
     GraphCoverageMap &cover_map_;
     UsedUniqueStorage &used_storage_;
     std::vector<std::shared_ptr<PathExtender>> extenders_;
+    ExtendersFactory factory_;
+    size_t nthreads_;
 };
 
 
@@ -495,6 +547,14 @@ public:
     bool TryToResolveTwoLoops(BidirectionalPath& path);
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage) override;
 
+    PathContainer ReleaseCycles() override {
+        return is_detector_.ReleaseCycles();
+    }
+
+    void AddCycles(const PathContainer &cycles) override {
+        is_detector_.AddCycles(cycles);
+    }
+
 private:
     bool ResolveShortLoop(BidirectionalPath& p) {
         if (use_short_loop_cov_resolver_) {
@@ -7,9 +7,20 @@
 
 #include "path_extender.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/stl_utils.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
 namespace path_extend {
 
 void CompositeExtender::GrowAll(PathContainer& paths, PathContainer& result) {
+    if (nthreads_ > 1) {
+        GrowAllParallel(paths, result, factory_, nthreads_);
+        return;
+    }
+
     result.clear();
     GrowAllPaths(paths, result);
     result.FilterEmptyPaths();
@@ -29,50 +40,243 @@ bool CompositeExtender::MakeGrowStep(BidirectionalPath& path, PathContainer* pat
     return false;
 }
 
+bool CompositeExtender::UseSeed(const BidirectionalPath &seed) {
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    if (!used_storage_.UniqueCheckEnabled())
+        return true;
+
+    for (size_t ind =0; ind < seed.Size(); ind++) {
+        EdgeId eid = seed.At(ind);
+        auto path_id = seed.GetId();
+        if (used_storage_.IsUsedAndUnique(eid, path_id)) {
+            DEBUG("Used edge " << g_.int_id(eid));
+            return false;
+        } else {
+            used_storage_.insert(eid, path_id);
+        }
+    }
+    return true;
+}
+
+void CompositeExtender::GrowSeed(BidirectionalPath &path, PathContainer &result) {
+    size_t count_trying = 0;
+    size_t current_path_len = 0;
+    do {
+        current_path_len = path.Length();
+        count_trying++;
+        GrowPath(path, &result);
+        GrowPath(*path.GetConjPath(), &result);
+    } while (count_trying < 10 && (path.Length() != current_path_len));
+    DEBUG("result path " << path.GetId());
+    path.PrintDEBUG();
+}
+
 void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result) {
     for (size_t i = 0; i < paths.size(); ++i) {
         VERBOSE_POWER_T2(i, 100, "Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
             INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
-            }
+        if (!UseSeed(paths.Get(i))) {
+            DEBUG("skipping already used seed");
+            continue;
         }
 
         if (!cover_map_.IsCovered(paths.Get(i))) {
             BidirectionalPath &path = CreatePath(result, cover_map_,
                                                  paths.Get(i));
+            GrowSeed(path, result);
+        }
+    }
+}
+
+namespace {
+
+// Collects all the edges (and their conjugates) ever added to the path
+class TouchedEdges : public PathListener {
+public:
+    typedef std::unordered_set<EdgeId> EdgeSet;
+
+    TouchedEdges(const Graph &g, EdgeSet &edges)
+            : g_(g), edges_(edges) {}
+
+    void Touch(EdgeId e) {
+        edges_.insert(e);
+        edges_.insert(g_.conjugate(e));
+    }
+
+    void Touch(const BidirectionalPath &path) {
+        for (size_t i = 0; i < path.Size(); ++i)
+            Touch(path.At(i));
+    }
+
+    void FrontEdgeAdded(EdgeId e, BidirectionalPath &, const Gap &) override { Touch(e); }
+    void BackEdgeAdded(EdgeId e, BidirectionalPath &, const Gap &) override { Touch(e); }
+    void FrontEdgeRemoved(EdgeId, BidirectionalPath &) override {}
+    void BackEdgeRemoved(EdgeId, BidirectionalPath &) override {}
+
+private:
+    const Graph &g_;
+    EdgeSet &edges_;
+};
+
+bool Intersect(const TouchedEdges::EdgeSet &lhs, const TouchedEdges::EdgeSet &rhs) {
+    for (EdgeId e : lhs) {
+        if (rhs.count(e))
+            return true;
+    }
+    return false;
+}
+
+}
+
+// Coverage map, used storage and extenders of a single thread. Everything is cleared after each seed.
+struct CompositeExtender::Workspace {
+    GraphCoverageMap cover_map;
+    UsedUniqueStorage used_storage;
+    CompositeExtender extender;
+
+    Workspace(const Graph &g, const ScaffoldingUniqueEdgeStorage &unique, const ExtendersFactory &factory)
+            : cover_map(g, /*reserve*/false),
+              used_storage(unique, g),
+              extender(g, cover_map, used_storage, factory(cover_map, used_storage)) {}
+};
+
+// Seed grown in isolation together with the state its growth left in the workspace
+struct CompositeExtender::Speculation {
+    // The grown path goes first, followed by the paths created by extenders
+    PathContainer paths;
+    TouchedEdges::EdgeSet touched;
+    // Edges the coverage map and used storage were asked about. Growth depends only on them,
+    // so the speculation holds as long as no accepted path touches them
+    TouchedEdges::EdgeSet queried;
+    UsedUniqueStorage::PathsUsage used;
+    std::vector<PathContainer> cycles;
+};
+
+std::unique_ptr<CompositeExtender::Speculation>
+CompositeExtender::Speculate(const BidirectionalPath &seed, Workspace &workspace) const {
+    CompositeExtender &extender = workspace.extender;
+    std::unique_ptr<Speculation> spec(new Speculation());
+    TouchedEdges touched(g_, spec->touched);
+    touched.Touch(seed);
+
+    workspace.cover_map.RecordQueries(&spec->queried);
+    workspace.used_storage.RecordQueries(&spec->queried);
+    bool use_seed = extender.UseSeed(seed);
+    if (use_seed) {
+        BidirectionalPath &path = CreatePath(spec->paths, workspace.cover_map, seed);
+        path.Subscribe(touched);
+        extender.GrowSeed(path, spec->paths);
+        path.Unsubscribe(touched);
+        workspace.cover_map.Unsubscribe({path, *path.GetConjPath()});
+    }
+    workspace.cover_map.RecordQueries(nullptr);
+    workspace.used_storage.RecordQueries(nullptr);
+
+    // Differs from the serial growth, let it decide
+    if (!use_seed)
+        spec.reset();
+
+    // Leave the workspace clean for the next seed
+    UsedUniqueStorage::PathsUsage used = workspace.used_storage.Release();
+    std::vector<PathContainer> cycles;
+    for (const auto &pe : extender.extenders_)
+        cycles.push_back(pe->ReleaseCycles());
+
+    if (spec) {
+        spec->used = std::move(used);
+        spec->cycles = std::move(cycles);
+    }
+    return spec;
+}
+
+void CompositeExtender::Accept(const Speculation &spec, PathContainer &result) {
+    std::unordered_map<size_t, size_t> ids;
+    for (auto it = spec.paths.begin(); it != spec.paths.end(); ++it) {
+        auto p = BidirectionalPath::clone(it.get());
+        auto cp = BidirectionalPath::clone(it.getConjugate());
+        ids[it.get().GetId()] = p->GetId();
+        ids[it.getConjugate().GetId()] = cp->GetId();
+
+        auto pp = result.AddPair(std::move(p), std::move(cp));
+        // Only the grown seed is tracked by the coverage map
+        if (it == spec.paths.begin())
+            cover_map_.Subscribe(pp);
+    }
+
+    used_storage_.Use(spec.used, ids);
+    VERIFY(spec.cycles.size() == extenders_.size());
+    for (size_t i = 0; i < extenders_.size(); ++i)
+        extenders_[i]->AddCycles(spec.cycles[i]);
+}
+
+void CompositeExtender::GrowAllParallel(PathContainer& paths, PathContainer& result,
+                                        const ExtendersFactory &factory, size_t nthreads) {
+    result.clear();
 
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
+    std::vector<std::unique_ptr<Workspace>> workspaces;
+    for (size_t i = 0; i < nthreads; ++i)
+        workspaces.push_back(std::make_unique<Workspace>(g_, used_storage_.unique_storage(), factory));
+
+    // Edges of accepted paths: only the paths neither touching nor querying them could be grown independently
+    TouchedEdges::EdgeSet committed;
+    TouchedEdges committed_touched(g_, committed);
+
+    const size_t window = nthreads * 16;
+    size_t speculated = 0, accepted = 0;
+    for (size_t start = 0; start < paths.size(); start += window) {
+        size_t end = std::min(start + window, paths.size());
+        std::vector<std::unique_ptr<Speculation>> specs(end - start);
+
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+        for (size_t i = start; i < end; ++i) {
+            const BidirectionalPath &seed = paths.Get(i);
+            if (cover_map_.IsCovered(seed))
+                continue;
+
+            bool touches_committed = false;
+            for (size_t j = 0; j < seed.Size() && !touches_committed; ++j)
+                touches_committed = committed.count(seed.At(j));
+            if (!touches_committed)
+                specs[i - start] = Speculate(seed, *workspaces[omp_get_thread_num()]);
+        }
+
+        for (size_t i = start; i < end; ++i) {
+            if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
+                INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
+            }
+            const BidirectionalPath &seed = paths.Get(i);
+            const auto &spec = specs[i - start];
+            // Seed edges are also marked as used, so they are committed whatever happens
+            bool conflict = !spec || Intersect(spec->touched, committed) || Intersect(spec->queried, committed);
+            bool use_seed = UseSeed(seed);
+            committed_touched.Touch(seed);
+            if (!use_seed) {
+                DEBUG("skipping already used seed");
+                continue;
+            }
+            if (cover_map_.IsCovered(seed))
+                continue;
+
+            speculated += bool(spec);
+            if (!conflict) {
+                Accept(*spec, result);
+                utils::insert_all(committed, spec->touched);
+                accepted += 1;
+                continue;
+            }
+
+            BidirectionalPath &path = CreatePath(result, cover_map_, seed);
+            path.Subscribe(committed_touched);
+            GrowSeed(path, result);
+            path.Unsubscribe(committed_touched);
         }
     }
+
+    INFO("Paths grown in parallel: " << accepted << " of " << speculated << " accepted");
+    result.FilterEmptyPaths();
 }
 
 bool LoopDetectingPathExtender::TryUseEdge(BidirectionalPath &path, EdgeId e, const Gap &gap) {
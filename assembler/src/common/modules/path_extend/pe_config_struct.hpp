@@ -202,6 +202,8 @@ struct pe_config {
 
     struct MainPEParamsT {
         bool debug_output;
+        // Grow seeds speculatively in parallel, the result is the same
+        bool parallel_growth;
         std::string etc_dir;
 
         OutputParamsT output;
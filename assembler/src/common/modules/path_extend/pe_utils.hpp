@@ -15,6 +15,8 @@
 #include "adt/flat_map.hpp"
 #include "parallel_hashmap/phmap.h"
 
+#include <unordered_set>
+
 namespace path_extend {
 
 using namespace debruijn_graph;
@@ -30,6 +32,12 @@ private:
 
     phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
     const MapDataT empty_;
+    std::unordered_set<EdgeId> *queried_ = nullptr;
+
+    void Queried(EdgeId e) const {
+        if (queried_)
+            queried_->insert(e);
+    }
 
     void EdgeAdded(EdgeId e, BidirectionalPath &path) {
         edge_coverage_[e][&path] += 1;
@@ -66,9 +74,10 @@ public:
 
     GraphCoverageMap(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
+    explicit GraphCoverageMap(const Graph& g, bool reserve = true) : g_(g) {
         //FIXME heavy constructor
-        edge_coverage_.reserve(g_.e_size());
+        if (reserve)
+            edge_coverage_.reserve(g_.e_size());
     }
 
     GraphCoverageMap(const Graph& g, const PathContainer& paths, bool subscribe = false) :
@@ -94,6 +103,18 @@ public:
         ProcessPath(ppair.second, true);
     }
 
+    void Unsubscribe(BidirectionalPath &path) {
+        path.Unsubscribe(*this);
+        for (size_t i = 0; i < path.Size(); ++i) {
+            EdgeRemoved(path.At(i), path);
+        }
+    }
+
+    void Unsubscribe(std::pair<BidirectionalPath&, BidirectionalPath&> ppair) {
+        Unsubscribe(ppair.first);
+        Unsubscribe(ppair.second);
+    }
+
     //Inherited from PathListener
     void FrontEdgeAdded(EdgeId e, BidirectionalPath &path, const Gap&) override {
         EdgeAdded(e, path);
@@ -114,7 +135,13 @@ public:
         EdgeRemoved(e, path);
     }
 
+    /// Makes the map add every edge it is asked about to 'queried', nullptr stops it
+    void RecordQueries(std::unordered_set<EdgeId> *queried) {
+        queried_ = queried;
+    }
+
     const MapDataT &GetEdgePaths(EdgeId e) const {
+        Queried(e);
         auto iter = edge_coverage_.find(e);
         if (iter != edge_coverage_.end()) {
             return iter->second;
@@ -123,6 +150,7 @@ public:
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
+        Queried(e);
         auto entry = edge_coverage_.find(e);
         if (entry == edge_coverage_.end())
             return 0;
@@ -132,6 +160,7 @@ public:
     }
 
     size_t GetCoverage(EdgeId e) const {
+        Queried(e);
         auto iter = edge_coverage_.find(e);
         return (iter != edge_coverage_.end() ? iter->second.size() : 0);
     }
@@ -149,6 +178,7 @@ public:
     }
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
+        Queried(e);
         BidirectionalPathSet res;
         auto iter = edge_coverage_.find(e);
         if (iter == edge_coverage_.end())
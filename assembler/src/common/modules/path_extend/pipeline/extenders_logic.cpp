@@ -16,23 +16,27 @@ shared_ptr<ExtensionChooser> ExtendersGenerator::MakeLongReadsExtensionChooser(s
                                                                                const GraphCoverageMap &read_paths_cov_map) const {
     auto long_reads_config = support_.GetLongReadsConfig(dataset_info_.reads[lib_index].type());
 
+    auto &unique_edge_analyzer = shared_data_.long_reads_unique_analyzers[lib_index];
+    if (!unique_edge_analyzer)
+        unique_edge_analyzer = make_shared<LongReadsUniqueEdgeAnalyzer>(graph_, read_paths_cov_map,
+                                                                        long_reads_config.filtering,
+                                                                        long_reads_config.unique_edge_priority,
+                                                                        params_.pset.extension_options.max_repeat_length,
+                                                                        params_.uneven_depth);
+
     if (dataset_info_.reads[lib_index].type() == io::LibraryType::TrustedContigs) {
         return make_shared<TrustedContigsExtensionChooser>(graph_, read_paths_cov_map,
                                                             long_reads_config.filtering,
                                                             long_reads_config.weight_priority,
-                                                            long_reads_config.unique_edge_priority,
                                                             long_reads_config.min_significant_overlap,
-                                                            params_.pset.extension_options.max_repeat_length,
-                                                            params_.uneven_depth);
+                                                            unique_edge_analyzer);
     }
 
     return make_shared<LongReadsExtensionChooser>(graph_, read_paths_cov_map,
                                                   long_reads_config.filtering,
                                                   long_reads_config.weight_priority,
-                                                  long_reads_config.unique_edge_priority,
                                                   long_reads_config.min_significant_overlap,
-                                                  params_.pset.extension_options.max_repeat_length,
-                                                  params_.uneven_depth);
+                                                  unique_edge_analyzer);
 }
 
 shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongReadsExtender(size_t lib_index,
@@ -44,7 +48,7 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongReadsExtender(size_t lib_
         //TODO does max make sense here?
         resolvable_repeat_length_bound = std::max(resolvable_repeat_length_bound, lib.data().unmerged_read_length);
     }
-    INFO("resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
+    LOG_MSG(log_level_, "resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
     bool investigate_short_loop = lib.is_contig_lib() || lib.is_long_read_lib() || support_.UseCoverageResolverForSingleReads(lib.type());
 
     auto long_read_ec = MakeLongReadsExtensionChooser(lib_index, read_paths_cov_map);
@@ -165,7 +169,7 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeRNAScaffoldingExtender(size_t l
 std::shared_ptr<ExtensionChooser> ExtendersGenerator::MakeLongReadsRNAExtensionChooser(size_t lib_index,
                                                                                   const GraphCoverageMap &read_paths_cov_map) const {
     auto long_reads_config = support_.GetLongReadsConfig(dataset_info_.reads[lib_index].type());
-    INFO("Creating long read rna chooser")
+    LOG_MSG(log_level_, "Creating long read rna chooser")
     return std::make_shared<LongReadsRNAExtensionChooser>(graph_, read_paths_cov_map,
                                                      long_reads_config.filtering,
                                                      long_reads_config.min_significant_overlap);
@@ -180,11 +184,11 @@ std::shared_ptr<SimpleExtender> ExtendersGenerator::MakeLongReadsRNAExtender(siz
     if (!dataset_info_.reads[lib_index].is_contig_lib()) {
         resolvable_repeat_length_bound = std::max(resolvable_repeat_length_bound, lib.data().unmerged_read_length);
     }
-    INFO("resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
+    LOG_MSG(log_level_, "resolvable_repeat_length_bound set to " << resolvable_repeat_length_bound);
     bool investigate_short_loop = false;
 
     auto long_read_ec = MakeLongReadsRNAExtensionChooser(lib_index, read_paths_cov_map);
-    INFO("Creating long read rna extender")
+    LOG_MSG(log_level_, "Creating long read rna extender")
     return std::make_shared<MultiExtender>(gp_, cover_map_,
                                            used_unique_storage_,
                                            long_read_ec,
@@ -203,14 +207,14 @@ shared_ptr<PathExtender> ExtendersGenerator::MakeMatePairScaffoldingExtender(siz
     const auto &clustered_indices = gp_.get<PairedInfoIndicesT<Graph>>("clustered_indices");
 
     shared_ptr<PairedInfoLibrary> paired_lib;
-    INFO("Creating Scaffolding 2015 extender for lib #" << lib_index);
+    LOG_MSG(log_level_, "Creating Scaffolding 2015 extender for lib #" << lib_index);
 
     //FIXME: DimaA
     if (paired_indices[lib_index].size() > clustered_indices[lib_index].size()) {
-        INFO("Paired unclustered indices not empty, using them");
+        LOG_MSG(log_level_, "Paired unclustered indices not empty, using them");
         paired_lib = MakeNewLib(graph_, lib, paired_indices[lib_index]);
     } else if (clustered_indices[lib_index].size()) {
-        INFO("clustered indices not empty, using them");
+        LOG_MSG(log_level_, "clustered indices not empty, using them");
         paired_lib = MakeNewLib(graph_, lib, clustered_indices[lib_index]);
     } else {
         ERROR("All paired indices are empty!");
@@ -331,7 +335,7 @@ shared_ptr<SimpleExtender> ExtendersGenerator::MakePEExtender(size_t lib_index,
         iip = make_shared<CoverageAwareIdealInfoProvider>(graph_, paired_lib, lib.data().unmerged_read_length);
     } else {
         double lib_cov = support_.EstimateLibCoverage(lib_index);
-        INFO("Estimated coverage of library #" << lib_index << " is " << lib_cov);
+        LOG_MSG(log_level_, "Estimated coverage of library #" << lib_index << " is " << lib_cov);
         iip = make_shared<GlobalCoverageAwareIdealInfoProvider>(graph_, paired_lib, lib.data().unmerged_read_length, lib_cov);
     }
 
@@ -386,7 +390,7 @@ void ExtendersGenerator::PrintExtenders(const Extenders &extenders) const {
 
 Extenders ExtendersGenerator::MakeMPExtenders() const {
     Extenders extenders = MakeMPExtenders(unique_data_.main_unique_storage_);
-    INFO("Using " << extenders.size() << " mate-pair " << support_.LibStr(extenders.size()));
+    LOG_MSG(log_level_, "Using " << extenders.size() << " mate-pair " << support_.LibStr(extenders.size()));
 
     for (const auto& unique_storage : unique_data_.unique_storages_) {
         utils::push_back_all(extenders, MakeMPExtenders(unique_storage));
@@ -416,7 +420,7 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 
     for (size_t lib_index = 0; lib_index < dataset_info_.reads.lib_count(); lib_index++) {
         if (support_.IsForSingleReadScaffolder(dataset_info_.reads[lib_index])) {
-            INFO("Creating scaffolding extender for lib " << lib_index);
+            LOG_MSG(log_level_, "Creating scaffolding extender for lib " << lib_index);
             shared_ptr<ConnectionCondition> condition = make_shared<LongReadsLibConnectionCondition>(graph_,
                                                                                                      lib_index, 2,
                                                                                                      unique_data_.long_reads_cov_map_[lib_index]);
@@ -442,7 +446,7 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 
         }
     }
-    INFO("Using " << result.size() << " long reads scaffolding " << support_.LibStr(result.size()));
+    LOG_MSG(log_level_, "Using " << result.size() << " long reads scaffolding " << support_.LibStr(result.size()));
     std::stable_sort(result.begin(), result.end());
 
     return ExtractExtenders(result);
@@ -452,7 +456,7 @@ Extenders ExtendersGenerator::MakePBScaffoldingExtenders() const {
 Extenders ExtendersGenerator::MakeCoverageExtenders() const {
     Extenders result;
 
-    INFO("Using additional coordinated coverage extender");
+    LOG_MSG(log_level_, "Using additional coordinated coverage extender");
     result.push_back(MakeCoordCoverageExtender(0 /* lib index */));
 
     return result;
@@ -477,7 +481,7 @@ Extenders ExtendersGenerator::MakeBasicExtenders() const {
                 if (pset.multi_path_extend) {
                     basic_extenders.emplace_back(lib.type(), lib_index, MakeLongReadsRNAExtender(lib_index,
                                                                                              unique_data_.long_reads_cov_map_[lib_index]));
-                    INFO("Created for lib #" << lib_index);
+                    LOG_MSG(log_level_, "Created for lib #" << lib_index);
                 } else {
                     basic_extenders.emplace_back(lib.type(), lib_index,
                                                  MakeLongReadsExtender(lib_index,
@@ -539,9 +543,9 @@ Extenders ExtendersGenerator::MakeBasicExtenders() const {
     utils::push_back_all(result, ExtractExtenders(scaffolding_extenders));
     utils::push_back_all(result, ExtractExtenders(loop_resolving_extenders));
 
-    INFO("Using " << pe_libs << " paired-end " << support_.LibStr(pe_libs));
-    INFO("Using " << scf_pe_libs << " paired-end scaffolding " << support_.LibStr(scf_pe_libs));
-    INFO("Using " << single_read_libs << " single read " << support_.LibStr(single_read_libs));
+    LOG_MSG(log_level_, "Using " << pe_libs << " paired-end " << support_.LibStr(pe_libs));
+    LOG_MSG(log_level_, "Using " << scf_pe_libs << " paired-end scaffolding " << support_.LibStr(scf_pe_libs));
+    LOG_MSG(log_level_, "Using " << single_read_libs << " single read " << support_.LibStr(single_read_libs));
 
     PrintExtenders(result);
     return result;
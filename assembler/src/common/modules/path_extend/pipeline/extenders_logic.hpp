@@ -72,6 +72,13 @@ inline Extenders ExtractExtenders(const ExtenderTriplets& triplets) {
     return result;
 }
 
+// Components of extenders that are expensive to make and stay unchanged while paths are grown. They are made
+// on the first request and shared by all extenders made afterwards (e.g. by extenders of every thread)
+struct SharedExtenderData {
+    // Unique edges found with long reads, by library index
+    std::map<size_t, std::shared_ptr<const LongReadsUniqueEdgeAnalyzer>> long_reads_unique_analyzers;
+};
+
 class ExtendersGenerator {
     const config::dataset &dataset_info_;
     const PathExtendParamsContainer &params_;
@@ -84,6 +91,10 @@ class ExtendersGenerator {
 
     const PELaunchSupport &support_;
 
+    SharedExtenderData &shared_data_;
+    // Level of messages about extenders being made, extra copies of the extenders are reported at DEBUG level
+    logging::level log_level_;
+
 public:
     ExtendersGenerator(const config::dataset &dataset_info,
                        const PathExtendParamsContainer &params,
@@ -91,7 +102,9 @@ public:
                        const GraphCoverageMap &cover_map,
                        const UniqueData &unique_data,
                        UsedUniqueStorage &used_unique_storage,
-                       const PELaunchSupport& support) :
+                       const PELaunchSupport& support,
+                       SharedExtenderData &shared_data,
+                       logging::level log_level = logging::L_INFO) :
         dataset_info_(dataset_info),
         params_(params),
         gp_(gp),
@@ -99,7 +112,9 @@ public:
         cover_map_(cover_map),
         unique_data_(unique_data),
         used_unique_storage_(used_unique_storage),
-        support_(support) { }
+        support_(support),
+        shared_data_(shared_data),
+        log_level_(log_level) { }
 
     Extenders MakePBScaffoldingExtenders() const;
 
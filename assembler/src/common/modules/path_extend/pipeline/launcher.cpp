@@ -18,6 +18,7 @@
 #include "modules/path_extend/scaffolder2015/scaffold_graph_visualizer.hpp"
 #include "modules/path_extend/scaffolder2015/scaffold_graph_constructor.hpp"
 #include "modules/path_extend/scaffolder2015/path_polisher.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <unordered_set>
 
@@ -319,7 +320,7 @@ void PathExtendLauncher::AddScaffUniqueStorage(size_t uniqe_edge_len) {
     additional_edge_analyzer.FillUniqueEdgeStorage(unique_data_.unique_storages_.back());
 }
 
-Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &generator) {
+void PathExtendLauncher::FillMPUniqueEdgeStorages() {
     const pe_config::ParamSetT &pset = params_.pset;
 
     size_t cur_length = unique_data_.min_unique_length_ - pset.scaffolding2015.unique_length_step;
@@ -334,8 +335,6 @@ Extenders PathExtendLauncher::ConstructMPExtenders(const ExtendersGenerator &gen
         INFO("Will add final extenders for length " << lower_bound);
         AddScaffUniqueStorage(lower_bound);
     }
-
-    return generator.MakeMPExtenders();
 }
 
 void PathExtendLauncher::FillPathContainer(size_t lib_index, size_t size_threshold) {
@@ -407,43 +406,53 @@ void  PathExtendLauncher::FillPBUniqueEdgeStorages() {
     INFO(unique_data_.unique_pb_storage_.size() << " unique edges");
 }
 
-Extenders PathExtendLauncher::ConstructPBExtenders(const ExtendersGenerator &generator) {
-    FillPBUniqueEdgeStorages();
-    return generator.MakePBScaffoldingExtenders();
-}
+void PathExtendLauncher::PrepareExtenders() {
+    bool plasmid = config::PipelineHelper::IsPlasmidPipeline(params_.mode);
+    if (!plasmid && (support_.SingleReadsMapped() || support_.HasLongReads()))
+        FillLongReadsCoverageMaps();
 
+    if (params_.pset.sm == scaffolding_mode::sm_old)
+        return;
+
+    if (!plasmid && support_.HasLongReads())
+        FillPBUniqueEdgeStorages();
+
+    if (support_.HasMPReads())
+        FillMPUniqueEdgeStorages();
+}
 
 Extenders PathExtendLauncher::ConstructExtenders(const GraphCoverageMap &cover_map,
-                                                 UsedUniqueStorage &used_unique_storage) {
-    INFO("Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
-    if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) &&  (support_.SingleReadsMapped() || support_.HasLongReads()))
-        FillLongReadsCoverageMaps();
+                                                 UsedUniqueStorage &used_unique_storage,
+                                                 SharedExtenderData &shared_data,
+                                                 logging::level log_level) const {
+    LOG_MSG(log_level, "Creating main extenders, unique edge length = " << unique_data_.min_unique_length_);
     ExtendersGenerator generator(dataset_info_, params_, gp_, cover_map,
-                                 unique_data_, used_unique_storage, support_);
+                                 unique_data_, used_unique_storage, support_,
+                                 shared_data, log_level);
     Extenders extenders = generator.MakeBasicExtenders();
 
     //long reads scaffolding extenders.
 
     if (!config::PipelineHelper::IsPlasmidPipeline(params_.mode) && support_.HasLongReads()) {
         if (params_.pset.sm == scaffolding_mode::sm_old) {
-            INFO("Will not use new long read scaffolding algorithm in this mode");
+            LOG_MSG(log_level, "Will not use new long read scaffolding algorithm in this mode");
         } else {
-            utils::push_back_all(extenders, ConstructPBExtenders(generator));
+            utils::push_back_all(extenders, generator.MakePBScaffoldingExtenders());
         }
     }
 
     if (support_.HasMPReads()) {
         if (params_.pset.sm == scaffolding_mode::sm_old) {
-            INFO("Will not use mate-pairs is this mode");
+            LOG_MSG(log_level, "Will not use mate-pairs is this mode");
         } else {
-            utils::push_back_all(extenders, ConstructMPExtenders(generator));
+            utils::push_back_all(extenders, generator.MakeMPExtenders());
         }
     }
 
     if (params_.pset.use_coordinated_coverage)
         utils::push_back_all(extenders, generator.MakeCoverageExtenders());
 
-    INFO("Total number of extenders is " << extenders.size());
+    LOG_MSG(log_level, "Total number of extenders is " << extenders.size());
     return extenders;
 }
 
@@ -625,13 +634,26 @@ void PathExtendLauncher::Launch() {
     if (params_.pe_cfg.debug_output)
         MakeConjugateEdgePairsDump(graph_);
 
+    PrepareExtenders();
+
     GraphCoverageMap cover_map(graph_);
     UsedUniqueStorage used_unique_storage(unique_data_.main_unique_storage_, graph_);
-    Extenders extenders = ConstructExtenders(cover_map, used_unique_storage);
+    SharedExtenderData shared_data;
+    Extenders extenders = ConstructExtenders(cover_map, used_unique_storage, shared_data);
     CompositeExtender composite_extender(graph_, cover_map,
                                          used_unique_storage,
                                          extenders);
 
+    size_t nthreads = omp_get_max_threads();
+    if (params_.pe_cfg.parallel_growth && nthreads > 1) {
+        INFO("Seeds will be grown in " << nthreads << " threads");
+        composite_extender.EnableParallelGrowth([this, &shared_data](GraphCoverageMap &cover_map,
+                                                                     UsedUniqueStorage &used_unique_storage) {
+                                                    return ConstructExtenders(cover_map, used_unique_storage,
+                                                                              shared_data, logging::L_DEBUG);
+                                                }, nthreads);
+    }
+
     auto paths = resolver.ExtendSeeds(seeds, composite_extender);
     DebugOutputPaths(paths, "raw_paths");
 
@@ -54,6 +54,8 @@ class PathExtendLauncher {
 
     void FillPBUniqueEdgeStorages();
 
+    void FillMPUniqueEdgeStorages();
+
     void FillPathContainer(size_t lib_index, size_t size_threshold = 1);
 
     void FillLongReadsCoverageMaps();
@@ -70,14 +72,15 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    //Fills the data shared by all extenders, should be called before ConstructExtenders
+    void PrepareExtenders();
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    // Extra copies of extenders (e.g. for parallel growth) are made with log_level = L_DEBUG
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage,
+                                 SharedExtenderData &shared_data, logging::level log_level = logging::L_INFO) const;
 
     void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
-
     void FilterPaths();
 
     void AddFLPaths(PathContainer& paths) const;
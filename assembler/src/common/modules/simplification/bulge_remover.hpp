@@ -171,20 +171,28 @@ public:
 
     }
 
-    void operator()(EdgeId edge, const std::vector<EdgeId>& path) {
-        if (opt_callback_ && opt_callback_(edge, path)) {
-                return;
+    //Glues the edge to the path, but leaves the ends of the bulge uncompressed. Returns false if the callback
+    //rejected the bulge. Bulges sharing no vertices (including conjugate ones) could be projected concurrently.
+    bool Project(EdgeId edge, const std::vector<EdgeId>& path) {
+        bool skip = false;
+        #pragma omp critical(bulge_gluer_callbacks)
+        {
+            if (opt_callback_ && opt_callback_(edge, path)) {
+                skip = true;
+            } else if (removal_handler_) {
+                removal_handler_(edge);
+            }
         }
-
-        if (removal_handler_)
-            removal_handler_(edge);
-
-        VertexId start = g_.EdgeStart(edge);
-        VertexId end = g_.EdgeEnd(edge);
+        if (skip)
+            return false;
 
         TRACE("Projecting edge " << g_.str(edge));
         InnerProcessBulge(edge, path);
+        return true;
+    }
 
+    //Compression involves edges adjacent to the bulge, so it is never done concurrently
+    void CompressEnds(VertexId start, VertexId end) {
         if (!g_.RelatedVertices(start, end)) {
             TRACE("Compressing start vertex " << g_.str(start));
             g_.CompressVertex(start);
@@ -194,6 +202,14 @@ public:
         g_.CompressVertex(end);
     }
 
+    void operator()(EdgeId edge, const std::vector<EdgeId>& path) {
+        VertexId start = g_.EdgeStart(edge);
+        VertexId end = g_.EdgeEnd(edge);
+
+        if (Project(edge, path))
+            CompressEnds(start, end);
+    }
+
 };
 
 template<class Graph>
@@ -399,11 +415,24 @@ template<class Graph>
 class ParallelBulgeRemover : public PersistentAlgorithmBase<Graph> {
 private:
     static const size_t SMALL_BUFFER_THR = 1000;
+    //rounds with fewer candidates are not worth searching in parallel
+    static const size_t SMALL_ROUND_THR = 100;
+    //search is repeated at most MAX_ROUNDS times per buffer and while every round glues
+    //at least 1 / MIN_ROUND_YIELD of its candidates, the rest is processed in the usual way
+    static const size_t MAX_ROUNDS = 8;
+    static const size_t MIN_ROUND_YIELD = 4;
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
     typedef InterestingFinderPtr<Graph, EdgeId> CandidateFinderPtr;
     typedef SmartSetIterator<Graph, EdgeId, CoverageComparator<Graph>> SmartEdgeSet;
-    typedef phmap::flat_hash_set<EdgeId> EdgeSet;
+    typedef phmap::flat_hash_set<VertexId> VertexSet;
+
+    struct RoundStats {
+        size_t rounds = 0;
+        size_t max_rounds = 0;
+        size_t conflicts = 0;
+        size_t serial = 0;
+    };
     
     size_t buff_size_;
     double buff_cov_diff_;
@@ -415,6 +444,7 @@ private:
     bool tracking_;
 
     SmartEdgeSet it_;
+    RoundStats stats_;
 
     static std::vector<EdgeId> EmptyPath() {
         return {};
@@ -472,27 +502,27 @@ private:
         return smart_set;
     }
 
-    bool CheckInteracting(const BulgeInfo &info, const EdgeSet &involved_edges) const {
-        if (involved_edges.count(info.e))
-            return true;
-        for (EdgeId e : info.alternative)
-            if (involved_edges.count(e))
-                return true;
-        return false;
+    std::vector<VertexId> BulgeVertices(const BulgeInfo &info) const {
+        std::vector<VertexId> vertices = { this->g().EdgeStart(info.e), this->g().EdgeEnd(info.e) };
+        for (size_t i = 0; i + 1 < info.alternative.size(); ++i)
+            vertices.push_back(this->g().EdgeEnd(info.alternative[i]));
+        return vertices;
     }
 
-    void AccountEdge(EdgeId e, EdgeSet& involved_edges) const {
-        TRACE("Pushing edge " << this->g().str(e));
-        involved_edges.insert(e);
-        EdgeId conj = this->g().conjugate(e);
-        TRACE("Pushing edge " << this->g().str(conj));
-        involved_edges.insert(conj);
+    //bulges are independent if their vertices (and conjugate ones) do not intersect:
+    //glueing one of them can neither touch the edges of the other, nor compress its vertices
+    bool CheckInteracting(const std::vector<VertexId> &vertices, const VertexSet &involved_vertices) const {
+        for (VertexId v : vertices)
+            if (involved_vertices.count(v))
+                return true;
+        return false;
     }
 
-    void AccountEdges(const BulgeInfo& info, EdgeSet& involved_edges) const {
-        AccountEdge(info.e, involved_edges);
-        for (EdgeId e : info.alternative) {
-            AccountEdge(e, involved_edges);
+    void AccountVertices(const std::vector<VertexId> &vertices, VertexSet &involved_vertices) const {
+        for (VertexId v : vertices) {
+            TRACE("Pushing vertex " << this->g().str(v));
+            involved_vertices.insert(v);
+            involved_vertices.insert(this->g().conjugate(v));
         }
     }
 
@@ -583,18 +613,18 @@ private:
 
         std::vector<BulgeInfo> filtered;
         filtered.reserve(bulges.size());
-        //fixme switch to involved vertices to bring fully parallel glueing closer
-        EdgeSet involved_edges;
+        VertexSet involved_vertices;
         SmartEdgeSet interacting_edges(this->g(), false, CoverageComparator<Graph>(this->g()));
 
         for (BulgeInfo& info : bulges) {
             TRACE("Analyzing interactions of " << info.str(this->g()));
-            if (CheckInteracting(info, involved_edges)) {
+            auto vertices = BulgeVertices(info);
+            if (CheckInteracting(vertices, involved_vertices)) {
                 TRACE("Interacting");
                 interacting_edges.push(info.e);
             } else {
                 TRACE("Independent");
-                AccountEdges(info, involved_edges);
+                AccountVertices(vertices, involved_vertices);
                 filtered.push_back(std::move(info));
             }
         }
@@ -623,23 +653,78 @@ private:
         return triggered;
     }
 
-    size_t ProcessBulges(const std::vector<BulgeInfo>& independent_bulges, SmartEdgeSet& interacting_edges) {
+    //Independent bulges do not share vertices, so they are glued concurrently. New elements are reserved
+    //in advance and the handlers which are not thread-safe get the events one at a time (see ObservableGraph).
+    //Compression of the bulge ends merges the edges adjacent to other bulges, it is done sequentially afterwards.
+    size_t GlueBulges(const std::vector<BulgeInfo>& independent_bulges) {
         DEBUG("Processing bulges");
         utils::perf_counter perf;
 
-        size_t triggered = 0;
+        const size_t n = independent_bulges.size();
+        size_t path_edges = 0;
+        for (const BulgeInfo& info : independent_bulges)
+            path_edges += info.alternative.size();
+        //every edge of the path may take a split (vertex and two edges, with conjugates) and a glue
+        this->g().reserve_new(2 * path_edges, 6 * path_edges);
 
-        for (const BulgeInfo& info : independent_bulges) {
+        std::vector<std::pair<VertexId, VertexId>> ends(n);
+        std::vector<char> projected(n);
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < n; ++i) {
+            const BulgeInfo& info = independent_bulges[i];
             TRACE("Processing bulge " << info.str(this->g()));
-            triggered++;
-            gluer_(info.e, info.alternative);
+            ends[i] = { this->g().EdgeStart(info.e), this->g().EdgeEnd(info.e) };
+            projected[i] = gluer_.Project(info.e, info.alternative);
+        }
+        DEBUG("Independent bulges projected in " << perf.time() << " seconds");
+
+        for (size_t i = 0; i < n; ++i) {
+            if (projected[i])
+                gluer_.CompressEnds(ends[i].first, ends[i].second);
         }
 
         DEBUG("Independent bulges glued in " << perf.time() << " seconds");
-        perf.reset();
+        return n;
+    }
 
-        DEBUG("Processing remaining interacting bulges " << interacting_edges.size());
-        triggered += BasicProcessBulges(interacting_edges);
+    //Alternatives for all the edges of the round are searched in parallel, then independent bulges are glued.
+    //Interacting bulges are not glued right away, their edges (the ones that survived the glueing)
+    //are passed to the next round, where the alternatives are looked for in parallel once again.
+    //Every round glues at least one bulge, but the search is repeated for all the remaining edges, so
+    //the rounds stop once their yield drops (or their number reaches MAX_ROUNDS), as well as on small rounds.
+    //The remaining edges are processed in the usual way.
+    size_t ProcessBulges(std::vector<EdgeId> edges) {
+        size_t triggered = 0;
+        size_t rounds = 0;
+        bool proceed = true;
+        while (proceed && edges.size() >= SMALL_ROUND_THR) {
+            ++rounds;
+            size_t candidates = edges.size();
+            auto bulges = MergeBuffers(FindBulges(edges));
+            size_t found = bulges.size();
+            auto interacting_edges = RetainIndependentBulges(bulges);
+            size_t glued = GlueBulges(bulges);
+            triggered += glued;
+
+            DEBUG("Round " << rounds << ": " << candidates << " candidates, " << found << " bulges, "
+                  << glued << " glued, " << interacting_edges.size() << " interacting");
+            stats_.conflicts += interacting_edges.size();
+
+            //the first round searches the whole buffer, where most of the edges are not bulges
+            proceed = rounds < MAX_ROUNDS && (rounds == 1 || glued * MIN_ROUND_YIELD >= candidates);
+
+            edges.clear();
+            for (; !interacting_edges.IsEnd(); ++interacting_edges)
+                edges.push_back(*interacting_edges);
+        }
+        stats_.rounds += rounds;
+        stats_.max_rounds = std::max(stats_.max_rounds, rounds);
+
+        DEBUG("Processing remaining interacting bulges " << edges.size());
+        utils::perf_counter perf;
+        stats_.serial += edges.size();
+        auto remaining = AsSmartSet(edges);
+        triggered += BasicProcessBulges(remaining);
         DEBUG("Interacting edges processed in " << perf.time() << " seconds");
         return triggered;
     }
@@ -696,6 +781,7 @@ public:
             DEBUG(it_.size() << " edges to process");
         }
 
+        stats_ = RoundStats();
         size_t triggered = 0;
         bool proceed = true;
         while (proceed) {
@@ -716,9 +802,7 @@ public:
                 inner_triggered = BasicProcessBulges(edges);
                 DEBUG("Small buffer processed in " << perf.time() << " seconds");
             } else {
-                auto bulges = MergeBuffers(FindBulges(edge_buffer));
-                auto interacting_edges = RetainIndependentBulges(bulges);
-                inner_triggered = ProcessBulges(bulges, interacting_edges);
+                inner_triggered = ProcessBulges(std::move(edge_buffer));
             }
 
             proceed |= (inner_triggered > 0);
@@ -727,6 +811,10 @@ public:
         }
 
         DEBUG("Finished processing. Triggered = " << triggered);
+        if (stats_.rounds) {
+            INFO("Parallel bulge search rounds: " << stats_.rounds << " (at most " << stats_.max_rounds << " per buffer), "
+                 "interacting bulges postponed: " << stats_.conflicts << ", edges processed sequentially: " << stats_.serial);
+        }
         if (!tracking_)
             it_.Detach();
 
@@ -57,6 +57,15 @@ class ConcurrentPairedBuffer : public PairedBufferBase<ConcurrentPairedBuffer<G,
         this->size_ = 0;
     }
 
+    /**
+     * @brief Adds a histogram of inner (gapped) points between two edges and its conjugate,
+     *        merging weights with already existing points. Safe to call concurrently.
+     */
+    template<class OtherHist>
+    void MergeHist(EdgeId e1, EdgeId e2, const OtherHist &h) {
+        base::Merge(e1, e2, h);
+    }
+
     typename StorageMap::locked_table lock_table() {
         return storage_.lock_table();
     }
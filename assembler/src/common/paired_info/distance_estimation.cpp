@@ -14,10 +14,32 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
     return m[e2];
 }
 
+GraphDistanceFinder::PathLengthsPtr GraphDistanceFinder::GetPathLengths(VertexId start, size_t length_bound) const {
+    size_t thread = omp_get_thread_num();
+    if (thread >= caches_.size())
+        return std::make_shared<PathLengths>(graph_, start, length_bound);
+
+    PathLengthsCache &cache = caches_[thread];
+    for (const auto &entry : cache.entries) {
+        if (entry->start() == start && entry->length_bound() == length_bound)
+            return entry;
+    }
+
+    auto path_lengths = std::make_shared<PathLengths>(graph_, start, length_bound);
+    if (cache.entries.size() < CACHE_SIZE) {
+        cache.entries.push_back(path_lengths);
+    } else {
+        cache.entries[cache.next] = path_lengths;
+        cache.next = (cache.next + 1) % CACHE_SIZE;
+    }
+    return path_lengths;
+}
+
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    std::vector<size_t> path_lower_bounds;
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+    PathLengthsPtr path_lengths = GetPathLengths(graph_.EdgeEnd(e1), path_upper_bound);
+    // Truncated enumerations are reproduced by enumerating the paths, as it was done for all the edges before
+    std::unique_ptr<PathProcessor<Graph>> paths_proc;
 
     for (auto &entry : second_edges) {
         EdgeId e2 = entry.first;
@@ -26,21 +48,28 @@ void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second
 
         TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
 
-        DistancesLengthsCallback<Graph> callback(graph_);
-        paths_proc.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
-        GraphLengths lengths = callback.distances();
-        for (size_t j = 0; j < lengths.size(); ++j) {
+        GraphLengths lengths;
+        if (e1 == e2)
+            lengths.push_back(0);
+        size_t first = lengths.size();
+        if (path_lengths->Complete(graph_.EdgeStart(e2))) {
+            path_lengths->Lengths(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, lengths);
+        } else {
+            if (!paths_proc)
+                paths_proc = std::make_unique<PathProcessor<Graph>>(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+            DistancesLengthsCallback<Graph> callback(graph_);
+            paths_proc->Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
+            auto distances = callback.distances();
+            lengths.insert(lengths.end(), distances.begin(), distances.end());
+        }
+        for (size_t j = first; j < lengths.size(); ++j) {
             lengths[j] += graph_.length(e1);
             TRACE("Resulting distance set for " <<
                                                 " edge " << graph_.int_id(e2) <<
                                                 " #" << j << " length " << lengths[j]);
         }
 
-        if (e1 == e2)
-            lengths.push_back(0);
-
-        std::sort(lengths.begin(), lengths.end());
-        entry.second = lengths;
+        entry.second = std::move(lengths);
     }
 }
 
@@ -11,7 +11,7 @@
 #include "utils/parallel/openmp_wrapper.h"
 #include "assembly_graph/core/basic_graph_stats.hpp"
 #include "assembly_graph/core/graph.hpp"
-#include "assembly_graph/paths/path_processor.hpp"
+#include "assembly_graph/paths/bounded_path_lengths.hpp"
 
 #include "paired_info/pair_info_bounds.hpp"
 #include "paired_info.hpp"
@@ -22,15 +22,20 @@ namespace omnigraph {
 namespace de {
 
 //todo move to some more common place
+// Lengths of paths from the same vertex are requested for all the edges ending there and by all the estimators
+// sharing the finder, so each thread keeps the few last computed sets of path lengths.
+// The graph should not be modified while the finder is alive.
 class GraphDistanceFinder {
     typedef std::vector<debruijn_graph::EdgeId> Path;
     typedef std::vector<size_t> GraphLengths;
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
+    typedef BoundedPathLengths<debruijn_graph::Graph> PathLengths;
+    typedef std::shared_ptr<const PathLengths> PathLengthsPtr;
 
 public:
     GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
             graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
-            delta_((double) delta) { }
+            delta_((double) delta), caches_(omp_get_max_threads()) { }
 
     std::vector<size_t> GetGraphDistancesLengths(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
 
@@ -38,11 +43,22 @@ public:
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
 private:
+    // Number of path length sets kept by each thread
+    static const size_t CACHE_SIZE = 8;
+
+    struct PathLengthsCache {
+        std::vector<PathLengthsPtr> entries;
+        size_t next = 0;
+    };
+
+    PathLengthsPtr GetPathLengths(debruijn_graph::VertexId start, size_t length_bound) const;
+
     DECL_LOGGER("GraphDistanceFinder");
     const debruijn_graph::Graph &graph_;
     const size_t insert_size_;
     const int gap_;
     const double delta_;
+    mutable std::vector<PathLengthsCache> caches_;
 };
 
 class AbstractDistanceEstimator {
@@ -8,7 +8,9 @@
 #ifndef PAIR_INFO_FILLER_HPP_
 #define PAIR_INFO_FILLER_HPP_
 
+#include "paired_info/paired_info.hpp"
 #include "paired_info/concurrent_pair_info_buffer.hpp"
+#include "paired_info/staged_pair_info_buffer.hpp"
 #include "modules/alignment/sequence_mapper_notifier.hpp"
 
 namespace debruijn_graph {
@@ -17,6 +19,8 @@ namespace debruijn_graph {
  * As for now it ignores sophisticated case of repeated consecutive
  * occurrence of edge in path due to gaps in mapping
  *
+ * Points are collected either into per-thread staging areas (staged_buffer)
+ * or directly into the shared concurrent buffer
  */
 class LatePairedIndexFiller : public SequenceMapperListener {
     typedef std::pair<EdgeId, EdgeId> EdgePair;
@@ -25,42 +29,51 @@ public:
 
     LatePairedIndexFiller(const Graph &graph, WeightF weight_f,
                           unsigned round_distance,
-                          omnigraph::de::UnclusteredPairedInfoIndexT<Graph>& paired_index)
+                          omnigraph::de::UnclusteredPairedInfoIndexT<Graph>& paired_index,
+                          bool staged_buffer = true)
             : weight_f_(std::move(weight_f)),
               paired_index_(paired_index),
+              staged_buffer_(staged_buffer),
               buffer_pi_(graph),
-              round_distance_(round_distance) {}
+              staged_pi_(graph),
+              round_distance_(round_distance),
+              nthreads_(1) {}
 
-    void StartProcessLibrary(size_t) override {
+    void StartProcessLibrary(size_t threads_count) override {
         DEBUG("Start processing: start");
+        nthreads_ = threads_count;
         buffer_pi_.clear();
+        staged_pi_.clear(staged_buffer_ ? threads_count : 0);
         DEBUG("Start processing: end");
     }
 
     void StopProcessLibrary() override {
-        // paired_index_.Merge(buffer_pi_);
-        paired_index_.MoveAssign(buffer_pi_);
+        if (staged_buffer_)
+            staged_pi_.MoveInto(paired_index_, unsigned(nthreads_));
+        else
+            paired_index_.MoveAssign(buffer_pi_);
         buffer_pi_.clear();
     }
     
-    void ProcessPairedRead(size_t,
+    void ProcessPairedRead(size_t thread_index,
                            const io::PairedRead& r,
                            const MappingPath<EdgeId>& read1,
                            const MappingPath<EdgeId>& read2) override {
-        ProcessPairedRead(read1, read2, r.distance());
+        ProcessPairedRead(thread_index, read1, read2, r.distance());
     }
 
-    void ProcessPairedRead(size_t,
+    void ProcessPairedRead(size_t thread_index,
                            const io::PairedReadSeq& r,
                            const MappingPath<EdgeId>& read1,
                            const MappingPath<EdgeId>& read2) override {
-        ProcessPairedRead(read1, read2, r.distance());
+        ProcessPairedRead(thread_index, read1, read2, r.distance());
     }
 
     virtual ~LatePairedIndexFiller() {}
 
 private:
-    void ProcessPairedRead(const MappingPath<EdgeId>& path1,
+    void ProcessPairedRead(size_t thread_index,
+                           const MappingPath<EdgeId>& path1,
                            const MappingPath<EdgeId>& path2, size_t read_distance) {
         for (size_t i = 0; i < path1.size(); ++i) {
             std::pair<EdgeId, MappingRange> mapping_edge_1 = path1[i];
@@ -84,8 +97,11 @@ private:
                     if (round_distance_ > 1)
                         edge_distance = int(std::round(edge_distance / double(round_distance_))) * round_distance_;
 
-                    buffer_pi_.Add(mapping_edge_1.first, mapping_edge_2.first,
-                                   omnigraph::de::RawPoint(edge_distance, weight));
+                    omnigraph::de::RawPoint point(edge_distance, weight);
+                    if (staged_buffer_)
+                        staged_pi_.Add(thread_index, mapping_edge_1.first, mapping_edge_2.first, point);
+                    else
+                        buffer_pi_.Add(mapping_edge_1.first, mapping_edge_2.first, point);
 
                 }
             }
@@ -95,8 +111,11 @@ private:
 private:
     WeightF weight_f_;
     omnigraph::de::UnclusteredPairedInfoIndexT<Graph>& paired_index_;
+    bool staged_buffer_;
     omnigraph::de::ConcurrentPairedInfoBuffer<Graph> buffer_pi_;
+    omnigraph::de::StagedPairedInfoBuffer<Graph> staged_pi_;
     unsigned round_distance_;
+    size_t nthreads_;
 
     DECL_LOGGER("LatePairedIndexFiller");
 };
@@ -649,6 +649,10 @@ public:
 
         }
     }
+
+    bool IsBatchable() const override {
+        return true;
+    }
 };
 
 /**
@@ -0,0 +1,298 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "concurrent_pair_info_buffer.hpp"
+#include "histogram.hpp"
+#include "index_point.hpp"
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <queue>
+#include <tuple>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Write-only buffer of paired info filled concurrently by several threads.
+ *        Unlike ConcurrentPairedBuffer, no shared structure is touched during filling: every thread appends
+ *        (canonical edge pair, point) entries to its own staging area, which is sorted and collapsed
+ *        into sorted runs once it grows large enough. Runs of the thread are merged LSM-style, so that
+ *        their sizes decrease geometrically. Once the runs of a thread exceed the given number of entries,
+ *        they are spilled into an internal ConcurrentPairedBuffer, bounding the staging memory.
+ *        Finally, all runs are merged into the same concurrent buffer in a parallel k-way pass partitioned
+ *        by the first edge of the pair, which is then moved into the paired index.
+ * @param G graph type
+ * @param Traits Policy-like structure with associated types of inner and resulting points
+ * @param Container map-like container type of the internal concurrent buffer
+ */
+template<typename G, typename Traits, template<typename, typename> class Container>
+class StagedPairedBuffer {
+  public:
+    typedef G Graph;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::pair<EdgeId, EdgeId> EdgePair;
+    typedef typename Traits::Expanded Point;
+
+  private:
+    typedef typename Traits::Gapped InnerPoint;
+    typedef omnigraph::de::Histogram<InnerPoint> InnerHistogram;
+
+    struct Entry {
+        EdgeId e1, e2;
+        InnerPoint p;
+
+        bool same_pair(const Entry &rhs) const {
+            return e1 == rhs.e1 && e2 == rhs.e2;
+        }
+
+        bool operator<(const Entry &rhs) const {
+            if (std::tie(e1, e2) < std::tie(rhs.e1, rhs.e2))
+                return true;
+            if (std::tie(rhs.e1, rhs.e2) < std::tie(e1, e2))
+                return false;
+            return p < rhs.p;
+        }
+    };
+
+    typedef std::vector<Entry> Run;
+    typedef typename Run::const_iterator RunIterator;
+    typedef std::pair<RunIterator, RunIterator> RunRange;
+
+    struct ThreadBuffer {
+        Run staging;
+        std::vector<Run> runs;
+        // Total size of the runs
+        size_t sealed = 0;
+    };
+
+    typedef ConcurrentPairedBuffer<G, Traits, Container> MergedBuffer;
+
+    // Number of staged entries per thread triggering the sort into a run
+    static const size_t STAGING_SIZE = 1 << 16;
+    // Number of key range partitions per thread in the final merge
+    static const size_t PARTS_PER_THREAD = 4;
+
+  public:
+    // Default number of sealed entries per thread triggering the spill (~100 Mb per thread)
+    static const size_t MAX_SEALED = 1 << 22;
+
+    StagedPairedBuffer(const Graph &g, size_t nthreads = 1, size_t max_sealed = MAX_SEALED)
+            : graph_(g), merged_(g), max_sealed_(max_sealed),
+              staging_size_(max_sealed < STAGING_SIZE ? max_sealed : STAGING_SIZE) {
+        clear(nthreads);
+    }
+
+    //---------------- Data inserting methods ----------------
+    /**
+     * @brief Adds a point between two edges to the staging area of a given thread.
+     *        Different threads may call it simultaneously, given they use different thread indices.
+     */
+    void Add(size_t thread, EdgeId e1, EdgeId e2, Point p) {
+        VERIFY(thread < buffers_.size());
+        InnerPoint sp = Traits::Shrink(p, graph_.length(e1));
+        EdgePair ep(e1, e2), conj(graph_.conjugate(e2), graph_.conjugate(e1));
+        if (conj < ep)
+            std::swap(ep, conj);
+
+        ThreadBuffer &buffer = buffers_[thread];
+        buffer.staging.push_back({ ep.first, ep.second, sp });
+        if (buffer.staging.size() >= staging_size_) {
+            Seal(buffer);
+            if (buffer.sealed > max_sealed_)
+                Spill(buffer);
+            buffer.staging.reserve(staging_size_);
+        }
+    }
+
+    //---------------- Miscellaneous ----------------
+
+    /**
+     * @brief Drops all the staged data and prepares the buffer for a given number of threads.
+     */
+    void clear(size_t nthreads) {
+        buffers_.clear();
+        buffers_.resize(nthreads);
+        merged_.clear();
+    }
+
+    /**
+     * @brief Returns the total number of staged entries (the same point added twice may be counted twice)
+     *        plus the size of the spilled info.
+     */
+    size_t size() const {
+        size_t res = merged_.size();
+        for (const auto &buffer : buffers_)
+            res += buffer.staging.size() + buffer.sealed;
+        return res;
+    }
+
+    const Graph &graph() const { return graph_; }
+
+    /**
+     * @brief Replaces the contents of the index with all the buffered info and clears the buffer.
+     */
+    template<class Index>
+    void MoveInto(Index &index, unsigned nthreads) {
+        size_t nbuffers = buffers_.size();
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (size_t i = 0; i < nbuffers; ++i)
+            Seal(buffers_[i]);
+
+        std::vector<const Run*> runs;
+        for (const auto &buffer : buffers_)
+            for (const auto &run : buffer.runs)
+                runs.push_back(&run);
+
+        std::vector<EdgeId> splitters = Splitters(runs, nthreads * PARTS_PER_THREAD);
+        size_t nparts = splitters.size() + 1;
+        DEBUG("Merging " << runs.size() << " runs in " << nparts << " partitions");
+
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (size_t part = 0; part < nparts; ++part) {
+            std::vector<RunRange> ranges;
+            for (const Run *run : runs) {
+                auto b = (part == 0 ? run->begin() : LowerBound(*run, splitters[part - 1]));
+                auto e = (part + 1 == nparts ? run->end() : LowerBound(*run, splitters[part]));
+                if (b != e)
+                    ranges.emplace_back(b, e);
+            }
+            MergeRanges(ranges);
+        }
+
+        index.MoveAssign(merged_);
+        clear(nbuffers);
+    }
+
+  private:
+    static void Collapse(Run &run) {
+        size_t out = 0;
+        for (size_t i = 0; i < run.size(); ++i) {
+            // Entries are sorted, so "not less" means the same pair and distance
+            if (out && !(run[out - 1] < run[i]))
+                run[out - 1].p += run[i].p;
+            else
+                run[out++] = run[i];
+        }
+        run.resize(out);
+    }
+
+    static void Seal(ThreadBuffer &buffer) {
+        if (buffer.staging.empty())
+            return;
+
+        Run run;
+        run.swap(buffer.staging);
+        std::sort(run.begin(), run.end());
+        Collapse(run);
+        buffer.sealed += run.size();
+        buffer.runs.push_back(std::move(run));
+
+        // Keep run sizes geometrically decreasing, so each entry is re-merged O(log) times
+        auto &runs = buffer.runs;
+        while (runs.size() > 1 && runs[runs.size() - 2].size() <= 2 * runs.back().size()) {
+            Run &first = runs[runs.size() - 2], &second = runs.back();
+            Run merged;
+            merged.reserve(first.size() + second.size());
+            std::merge(first.begin(), first.end(), second.begin(), second.end(),
+                       std::back_inserter(merged));
+            buffer.sealed -= first.size() + second.size();
+            Collapse(merged);
+            buffer.sealed += merged.size();
+            runs.pop_back();
+            runs.back().swap(merged);
+        }
+    }
+
+    // Moves the runs of the thread into the concurrent buffer, other threads may still add points
+    void Spill(ThreadBuffer &buffer) {
+        DEBUG("Spilling " << buffer.sealed << " entries");
+        std::vector<RunRange> ranges;
+        for (const Run &run : buffer.runs)
+            ranges.emplace_back(run.begin(), run.end());
+        MergeRanges(ranges);
+
+        std::vector<Run>().swap(buffer.runs);
+        buffer.sealed = 0;
+    }
+
+    static RunIterator LowerBound(const Run &run, EdgeId e) {
+        return std::lower_bound(run.begin(), run.end(), e,
+                                [](const Entry &entry, EdgeId edge) { return entry.e1 < edge; });
+    }
+
+    static std::vector<EdgeId> Splitters(const std::vector<const Run*> &runs, size_t nparts) {
+        const size_t SAMPLES_PER_PART = 16;
+
+        size_t total = 0;
+        for (const Run *run : runs)
+            total += run->size();
+        if (nparts <= 1 || total == 0)
+            return {};
+
+        size_t step = std::max<size_t>(1, total / (nparts * SAMPLES_PER_PART));
+        std::vector<EdgeId> samples;
+        for (const Run *run : runs)
+            for (size_t i = 0; i < run->size(); i += step)
+                samples.push_back((*run)[i].e1);
+        std::sort(samples.begin(), samples.end());
+
+        std::vector<EdgeId> splitters;
+        for (size_t i = 1; i < nparts; ++i) {
+            EdgeId e = samples[i * samples.size() / nparts];
+            if (splitters.empty() || splitters.back() < e)
+                splitters.push_back(e);
+        }
+        return splitters;
+    }
+
+    void MergeRanges(std::vector<RunRange> &ranges) {
+        auto greater = [](const RunRange &a, const RunRange &b) { return *b.first < *a.first; };
+        std::priority_queue<RunRange, std::vector<RunRange>, decltype(greater)> heap(greater, std::move(ranges));
+
+        InnerHistogram hist;
+        const Entry *last = nullptr;
+        while (!heap.empty()) {
+            RunRange range = heap.top();
+            heap.pop();
+
+            const Entry &entry = *range.first;
+            if (last && !last->same_pair(entry)) {
+                merged_.MergeHist(last->e1, last->e2, hist);
+                hist.clear();
+            }
+            hist.merge_point(entry.p);
+            last = &entry;
+
+            if (++range.first != range.second)
+                heap.push(range);
+        }
+        if (last)
+            merged_.MergeHist(last->e1, last->e2, hist);
+    }
+
+    const Graph &graph_;
+    std::vector<ThreadBuffer> buffers_;
+    MergedBuffer merged_;
+    size_t max_sealed_;
+    size_t staging_size_;
+
+    DECL_LOGGER("StagedPairedBuffer");
+};
+
+template<class Graph>
+using StagedPairedInfoBuffer = StagedPairedBuffer<Graph, RawPointTraits, btree_map>;
+
+} // namespace de
+
+} // namespace omnigraph
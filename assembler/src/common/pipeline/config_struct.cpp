@@ -396,6 +396,7 @@ void load(debruijn_config::distance_estimator& de,
   load(de.raw_filter_threshold, pt, "raw_filter_threshold", complete);
   load(de.rounding_coeff, pt, "rounding_coeff", complete);
   load(de.rounding_thr, pt, "rounding_threshold", complete);
+  de.staged_paired_buffer = pt.get("staged_paired_buffer", true);
 }
 
 void load(debruijn_config::smoothing_distance_estimator& ade,
@@ -701,6 +702,9 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
     load(cfg.log_filename, pt, "log_filename");
 
     cfg.checkpoints = ModeByName<Checkpoints>(pt.get("checkpoints", "none"), {"none", "last", "all"});
+    cfg.async_checkpoints = pt.get("async_checkpoints", false);
+    cfg.compact_graph = pt.get("compact_graph", false);
+    cfg.batch_graph_events = pt.get("batch_graph_events", false);
 
     load(cfg.developer_mode, pt, "developer_mode");
     if (cfg.developer_mode) {
@@ -322,6 +322,7 @@ struct debruijn_config {
         unsigned raw_filter_threshold;
         double rounding_thr;
         double rounding_coeff;
+        bool staged_paired_buffer;
     };
 
     struct smoothing_distance_estimator {
@@ -431,6 +432,9 @@ struct debruijn_config {
     std::string output_dir;
     std::string tmp_dir;
     Checkpoints checkpoints;
+    bool async_checkpoints;
+    bool compact_graph;
+    bool batch_graph_events;
     std::string output_saves;
     std::string log_filename;
     std::string series_analysis;
@@ -7,6 +7,7 @@
 
 #include "io/dataset_support/read_converter.hpp"
 #include "io/binary/graph_pack.hpp"
+#include "assembly_graph/dijkstra/dijkstra_workspace.hpp"
 
 #include "pipeline/stage.hpp"
 
@@ -46,8 +47,16 @@ void AssemblyStage::save(const debruijn_graph::GraphPack& gp,
     fs::make_dir(dir);
 
     auto p = fs::append_path(dir, BASE_NAME);
-    io::binary::FullPackIO().Save(p, gp);
     debruijn_graph::config::write_lib_data(p);
+    if (parent_ && parent_->saves_policy().Async()) {
+        // Only the file images are taken here, the next stage could modify the pack while they are being written
+        auto images = std::make_shared<io::binary::FileImages>();
+        io::binary::FullPackIO().Snapshot(p, gp, *images);
+        INFO("Images of " << images->size() << " bytes taken, writing in background");
+        parent_->background_saver().Run([images] { images->Write(); });
+    } else {
+        io::binary::FullPackIO().Save(p, gp);
+    }
 }
 
 class StageIdComparator {
@@ -107,6 +116,7 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
             composite_id += ":";
             composite_id += prev_phase->id();
             TIME_TRACE_SCOPE("load phase", composite_id);
+            StageProfiler::Scope profile(parent_->profiler(), "load", composite_id, prev_phase->name(), id());
             prev_phase->load(gp, parent_->saves_policy().LoadPath(), composite_id.c_str());
         }
     }
@@ -117,6 +127,8 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
         INFO("PROCEDURE == " << phase->name() << " (id: " << id() << ":" << phase->id() << ")");
         {
             TIME_TRACE_SCOPE(phase->name());
+            StageProfiler::Scope profile(parent_->profiler(), "phase",
+                                         std::string(id()) + ":" + phase->id(), phase->name(), id());
             phase->run(gp, started_from);
         }
 
@@ -126,6 +138,7 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
             composite_id += phase->id();
 
             TIME_TRACE_SCOPE("save phase", composite_id);
+            StageProfiler::Scope profile(parent_->profiler(), "save", composite_id, phase->name(), id());
             phase->save(gp, parent_->saves_policy().SavesPath(), composite_id.c_str());
             //TODO: currently no phases are writing saves.
             //When they will, erase the previous saves when SavesPolicy::Last
@@ -167,6 +180,7 @@ void StageManager::run(debruijn_graph::GraphPack& g,
 
         {
             TIME_TRACE_SCOPE("load", saves_policy_.LoadPath());
+            StageProfiler::Scope profile(profiler(), "load", saves_policy_.LoadPath());
             while (start_stage != stages_.begin()) {
                 try {
                     (*std::prev(start_stage))->load(g, saves_policy_.LoadPath());
@@ -186,21 +200,41 @@ void StageManager::run(debruijn_graph::GraphPack& g,
         stage->prepare(g, start_from);        
         {
             TIME_TRACE_SCOPE(stage->name());
+            StageProfiler::Scope profile(profiler(), "stage", stage->id(), stage->name());
             stage->run(g, start_from);
         }
+        // Search workspaces are sized by the graph of the stage, do not keep them for the next one
+        omnigraph::ReleaseIdleDijkstraWorkspaces();
 
         if (saves_policy_.EnabledCheckpoints() != SavesPolicy::Checkpoints::None) {
-            auto prev_saves = saves_policy_.GetLastCheckpoint();
             {
                 TIME_TRACE_SCOPE("save", saves_policy_.SavesPath());
+                StageProfiler::Scope profile(profiler(), "save", stage->id(), stage->name());
                 stage->save(g, saves_policy_.SavesPath());
             }
-            saves_policy_.UpdateCheckpoint(stage->id());
-            if (!prev_saves.empty() && saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
-                fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
-            }
+            // The checkpoint is updated only when the save is completely written
+            auto update_checkpoint = [this, id = stage->id()] {
+                auto prev_saves = saves_policy_.GetLastCheckpoint();
+                saves_policy_.UpdateCheckpoint(id);
+                if (!prev_saves.empty() && saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
+                    fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
+                }
+            };
+            if (saves_policy_.Async())
+                background_saver_.Run(update_checkpoint);
+            else
+                update_checkpoint();
         }
     }
+
+    if (saves_policy_.Async()) {
+        TIME_TRACE_SCOPE("wait for saves", saves_policy_.SavesPath());
+        StageProfiler::Scope profile(profiler(), "wait for saves", saves_policy_.SavesPath());
+        background_saver_.Wait();
+    }
+
+    if (profiler_)
+        profiler_->Write(profile_report_);
 }
 
 }
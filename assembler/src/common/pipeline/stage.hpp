@@ -10,12 +10,15 @@
 
 #include "pipeline/graph_pack.hpp"
 #include "pipeline/config_struct.hpp"
+#include "pipeline/stage_profiler.hpp"
 
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/logger/logger.hpp"
 
-#include <vector>
+#include <functional>
 #include <memory>
+#include <thread>
+#include <vector>
 
 namespace spades {
 
@@ -45,7 +48,7 @@ private:
     const char *id_;
 
 protected:
-    const StageManager *parent_;
+    StageManager *parent_;
 
     friend class StageManager;
 };
@@ -158,16 +161,19 @@ public:
     using Checkpoints = debruijn_graph::config::Checkpoints;
 
     SavesPolicy()
-            : checkpoints_(Checkpoints::None), saves_path_("") {
+            : checkpoints_(Checkpoints::None), saves_path_(""), async_(false) {
     }
 
     SavesPolicy(Checkpoints checkpoints,
-                const std::string &saves_path, const std::string &load_path = "")
-            : checkpoints_(checkpoints), saves_path_(saves_path) {
+                const std::string &saves_path, const std::string &load_path = "",
+                bool async = false)
+            : checkpoints_(checkpoints), saves_path_(saves_path), async_(async) {
         load_path_ = (load_path == "" ? saves_path_ : load_path);
     }
 
     Checkpoints EnabledCheckpoints() const { return checkpoints_; }
+    /// Checkpoints are written to disk in background while the next stage is running
+    bool Async() const { return async_; }
     const std::string & SavesPath() const { return saves_path_; }
     const std::string & LoadPath() const { return load_path_; }
 
@@ -189,6 +195,37 @@ private:
     Checkpoints checkpoints_;
     std::string saves_path_;
     std::string load_path_;
+    bool async_;
+};
+
+/**
+ * @brief  Runs jobs one by one in the background thread. The caller is never blocked, each job
+ *         is started as soon as the previous one is finished.
+ */
+class BackgroundSaver {
+public:
+    BackgroundSaver() = default;
+    BackgroundSaver(const BackgroundSaver &) = delete;
+    BackgroundSaver &operator=(const BackgroundSaver &) = delete;
+
+    ~BackgroundSaver() { Wait(); }
+
+    void Run(std::function<void()> job) {
+        std::thread prev = std::move(thread_);
+        thread_ = std::thread([prev = std::move(prev), job = std::move(job)]() mutable {
+            if (prev.joinable())
+                prev.join();
+            job();
+        });
+    }
+
+    void Wait() {
+        if (thread_.joinable())
+            thread_.join();
+    }
+
+private:
+    std::thread thread_;
 };
 
 class StageManager {
@@ -218,11 +255,29 @@ public:
         return saves_policy_;
     }
 
+    BackgroundSaver &background_saver() {
+        return background_saver_;
+    }
+
+    /// Resources used by every stage and phase are written to report_file once the pipeline is finished
+    void enable_profiling(const std::string &report_file) {
+        profiler_.reset(new StageProfiler());
+        profile_report_ = report_file;
+    }
+
+    /// Null if profiling is not enabled
+    StageProfiler *profiler() {
+        return profiler_.get();
+    }
+
 private:
     using Stages = std::vector<std::unique_ptr<AssemblyStage> >;
 
     Stages stages_;
     SavesPolicy saves_policy_;
+    BackgroundSaver background_saver_;
+    std::unique_ptr<StageProfiler> profiler_;
+    std::string profile_report_;
 
     DECL_LOGGER("StageManager");
 };
@@ -0,0 +1,114 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "stage_profiler.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/JSON.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace spades {
+
+StageProfiler::Scope::Scope(StageProfiler *profiler, const char *kind, std::string id, std::string name,
+                            std::string parent)
+        : profiler_(profiler) {
+    if (!profiler_)
+        return;
+
+    record_.kind = kind;
+    record_.id = std::move(id);
+    record_.name = std::move(name);
+    record_.parent = std::move(parent);
+    profiler_->Begin(record_);
+}
+
+StageProfiler::Scope::~Scope() {
+    if (profiler_)
+        profiler_->End(record_);
+}
+
+StageProfiler::StageProfiler()
+        : counters_(new utils::HardwareCounters()) {
+    if (counters_->any_available()) {
+        INFO("Hardware counters are available for profiling");
+    } else {
+        INFO("Hardware counters are not available, profiling report will contain times, memory and I/O only");
+    }
+}
+
+void StageProfiler::Begin(Record &record) const {
+    record.begin = utils::get_resource_usage();
+    record.counters_begin = counters_->read();
+}
+
+void StageProfiler::End(Record &record) {
+    record.counters_end = counters_->read();
+    record.end = utils::get_resource_usage();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.push_back(record);
+}
+
+void StageProfiler::Write(const std::string &filename) const {
+    std::error_code ec;
+    llvm::raw_fd_ostream os(filename, ec, llvm::sys::fs::OF_Text);
+    if (ec) {
+        WARN("Cannot write profiling report to " << filename << ": " << ec.message());
+        return;
+    }
+
+    llvm::json::OStream json(os, 2);
+    json.object([&] {
+        json.attribute("version", 1);
+        json.attribute("threads", omp_get_max_threads());
+        json.attributeObject("hardware_counters", [&] {
+            for (size_t i = 0; i < utils::HardwareCounters::CounterCount; ++i) {
+                auto counter = utils::HardwareCounters::Counter(i);
+                json.attribute(utils::HardwareCounters::name(counter), counters_->available(counter));
+            }
+        });
+        json.attributeArray("records", [&] {
+            for (const Record &record : records_) {
+                const auto &begin = record.begin, &end = record.end;
+                double wall_time = end.wall_time - begin.wall_time, cpu_time = end.cpu_time - begin.cpu_time;
+                json.object([&] {
+                    json.attribute("kind", record.kind);
+                    json.attribute("id", record.id);
+                    json.attribute("name", record.name);
+                    json.attribute("parent", record.parent.empty() ? llvm::json::Value(nullptr) : record.parent);
+                    json.attribute("wall_time", wall_time);
+                    json.attribute("cpu_time", cpu_time);
+                    json.attribute("cpu_utilization", wall_time > 0 ? cpu_time / wall_time : 0.);
+                    json.attribute("rss_begin", int64_t(begin.rss));
+                    json.attribute("rss_end", int64_t(end.rss));
+                    json.attribute("rss_delta", int64_t(end.rss) - int64_t(begin.rss));
+                    json.attribute("max_rss", int64_t(end.max_rss));
+                    json.attribute("max_rss_increase", int64_t(end.max_rss) - int64_t(begin.max_rss));
+                    json.attribute("read_bytes", int64_t(end.read_bytes - begin.read_bytes));
+                    json.attribute("written_bytes", int64_t(end.written_bytes - begin.written_bytes));
+                    json.attribute("disk_read_bytes", int64_t(end.disk_read_bytes - begin.disk_read_bytes));
+                    json.attribute("disk_written_bytes", int64_t(end.disk_written_bytes - begin.disk_written_bytes));
+                    for (size_t i = 0; i < utils::HardwareCounters::CounterCount; ++i) {
+                        auto counter = utils::HardwareCounters::Counter(i);
+                        if (counters_->available(counter))
+                            json.attribute(utils::HardwareCounters::name(counter),
+                                           int64_t(record.counters_end[i] - record.counters_begin[i]));
+                        else
+                            json.attribute(utils::HardwareCounters::name(counter), nullptr);
+                    }
+                });
+            }
+        });
+    });
+    os << "\n";
+
+    INFO("Profiling report is written to: " << filename);
+}
+
+}
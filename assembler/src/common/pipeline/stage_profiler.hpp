@@ -0,0 +1,63 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/perf/resource_usage.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace spades {
+
+/**
+ * @brief  Collects resources used by stages and phases of the pipeline (times, memory, I/O and hardware
+ *         counters when available) and writes them as the JSON report.
+ */
+class StageProfiler {
+public:
+    struct Record {
+        std::string kind;
+        std::string id;
+        std::string name;
+        std::string parent;
+        utils::ResourceUsage begin, end;
+        utils::HardwareCounters::Values counters_begin, counters_end;
+    };
+
+    /// Measures the resources used during its lifetime, does nothing if the profiler is null
+    class Scope {
+    public:
+        Scope(StageProfiler *profiler, const char *kind, std::string id, std::string name = "",
+              std::string parent = "");
+        ~Scope();
+
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        StageProfiler *profiler_;
+        Record record_;
+    };
+
+    StageProfiler();
+
+    const std::vector<Record> &records() const { return records_; }
+
+    void Write(const std::string &filename) const;
+
+private:
+    void Begin(Record &record) const;
+    void End(Record &record);
+
+    std::unique_ptr<utils::HardwareCounters> counters_;
+    std::vector<Record> records_;
+    std::mutex mutex_;
+};
+
+}
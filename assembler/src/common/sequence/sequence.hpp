@@ -7,13 +7,17 @@
 
 #pragma once
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <string>
 #include <memory>
+#include <mutex>
 #include <cstring>
 
 #include "seq.hpp"
 #include "rtseq.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <llvm/ADT/IntrusiveRefCntPtr.h>
 #include <llvm/Support/TrailingObjects.h>
@@ -22,7 +26,11 @@
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 
+class NuclArena;
+
 class Sequence {
+    friend class NuclArena;
+
     // Type to store Seq in Sequences
     typedef seq_element_type ST;
     // Number of bits in ST
@@ -71,7 +79,8 @@ class Sequence {
     template<typename S>
     void InitFromNucls(const S &s, bool rc = false) {
         size_t bytes_size = DataSize(size_);
-        ST *bytes = data_->data();
+        // Sequence might start inside the shared buffer (see NuclArena), but always at ST boundary
+        ST *bytes = data_->data() + (from_ >> STNBits);
 
         VERIFY(is_dignucl(s[0]) || is_nucl(s[0]));
 
@@ -131,6 +140,9 @@ class Sequence {
     Sequence(const Sequence &seq, size_t from, size_t size, bool rtl)
             : size_(size), from_(from), rtl_(rtl), data_(seq.data_) {}
 
+    Sequence(llvm::IntrusiveRefCntPtr<ManagedNuclBuffer> data, size_t from, size_t size)
+            : size_(size), from_(from), rtl_(false), data_(std::move(data)) {}
+
 public:
     /**
      * Sequence initialization (arbitrary size string)
@@ -275,6 +287,14 @@ public:
         return size() == 0;
     }
 
+    // Number of elements needed to store packed nucleotides
+    size_t data_size() const {
+        return DataSize(size_);
+    }
+
+    // Packs nucleotides into data_size() elements starting from dst, as if the sequence was not a view
+    inline void copy_data(seq_element_type *dst) const;
+
     template<class Seq>
     bool contains(const Seq& s, size_t offset = 0) const {
         VERIFY_DEV(offset + s.size() <= size());
@@ -288,6 +308,8 @@ public:
 
 public:
     inline bool BinRead(std::istream &file);
+    // Reads sequence stored by BinWrite from memory buffer, returns the pointer past the read data
+    inline const char *BinRead(const char *buf);
     inline bool BinWrite(std::ostream &file) const;
 };
 
@@ -427,11 +449,60 @@ bool Sequence::BinRead(std::istream &file) {
     return !file.fail();
 }
 
+const char *Sequence::BinRead(const char *buf) {
+    size_t size;
+    memcpy(&size, buf, sizeof(size));
+    buf += sizeof(size);
+
+    size_ = size;
+    from_ = 0;
+    rtl_ = false;
+
+    size_t bytes = DataSize(size_) * sizeof(ST);
+    data_ = llvm::IntrusiveRefCntPtr<ManagedNuclBuffer>(ManagedNuclBuffer::create(size_));
+    memcpy(data_->data(), buf, bytes);
+
+    return buf + bytes;
+}
+
+void Sequence::copy_data(ST *dst) const {
+    size_t n = DataSize(size_);
+    if (!n)
+        return;
+
+    if (rtl_) {
+        memset(dst, 0, n * sizeof(ST));
+        for (size_t i = 0; i < size_; ++i)
+            dst[i >> STNBits] |= ST(operator[](i)) << ((i & (STN - 1)) << 1);
+        return;
+    }
+
+    const ST *src = data_->data() + (from_ >> STNBits);
+    size_t shift = (from_ & (STN - 1)) << 1;
+    if (shift == 0) {
+        memcpy(dst, src, n * sizeof(ST));
+    } else {
+        // Index of the last source element holding nucleotides of the sequence
+        size_t last = ((from_ + size_ - 1) >> STNBits) - (from_ >> STNBits);
+        for (size_t i = 0; i < n; ++i)
+            dst[i] = (src[i] >> shift) | (i < last ? src[i + 1] << (STBits - shift) : 0);
+    }
+
+    // Clear the tail, the source might be a prefix of a longer sequence
+    if (size_ & (STN - 1))
+        dst[n - 1] &= (ST(1) << ((size_ & (STN - 1)) << 1)) - 1;
+}
 
 bool Sequence::BinWrite(std::ostream &file) const {
     if (from_ != 0 || rtl_) {
-        Sequence clear(this->str());
-        return clear.BinWrite(file);
+        std::vector<ST> data(DataSize(size_));
+        copy_data(data.data());
+
+        size_t size = size_;
+        file.write((const char *) &size, sizeof(size));
+        file.write((const char *) data.data(), data.size() * sizeof(ST));
+
+        return !file.fail();
     }
 
     WriteHeader(file);
@@ -441,6 +512,143 @@ bool Sequence::BinWrite(std::ostream &file) const {
     return !file.fail();
 }
 
+/**
+ * @class NuclArena
+ * @section DESCRIPTION
+ *
+ * Bump allocator packing nucleotides of many sequences contiguously into large shared buffers (slabs).
+ * Sequences produced by the arena are ordinary Sequence's viewing a part of the slab, so no separate
+ * allocation is made per sequence and the slab is released once the last sequence referencing it dies.
+ * Sequences can be produced by several threads simultaneously, each OpenMP thread fills its own slab.
+ */
+class NuclArena {
+    typedef Sequence::ST ST;
+    typedef llvm::IntrusiveRefCntPtr<Sequence::ManagedNuclBuffer> Buffer;
+
+    // Slab sizes (in ST elements, i.e. 1 KB to 64 KB) grow geometrically from MIN_SLAB to MAX_SLAB. Slabs are
+    // kept small, since a single surviving sequence keeps the whole slab alive, and all sequences of a slab
+    // share its refcounter
+    static constexpr size_t MIN_SLAB = 1 << 7;
+    static constexpr size_t MAX_SLAB = 1 << 13;
+    // Longer sequences are allocated separately
+    static constexpr size_t MAX_PACKED = MAX_SLAB / 16;
+
+    // Slab being filled by a thread. Threads share a shard only if there are more of them than of shards
+    // (e.g. the number of threads was increased after the arena was made), the lock is uncontended otherwise
+    struct Shard {
+        std::mutex lock;
+        Buffer slab;
+        size_t slab_size = 0;
+        size_t top = 0;
+    };
+
+  public:
+    NuclArena()
+            : shards_(std::max(omp_get_max_threads(), 1)), allocated_(0), slabs_(0) {}
+
+    NuclArena(const NuclArena &) = delete;
+    NuclArena &operator=(const NuclArena &) = delete;
+
+    /**
+     * @brief Makes the sequence from ACGT or 0123-string s (see Sequence(const S &s, bool rc))
+     */
+    template<typename S>
+    Sequence Make(const S &s, bool rc = false) {
+        if (s.size() == 0)
+            return Sequence();
+
+        Sequence res = Allocate(s.size());
+        res.InitFromNucls(s, rc);
+        return res;
+    }
+
+    /**
+     * @brief Copies nucleotides of the sequence into the arena
+     */
+    Sequence Copy(const Sequence &s) {
+        if (s.size() == 0)
+            return Sequence();
+
+        Sequence res = Allocate(s.size());
+        s.copy_data(res.data_->data() + (res.from_ >> Sequence::STNBits));
+        return res;
+    }
+
+    /**
+     * @brief Makes the sequence from already packed nucleotides (e.g. mapped from a file) with a single copy.
+     *        The sequence gets a dedicated slab, so its subsequences could serve as separate sequences.
+     */
+    Sequence Adopt(const seq_element_type *data, size_t nucls) {
+        Sequence res(nucls, 0);
+        size_t n = Sequence::DataSize(nucls);
+        memcpy(res.data_->data(), data, n * sizeof(ST));
+
+        allocated_ += n;
+        slabs_ += 1;
+        return res;
+    }
+
+    /**
+     * @brief Stops filling the current slab. Sequences made afterwards never share slabs with earlier ones,
+     *        so the latter are released once all earlier sequences die (e.g. when re-packed).
+     */
+    void Reset() {
+        for (auto &shard : shards_) {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.slab.reset();
+            shard.top = shard.slab_size = 0;
+        }
+        allocated_ = 0;
+    }
+
+    // Total size of sequences packed since the last Reset() in bytes
+    size_t allocated() const { return allocated_ * sizeof(ST); }
+    // Total number of slabs ever created
+    size_t slabs() const { return slabs_; }
+
+    /**
+     * @return the number of bytes the sequence of given length takes in the arena, 0 for the sequences
+     *         allocated separately
+     */
+    static size_t PackedSize(size_t nucls) {
+        size_t n = Sequence::DataSize(nucls);
+        return n > MAX_PACKED ? 0 : n * sizeof(ST);
+    }
+
+  private:
+    Sequence Allocate(size_t nucls) {
+        size_t n = Sequence::DataSize(nucls);
+        if (n > MAX_PACKED)
+            return Sequence(nucls, 0);
+
+        Buffer slab;
+        size_t offset;
+        {
+            Shard &shard = shards_[size_t(omp_get_thread_num()) % shards_.size()];
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if (!shard.slab || shard.top + n > shard.slab_size) {
+                size_t size = std::min(std::max(2 * shard.slab_size, size_t(MIN_SLAB)), size_t(MAX_SLAB));
+                // Packed sequences could be longer than the small slabs
+                size = std::max(size, n);
+                shard.slab = Sequence::ManagedNuclBuffer::create(size << Sequence::STNBits);
+                shard.slab_size = size;
+                shard.top = 0;
+                slabs_ += 1;
+            }
+            slab = shard.slab;
+            offset = shard.top;
+            shard.top += n;
+        }
+        allocated_ += n;
+
+        return Sequence(std::move(slab), offset << Sequence::STNBits, nucls);
+    }
+
+    std::vector<Shard> shards_;
+    std::atomic<size_t> allocated_;
+    std::atomic<size_t> slabs_;
+};
+
 /**
  * @class SequenceBuilder
  * @section DESCRIPTION
@@ -468,6 +676,10 @@ public:
         return Sequence(buf_);
     }
 
+    Sequence BuildSequence(NuclArena &arena) {
+        return arena.Make(buf_);
+    }
+
     size_t size() const {
         return buf_.size();
     }
@@ -34,7 +34,7 @@ void SHWDistanceExtended(const std::string &target, const std::string &query, in
 int SHWDistance(const std::string &a, const std::string &b, int max_score, int &end_pos);
 
 inline Sequence MergeOverlappingSequences(const std::vector<Sequence>& ss,
-        size_t overlap, bool safe_merging = true) {
+        size_t overlap, bool safe_merging = true, NuclArena *arena = nullptr) {
     if (ss.empty()) {
         return Sequence();
     }
@@ -48,7 +48,7 @@ inline Sequence MergeOverlappingSequences(const std::vector<Sequence>& ss,
         }
         sb.append(it->Subseq(overlap));
     }
-    return sb.BuildSequence();
+    return arena ? sb.BuildSequence(*arena) : sb.BuildSequence();
 }
 
 //TODO:: should it be replaced by edlib fast edit distance?
@@ -368,8 +368,15 @@ public:
         INFO("Graph simplification started");
         printer_(info_printer_pos::before_simplification);
 
+        // Handlers of the info about edges (positions, paired info, k-mer mapping) are not consulted
+        // by the simplification, so they could receive the graph events in bulk once per simplification cycle
+        std::unique_ptr<omnigraph::EventBatch<Graph>> batch;
+        if (cfg::get().batch_graph_events)
+            batch = std::make_unique<omnigraph::EventBatch<Graph>>(g_);
         size_t iteration = 0;
         auto message_callback = [&] () {
+            if (batch)
+                batch->Flush();
             INFO("PROCEDURE == Simplification cycle, iteration " << ++iteration);
         };
 
@@ -439,6 +446,7 @@ void RawSimplification::run(GraphPack &gp, const char*) {
     } else {
         simplifier.InitialCleaning();
     }
+    gp.get_mutable<Graph>().CompactNuclsIfSparse();
 }
 
 void Simplification::run(GraphPack &gp, const char*) {
@@ -472,6 +480,7 @@ void Simplification::run(GraphPack &gp, const char*) {
                                printer);
     simplifier.SimplifyGraph();
     CompressAllVertices(gp.get_mutable<Graph>());
+    gp.get_mutable<Graph>().CompactNuclsIfSparse();
 }
 
 void SimplificationCleanup::run(GraphPack &gp, const char*) {
@@ -485,6 +494,7 @@ void SimplificationCleanup::run(GraphPack &gp, const char*) {
                                printer);
 
     simplifier.PostSimplification();
+    gp.get_mutable<Graph>().CompactNuclsIfSparse();
 
     DEBUG("Graph simplification finished");
 
@@ -137,10 +137,10 @@ class HllFiller {
 
     //Return value: should we interrupt reads processing
     template <class Read>
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(const Read &r) {
         unsigned thread_id = (unsigned)omp_get_thread_num();
         reads[thread_id] += 1;
-        const Sequence &seq = r->sequence();
+        const Sequence &seq = r.sequence();
         if (seq.size() < k) {
             return false;
         }
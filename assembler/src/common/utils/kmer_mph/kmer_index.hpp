@@ -82,6 +82,15 @@ public:
       return size_;
   }
 
+  size_t num_segments() const {
+      return num_segments_;
+  }
+
+  // Index range [start, end) occupied by k-mers of the given segment
+  std::pair<size_t, size_t> segment_range(size_t i) const {
+      return { segment_starts_[i], i + 1 < num_segments_ ? segment_starts_[i + 1] : size_ };
+  }
+
   size_t seq_idx(const KMerSeq &s) const {
     size_t bucket = seq_bucket(s);
     size_t idx = index_[bucket].lookup(s);
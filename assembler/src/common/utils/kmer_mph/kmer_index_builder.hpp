@@ -222,15 +222,18 @@ class KMerDiskCounter : public KMerCounter<Seq> {
   typedef typename traits::RawKMerStorage BucketStorage;
   typedef typename traits::ResultFile ResultFile;
 public:
+  /// Raw k-mers are counted in memory while they fit there, unless in_memory is false
   template<class Splitter>
   KMerDiskCounter(fs::TmpDir work_dir,
-                  Splitter splitter)
-      : __super(splitter.K()), splitter_(new Splitter{std::move(splitter)}), work_dir_(work_dir) {}
+                  Splitter splitter, bool in_memory = true)
+      : __super(splitter.K()), splitter_(new Splitter{std::move(splitter)}), work_dir_(work_dir) {
+    splitter_->set_allow_in_memory(in_memory);
+  }
 
   template<class Splitter>
   KMerDiskCounter(const std::string &work_dir,
-                  Splitter splitter)
-      : KMerDiskCounter(fs::tmp::make_temp_dir(work_dir, "kmer_counter"), std::move(splitter)) {}
+                  Splitter splitter, bool in_memory = true)
+      : KMerDiskCounter(fs::tmp::make_temp_dir(work_dir, "kmer_counter"), std::move(splitter), in_memory) {}
 
   ~KMerDiskCounter() {}
 
@@ -246,14 +249,18 @@ public:
     VERIFY(raw_kmers.size() == num_buckets);
     TIME_TRACE_END;
 
-    INFO("Starting k-mer counting.");
+    bool in_memory = splitter_->in_memory();
+    INFO("Starting k-mer counting" << (in_memory ? " in memory." : "."));
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
     size_t kmers = 0;
     {
         TIME_TRACE_SCOPE("KMerDiskCounter::Count");
 #       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
         for (size_t i = 0; i < raw_kmers.size(); ++i) {
-          kmers += MergeKMers(*raw_kmers[i], *res.create(i));
+          if (in_memory)
+            kmers += CountKMers(splitter_->ReleaseBucket(i), *res.create(i));
+          else
+            kmers += MergeKMers(*raw_kmers[i], *res.create(i));
           raw_kmers[i].reset();
         }
     }
@@ -278,6 +285,22 @@ private:
   std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
   fs::TmpDir work_dir_;
 
+  size_t CountKMers(adt::KMerVector<Seq> bucket, const std::string &ofname) {
+    libcxx::sort(bucket.begin(), bucket.end(), adt::array_less<typename Seq::DataType>());
+    auto it = std::unique(bucket.begin(), bucket.end(), adt::array_equal_to<typename Seq::DataType>());
+    size_t cnt = it - bucket.begin();
+
+    FILE *g = fopen(ofname.c_str(), "wb");
+    if (!g)
+      FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
+    size_t res = fwrite(bucket.data(), bucket.el_data_size(), cnt, g);
+    if (res != cnt)
+      FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+    fclose(g);
+
+    return cnt;
+  }
+
   size_t MergeKMers(const std::string &ifname, const std::string &ofname) {
     MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
 
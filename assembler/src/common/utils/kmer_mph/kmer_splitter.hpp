@@ -13,6 +13,7 @@
 #include "utils/filesystem/temporary.hpp"
 #include "utils/memory_limit.hpp"
 #include "utils/logger/logger.hpp"
+#include "utils/perf/perfcounter.hpp"
 
 #include <libcxx/sort.hpp>
 #include <string>
@@ -30,12 +31,22 @@ public:
             : KMerSplitter(fs::tmp::make_temp_dir(work_dir, "kmer_splitter"), K) {}
 
     KMerSplitter(fs::TmpDir work_dir, unsigned K)
-            : work_dir_(work_dir), K_(K) {}
+            : work_dir_(work_dir), K_(K), allow_in_memory_(true) {}
 
     virtual ~KMerSplitter() {}
 
     virtual RawKMers Split(size_t num_files, unsigned nthreads) = 0;
 
+    // Splitter might keep raw k-mers in memory if they fit there. In such case
+    // the files returned by Split() are not created and the k-mers of each
+    // bucket should be obtained via ReleaseBucket() instead.
+    virtual bool in_memory() const { return false; }
+    // Forces the raw k-mers to go to disk even if they would fit into memory
+    void set_allow_in_memory(bool allow) { allow_in_memory_ = allow; }
+    virtual adt::KMerVector<Seq> ReleaseBucket(size_t) {
+        FATAL_ERROR("Splitter does not keep k-mers in memory");
+    }
+
     size_t kmer_size() const {
         return Seq::GetDataSize(K_) * sizeof(typename Seq::DataType);
     }
@@ -47,6 +58,7 @@ protected:
     fs::TmpDir work_dir_;
     unsigned K_;
     KMerBuckets bucket_;
+    bool allow_in_memory_;
 
     DECL_LOGGER("K-mer Splitting");
 };
@@ -57,10 +69,24 @@ public:
     using typename KMerSplitter<Seq>::RawKMers;
 
     KMerSortingSplitter(const std::string &work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0),
+              in_memory_(false), in_memory_limit_(0), in_memory_used_(0), flushed_(0), write_time_(0) {}
 
     KMerSortingSplitter(fs::TmpDir work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0),
+              in_memory_(false), in_memory_limit_(0), in_memory_used_(0), flushed_(0), write_time_(0) {}
+
+    ~KMerSortingSplitter() {
+        CloseWriters();
+    }
+
+    bool in_memory() const override { return in_memory_; }
+
+    adt::KMerVector<Seq> ReleaseBucket(size_t idx) override {
+        VERIFY(in_memory_);
+        adt::KMerVector<Seq> res(std::move(kmer_buckets_.at(idx)));
+        return res;
+    }
 
 protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
@@ -70,6 +96,31 @@ protected:
     size_t cell_size_;
     size_t num_files_;
 
+    // Sorted runs of raw k-mers (concatenated) for each bucket, used while
+    // everything fits into memory
+    KMerBuffer kmer_buckets_;
+    bool in_memory_;
+    // Capacity of the buckets is accounted before they grow, so the limit holds for the memory actually allocated
+    size_t in_memory_limit_;
+    size_t in_memory_used_;
+
+    // Bucket file is kept open during the whole splitting, the sizes of runs
+    // are collected in memory and written to the index file on close. Every
+    // bucket is flushed by a single iteration of the dumping loop, so writers
+    // of different buckets proceed concurrently without any locking.
+    struct BucketWriter {
+        std::string fname;
+        FILE *file = nullptr;
+        std::vector<size_t> runs;
+    };
+    std::vector<BucketWriter> writers_;
+
+    // Write throughput of the flushes, reported at most once per FLUSH_REPORT_INTERVAL seconds
+    static constexpr double FLUSH_REPORT_INTERVAL = 10;
+    size_t flushed_;
+    double write_time_;
+    utils::perf_counter flush_report_timer_;
+
     RawKMers PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
         this->bucket_.reset(num_files);
@@ -80,6 +131,15 @@ protected:
         for (unsigned i = 0; i < num_files_; ++i)
             out.emplace_back(tmp_prefix->CreateDep(std::to_string(i)));
 
+        CloseWriters();
+        writers_.clear();
+        writers_.resize(num_files_);
+        for (unsigned i = 0; i < num_files_; ++i)
+            writers_[i].fname = out[i]->file();
+        flushed_ = 0;
+        write_time_ = 0;
+        flush_report_timer_.reset();
+
         size_t file_limit = num_files_ + 2*nthreads;
         size_t res = utils::limit_file(file_limit);
         if (res < file_limit) {
@@ -105,6 +165,18 @@ protected:
             entry.resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
         }
 
+        // Keep raw k-mers in memory until they occupy half of the memory
+        // available. The remaining half is for bucket growth and final sorting.
+        in_memory_limit_ = this->allow_in_memory_ ? utils::get_free_memory() / 2 : 0;
+        in_memory_ = (in_memory_limit_ > 0);
+        in_memory_used_ = 0;
+        kmer_buckets_.clear();
+        if (in_memory_) {
+            INFO("Raw k-mers will be kept in memory while they fit into " <<
+                 (double)in_memory_limit_ / 1024.0 / 1024.0 / 1024.0 << " Gb");
+            kmer_buckets_.resize(num_files_, adt::KMerVector<Seq>(this->K_));
+        }
+
         return out;
     }
 
@@ -118,9 +190,13 @@ protected:
     }
 
     void DumpBuffers(const RawKMers &ostreams) {
-        VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
+        VERIFY_MSG(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_,
+                   "Number of output files does not match the number of buckets");
 
-#   pragma omp parallel for
+        size_t written = 0;
+        double write_time = 0;
+        bool spill = false;
+#   pragma omp parallel for reduction(+ : written, write_time) reduction(|| : spill)
         for (size_t k = 0; k < num_files_; ++k) {
             // Below k is thread id!
 
@@ -136,37 +212,125 @@ protected:
             }
             libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
             auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
+            size_t cnt =  it - SortBuffer.begin();
 
-#     pragma omp critical
-            {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
+            if (in_memory_ && ReserveBucket(k, cnt)) {
+                auto &bucket = kmer_buckets_[k];
+                for (auto kit = SortBuffer.begin(); kit != it; ++kit)
+                    bucket.push_back(*kit);
+                continue;
             }
+            // The run which did not fit goes to disk along with the buckets spilled below
+            spill |= in_memory_;
+
+            utils::perf_counter pc;
+            written += WriteRun(k, SortBuffer, cnt);
+            write_time += pc.time();
         }
 
+        flushed_ += written;
+        write_time_ += write_time;
+        if (flush_report_timer_.time() >= FLUSH_REPORT_INTERVAL)
+            ReportFlushes();
+
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry)
                 eentry.clear();
+
+        if (spill)
+            SpillBuckets();
+    }
+
+    // Grows the bucket to take cnt more k-mers, unless this would exceed the memory limit
+    bool ReserveBucket(size_t k, size_t cnt) {
+        auto &bucket = kmer_buckets_[k];
+        size_t size = bucket.size() + cnt;
+        if (size <= bucket.capacity())
+            return true;
+
+        size_t capacity = std::max(size, 2 * bucket.capacity());
+        size_t grow = (capacity - bucket.capacity()) * this->kmer_size(), used;
+#       pragma omp atomic capture
+        used = in_memory_used_ += grow;
+        if (used > in_memory_limit_) {
+#           pragma omp atomic
+            in_memory_used_ -= grow;
+            return false;
+        }
+
+        bucket.reserve(capacity);
+        return true;
+    }
+
+    // Switch to disk-based splitting. Every bucket collected so far is turned
+    // into a single sorted run on disk.
+    void SpillBuckets() {
+        INFO("Raw k-mers do not fit into memory, switching to disk-based counting");
+
+#   pragma omp parallel for
+        for (size_t k = 0; k < num_files_; ++k) {
+            auto &bucket = kmer_buckets_[k];
+            libcxx::sort(bucket.begin(), bucket.end(), typename adt::KMerVector<Seq>::less2_fast());
+            auto it = std::unique(bucket.begin(), bucket.end(), typename adt::KMerVector<Seq>::equal_to());
+            WriteRun(k, bucket, it - bucket.begin());
+        }
+
+        kmer_buckets_.clear();
+        kmer_buckets_.shrink_to_fit();
+        in_memory_ = false;
+    }
+
+    size_t WriteRun(size_t k, const SeqKMerVector &buffer, size_t cnt) {
+        BucketWriter &writer = writers_[k];
+        if (!writer.file) {
+            writer.file = fopen(writer.fname.c_str(), "ab");
+            if (!writer.file)
+                FATAL_ERROR("Cannot open temporary file " << writer.fname << " for writing");
+        }
+
+        size_t res = fwrite(buffer.data(), buffer.el_data_size(), cnt, writer.file);
+        if (res != cnt)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        writer.runs.push_back(cnt);
+
+        return cnt * buffer.el_data_size();
+    }
+
+    void CloseWriters() {
+        for (auto &writer : writers_) {
+            if (!writer.file)
+                continue;
+
+            if (fclose(writer.file))
+                FATAL_ERROR("I/O error! Cannot close temporary file " << writer.fname << ". Reason: " << strerror(errno));
+            writer.file = nullptr;
+
+            // Write index
+            FILE *f = fopen((writer.fname + ".idx").c_str(), "wb");
+            if (!f)
+                FATAL_ERROR("Cannot open temporary file " << writer.fname << ".idx for writing");
+            size_t res = fwrite(writer.runs.data(), sizeof(size_t), writer.runs.size(), f);
+            if (res != writer.runs.size())
+                FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+            fclose(f);
+            writer.runs.clear();
+        }
+    }
+
+    // Time is summed over the threads, so this is the throughput of a single writer
+    void ReportFlushes() {
+        if (flushed_)
+            INFO("Flushed " << (double)flushed_ / 1024.0 / 1024.0 << " Mb of k-mers, writing at "
+                 << (write_time_ > 0 ? (double)flushed_ / 1024.0 / 1024.0 / write_time_ : 0.0) << " Mb/s per thread");
+        flushed_ = 0;
+        write_time_ = 0;
+        flush_report_timer_.reset();
     }
 
     void ClearBuffers() {
+        ReportFlushes();
+        CloseWriters();
+
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry) {
                 eentry.clear();
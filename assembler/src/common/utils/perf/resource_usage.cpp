@@ -0,0 +1,135 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "resource_usage.hpp"
+
+#include "memory.hpp"
+#include "utils/memory_limit.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+# include <linux/perf_event.h>
+# include <sys/syscall.h>
+#endif
+
+namespace utils {
+
+static double to_seconds(const timeval &tv) {
+    return double(tv.tv_sec) + double(tv.tv_usec) * 1e-6;
+}
+
+ResourceUsage get_resource_usage() {
+    ResourceUsage usage;
+    usage.wall_time = std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) == 0)
+        usage.cpu_time = to_seconds(ru.ru_utime) + to_seconds(ru.ru_stime);
+
+    unsigned long vm_usage;
+    long rss;
+    process_mem_usage(vm_usage, rss);
+    usage.rss = size_t(rss) * 1024;
+    usage.max_rss = get_max_rss() * 1024;
+
+    std::ifstream io("/proc/self/io");
+    std::string key;
+    uint64_t value;
+    while (io >> key >> value) {
+        if (key == "rchar:")
+            usage.read_bytes = value;
+        else if (key == "wchar:")
+            usage.written_bytes = value;
+        else if (key == "read_bytes:")
+            usage.disk_read_bytes = value;
+        else if (key == "write_bytes:")
+            usage.disk_written_bytes = value;
+    }
+
+    return usage;
+}
+
+#ifdef __linux__
+static int open_counter(uint32_t type, uint64_t config) {
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(__NR_perf_event_open, &attr, 0 /*this process*/, -1 /*any cpu*/, -1 /*no group*/, 0);
+}
+#endif
+
+HardwareCounters::HardwareCounters() {
+    fds_.fill(-1);
+#ifdef __linux__
+    fds_[Cycles] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES);
+    fds_[Instructions] = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS);
+    fds_[LLCMisses] = open_counter(PERF_TYPE_HW_CACHE,
+                                   PERF_COUNT_HW_CACHE_LL |
+                                   (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+#endif
+}
+
+HardwareCounters::~HardwareCounters() {
+    for (int fd : fds_) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+bool HardwareCounters::any_available() const {
+    for (int fd : fds_) {
+        if (fd >= 0)
+            return true;
+    }
+    return false;
+}
+
+HardwareCounters::Values HardwareCounters::read() const {
+    Values values;
+    values.fill(0);
+    for (size_t i = 0; i < CounterCount; ++i) {
+        if (fds_[i] < 0)
+            continue;
+
+        // Value, time enabled, time running. Counters could be multiplexed, so the value is scaled
+        uint64_t data[3];
+        if (::read(fds_[i], data, sizeof(data)) != sizeof(data) || data[2] == 0)
+            continue;
+        values[i] = data[2] < data[1] ? uint64_t(double(data[0]) * double(data[1]) / double(data[2])) : data[0];
+    }
+    return values;
+}
+
+const char *HardwareCounters::name(Counter counter) {
+    switch (counter) {
+        case Cycles:
+            return "cycles";
+        case Instructions:
+            return "instructions";
+        case LLCMisses:
+            return "llc_misses";
+        default:
+            return "unknown";
+    }
+}
+
+}
@@ -0,0 +1,61 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace utils {
+
+/**
+ * @brief  Snapshot of the resources used by the process so far. Memory and I/O are in bytes, times are in seconds.
+ *         CPU time is summed over all the threads, I/O counters are zero if /proc/self/io is not readable.
+ */
+struct ResourceUsage {
+    double wall_time = 0;
+    double cpu_time = 0;
+    size_t rss = 0;
+    size_t max_rss = 0;
+    uint64_t read_bytes = 0;
+    uint64_t written_bytes = 0;
+    uint64_t disk_read_bytes = 0;
+    uint64_t disk_written_bytes = 0;
+};
+
+ResourceUsage get_resource_usage();
+
+/**
+ * @brief  Cycles, instructions and last level cache misses of the process counted via perf_event_open(2).
+ *         Counters are inherited, so all the threads created after the counters were opened are counted,
+ *         the ones existing at that moment are not (besides the calling one).
+ *         Counters which could not be opened (no kernel support, perf_event_paranoid, etc.) are unavailable.
+ */
+class HardwareCounters {
+public:
+    enum Counter { Cycles = 0, Instructions, LLCMisses, CounterCount };
+
+    typedef std::array<uint64_t, CounterCount> Values;
+
+    HardwareCounters();
+    ~HardwareCounters();
+    HardwareCounters(const HardwareCounters &) = delete;
+    HardwareCounters &operator=(const HardwareCounters &) = delete;
+
+    bool available(Counter counter) const { return fds_[counter] >= 0; }
+    bool any_available() const;
+
+    /// Values of unavailable counters are zero
+    Values read() const;
+
+    static const char *name(Counter counter);
+
+private:
+    std::array<int, CounterCount> fds_;
+};
+
+}
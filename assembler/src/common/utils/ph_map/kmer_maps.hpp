@@ -33,21 +33,29 @@ private:
     typename traits::ResultFile kmers_file_;
     mutable std::unique_ptr<KMerStorage> kmers_;
 
-    void SortUniqueKMers() const {
+    // K-mers of every MPHF segment are stored contiguously and are mapped into
+    // the very same range, so segments could be reordered independently
+    void SortUniqueKMers(unsigned nthreads = 1) const {
         if (!kmers_)
             kmers_.reset(new KMerStorage(*kmers_file_, KMer::GetDataSize(base::k())));
 
         size_t swaps = 0;
+        size_t segments = this->index_ptr_->num_segments();
         INFO("Arranging kmers in hash map order");
-        for (auto I = kmers_->begin(), E = kmers_->end(); I != E; ++I) {
-            size_t cidx = I - kmers_->begin();
-            size_t kidx = this->raw_seq_idx(*I);
-            while (cidx != kidx) {
-                auto J = kmers_->begin() + kidx;
-                using std::swap;
-                swap(*I, *J);
-                swaps += 1;
-                kidx = this->raw_seq_idx(*I);
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic) reduction(+ : swaps)
+        for (size_t i = 0; i < segments; ++i) {
+            auto range = this->index_ptr_->segment_range(i);
+            for (auto I = kmers_->begin() + range.first, E = kmers_->begin() + range.second; I != E; ++I) {
+                size_t cidx = I - kmers_->begin();
+                size_t kidx = this->raw_seq_idx(*I);
+                while (cidx != kidx) {
+                    VERIFY_DEV(range.first <= kidx && kidx < range.second);
+                    auto J = kmers_->begin() + kidx;
+                    using std::swap;
+                    swap(*I, *J);
+                    swaps += 1;
+                    kidx = this->raw_seq_idx(*I);
+                }
             }
         }
         INFO("Done. Total swaps: " << swaps);
@@ -97,7 +97,7 @@ struct KeyStoringIndexBuilder {
         auto res = phm_builder_.BuildIndex(index, counter, bucket_num, thread_num, true);
         VERIFY(!index.kmers_.get());
         index.kmers_file_ = res.final_kmers();
-        index.SortUniqueKMers();
+        index.SortUniqueKMers((unsigned)thread_num);
     }
 
   private:
@@ -175,10 +175,12 @@ int main(int argc, char* argv[]) {
         bool keep_perfect_loops = true;
         std::vector<Sequence> edge_sequences;
         unsigned nchunks = 16 * omp_get_max_threads();
+        NuclArena arena;
+        debruijn_graph::UnbranchingPathExtractor extractor(ext_index, k, &arena);
         if (keep_perfect_loops)
-            edge_sequences = debruijn_graph::UnbranchingPathExtractor(ext_index, k).ExtractUnbranchingPathsAndLoops(nchunks);
+            edge_sequences = extractor.ExtractUnbranchingPathsAndLoops(nchunks);
         else
-            edge_sequences = debruijn_graph::UnbranchingPathExtractor(ext_index, k).ExtractUnbranchingPaths(nchunks);
+            edge_sequences = extractor.ExtractUnbranchingPaths(nchunks);
 
         if (cfg.mode == output_type::unitigs) {
             // Step 3: output stuff
@@ -43,6 +43,7 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   
   load(cfg.hamming_do, pt, "hamming_do");
   load(cfg.hamming_blocksize_quadratic_threshold, pt, "hamming_blocksize_quadratic_threshold");
+  cfg.hamming_in_memory = pt.get("hamming_in_memory", true);
 
   load(cfg.bayes_do, pt, "bayes_do");
   load(cfg.bayes_nthreads, pt, "bayes_nthreads");
@@ -77,6 +78,7 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   load(cfg.input_working_dir, pt, "input_working_dir");
   load(cfg.input_trim_quality, pt, "input_trim_quality");
   cfg.input_qvoffset_opt = pt.get_optional<int>("input_qvoffset");
+  cfg.input_cache_reads = pt.get("input_cache_reads", true);
   load(cfg.output_dir, pt, "output_dir");
 
   cfg.general_max_nthreads = spades_set_omp_threads(cfg.general_max_nthreads);
@@ -34,6 +34,7 @@ struct hammer_config {
   int input_trim_quality;
   boost::optional<int> input_qvoffset_opt;
   int input_qvoffset;
+  bool input_cache_reads;
   std::string output_dir;
 
   bool general_do_everything_after_first_iteration;
@@ -51,6 +52,7 @@ struct hammer_config {
 
   bool hamming_do;
   unsigned hamming_blocksize_quadratic_threshold;
+  bool hamming_in_memory;
 
   bool bayes_do;
   unsigned bayes_nthreads;
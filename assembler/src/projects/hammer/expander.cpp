@@ -17,11 +17,11 @@
 #include <vector>
 #include <cstring>
 
-bool Expander::operator()(std::unique_ptr<Read> r) {
+bool Expander::operator()(const Read &r) {
   uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
   // FIXME: Get rid of this
-  Read cr = *r;
+  Read cr = r;
   size_t sz = cr.trimNsAndBadQuality(trim_quality);
 
   if (sz < hammer::K)
@@ -11,12 +11,16 @@
 #include "kmer_stat.hpp"
 
 class KMerData;
+namespace hammer {
+class ReadCache;
+}
 
 struct Globals {
   static int iteration_no;
 
   static std::vector<uint32_t> * subKMerPositions;
   static KMerData *kmer_data;
+  static hammer::ReadCache *read_cache;
 
   static char char_offset;
   static bool char_offset_user;
@@ -8,12 +8,16 @@
 #include "hamcluster.hpp"
 
 #include "adt/concurrent_dsu.hpp"
+#include "adt/hamming_block.hpp"
 #include "io/kmers/mmapped_reader.hpp"
 #include "parallel_radix_sort.hpp"
 
 #include "config_struct_hammer.hpp"
 #include "globals.hpp"
 
+#include "utils/memory_limit.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -94,24 +98,166 @@ static void processBlockQuadratic(dsu::ConcurrentDSU  &uf,
                                   size_t block_size,
                                   const KMerData &data,
                                   unsigned tau) {
+  if (block_size < 2)
+    return;
+
+  // k-mers of the block are fetched once, distances to the rest of the block are computed at once
+  static thread_local adt::HammingBlock kmers(hammer::K);
+  static thread_local std::vector<unsigned> dist;
+  kmers.clear();
+  kmers.reserve(block_size);
+  for (size_t i = 0; i < block_size; ++i)
+    kmers.push_back(data.kmer(block[i]));
+  dist.resize(block_size);
+
   for (size_t i = 0; i < block_size; ++i) {
     size_t x = block[i];
-    hammer::KMer kmerx = data.kmer(x);
+    kmers.distances(i, i + 1, block_size, dist.data());
     for (size_t j = i + 1; j < block_size; j++) {
+      if (dist[j - i - 1] > tau)
+        continue;
+
       size_t y = block[j];
-      hammer::KMer kmery = data.kmer(y);
       if (!uf.same(x, y) &&
-          canMerge(uf, x, y) &&
-          hamdistKMer(kmerx, kmery, tau) <= tau) {
+          canMerge(uf, x, y)) {
         uf.unite(x, y);
       }
     }
   }
 }
 
+// Calls op(start, size) for every block of equal sub-k-mers in parallel. Every
+// block is processed by the thread owning the chunk the block starts in.
+template<class Op>
+static size_t processBlocks(const std::vector<SubKMer> &kmers, unsigned nthreads, Op &&op) {
+  size_t n = kmers.size(), nchunks = 16 * nthreads, nblocks = 0;
+
+# pragma omp parallel for num_threads(nthreads) schedule(dynamic) reduction(+:nblocks)
+  for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+    size_t start = chunk * n / nchunks, end = (chunk + 1) * n / nchunks;
+    while (start > 0 && start < end && kmers[start] == kmers[start - 1])
+      start += 1;
+
+    while (start < end) {
+      size_t block_end = std::upper_bound(kmers.begin() + start + 1, kmers.end(), kmers[start],
+                                          SubKMerComparator()) - kmers.begin();
+      op(start, block_end - start);
+      start = block_end;
+      nblocks += 1;
+    }
+  }
+
+  return nblocks;
+}
+
+bool KMerHamClusterer::fitsInMemory(const KMerData &data) const {
+  // Keys and values of a single projection together with the radix sort buffers,
+  // plus the indices of big blocks from all the projections in the worst case
+  size_t needed = data.size() * (2 * (sizeof(SubKMer) + sizeof(size_t)) + (tau_ + 1) * sizeof(size_t));
+  size_t free = utils::get_free_memory();
+  INFO("Sub-kmers need approx. " << needed / (1024 * 1024) << " MB of memory, "
+       << free / (1024 * 1024) << " MB is available");
+
+  return needed < free / 2;
+}
+
+void KMerHamClusterer::clusterInMemory(const KMerData &data, dsu::ConcurrentDSU &uf) {
+  using PairSort = parallel_radix_sort::PairSort<SubKMer, size_t, SubKMer, EncoderKMer>;
+  unsigned nthreads = cfg::get().general_max_nthreads;
+  unsigned block_thr = cfg::get().hamming_blocksize_quadratic_threshold;
+  size_t n = data.size();
+
+  std::vector<std::vector<std::vector<size_t>>> big_blocks(nthreads);
+  {
+    INFO("Splitting sub-kmers in memory, pass 1.");
+    std::vector<SubKMer> kmers(n);
+    std::vector<size_t> idx(n);
+    size_t nblocks = 0;
+    for (unsigned i = 0; i < tau_ + 1; ++i) {
+      size_t from = (*Globals::subKMerPositions)[i];
+      size_t to = (*Globals::subKMerPositions)[i+1];
+
+      INFO("Sorting: [" << from << ", " << to << ")");
+      SubKMerPartSerializer serializer(from, to);
+#     pragma omp parallel for num_threads(nthreads) schedule(static)
+      for (size_t j = 0; j < n; ++j) {
+        kmers[j] = serializer.serialize(data.kmer(j));
+        idx[j] = j;
+      }
+      PairSort::InitAndSort(kmers.data(), idx.data(), n, nthreads);
+
+      nblocks += processBlocks(kmers, nthreads, [&](size_t start, size_t sz) {
+        if (sz < block_thr) {
+          // Merge small blocks.
+          processBlockQuadratic(uf, idx.begin() + start, sz, data, tau_);
+        } else {
+          // Otherwise - keep for the next pass.
+          big_blocks[omp_get_thread_num()].emplace_back(idx.begin() + start, idx.begin() + start + sz);
+        }
+      });
+    }
+
+    size_t big_blocks1 = 0;
+    for (const auto &blocks : big_blocks)
+      big_blocks1 += blocks.size();
+
+    INFO("Splitting done."
+         " Processed " << tau_ + 1 << " blocks."
+         " Produced " << nblocks << " blocks.");
+    VERIFY(nblocks <= (tau_ + 1) * n);
+    INFO("Merge done, total " << big_blocks1 << " blocks left for the next pass.");
+  }
+
+  {
+    INFO("Splitting sub-kmers in memory, pass 2.");
+    std::vector<std::vector<size_t>*> blocks;
+    for (auto &thread_blocks : big_blocks)
+      for (auto &block : thread_blocks)
+        blocks.push_back(&block);
+
+    size_t nblocks = 0, big_blocks2 = 0;
+#   pragma omp parallel for num_threads(nthreads) schedule(dynamic) reduction(+:nblocks, big_blocks2)
+    for (size_t b = 0; b < blocks.size(); ++b) {
+      const std::vector<size_t> &block = *blocks[b];
+      std::vector<SubKMer> kmers(block.size());
+      std::vector<size_t> idx(block.size());
+      for (unsigned i = 0; i < tau_ + 1; ++i) {
+        SubKMerStridedSerializer serializer(i, tau_ + 1);
+        for (size_t j = 0; j < block.size(); ++j) {
+          kmers[j] = serializer.serialize(data.kmer(block[j]));
+          idx[j] = block[j];
+        }
+        PairSort::InitAndSort(kmers.data(), idx.data(), kmers.size(), 1);
+
+        for (auto start = kmers.begin(), end = kmers.end(); start != end;) {
+          auto chunk_end = std::upper_bound(start + 1, end, *start, SubKMerComparator());
+          size_t sz = chunk_end - start;
+          if (sz > 50)
+            big_blocks2 += 1;
+          processBlockQuadratic(uf, idx.begin() + (start - kmers.begin()), sz, data, tau_);
+          start = chunk_end;
+          nblocks += 1;
+        }
+      }
+      std::vector<size_t>().swap(*blocks[b]);
+    }
+
+    INFO("Splitting done."
+         " Processed " << (tau_ + 1) * blocks.size() << " blocks."
+         " Produced " << nblocks << " blocks.");
+    VERIFY(nblocks <= (tau_ + 1) * (tau_ + 1) * n);
+    INFO("Merge done, saw " << big_blocks2 << " big blocks out of " << nblocks << " processed.");
+  }
+}
+
 void KMerHamClusterer::cluster(const std::string &prefix,
                                const KMerData &data,
                                dsu::ConcurrentDSU &uf) {
+  if (cfg::get().hamming_in_memory && fitsInMemory(data)) {
+    clusterInMemory(data, uf);
+    return;
+  }
+
   // First pass - split & sort the k-mers
   std::string fname = prefix + ".first", bfname = fname + ".blocks", kfname = fname + ".kmers";
   std::ofstream bfs(bfname, std::ios::out | std::ios::binary);
@@ -146,6 +146,11 @@ class KMerHamClusterer {
 
   void cluster(const std::string &prefix, const KMerData &data, dsu::ConcurrentDSU &uf);
  private:
+  // Sub-k-mers are sorted in memory and the blocks are processed concurrently
+  // instead of going through .blocks / .kmers files
+  bool fitsInMemory(const KMerData &data) const;
+  void clusterInMemory(const KMerData &data, dsu::ConcurrentDSU &uf);
+
   DECL_LOGGER("Hamming Clustering");
 };
 
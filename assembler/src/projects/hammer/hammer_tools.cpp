@@ -11,6 +11,7 @@
 #include "globals.hpp"
 #include "kmer_data.hpp"
 #include "read_corrector.hpp"
+#include "read_cache.hpp"
 
 #include "io/reads/ireadstream.hpp"
 #include "io/kmers/mmapped_writer.hpp"
@@ -106,7 +107,7 @@ CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
 
 CorrectionStats CorrectReadFile(const KMerData &data,
                      const std::string &fname,
-                     std::ofstream *outf_good, std::ofstream *outf_bad) {
+                     CachedReadWriter *outf_good, std::ofstream *outf_bad) {
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
@@ -115,7 +116,7 @@ CorrectionStats CorrectReadFile(const KMerData &data,
   std::vector<Read> reads(read_buffer_size);
   std::vector<bool> res(read_buffer_size, false);
 
-  ireadstream irs(fname, qvoffset);
+  CachedReadStream irs(fname, qvoffset);
   VERIFY(irs.is_open());
 
   unsigned buffer_no = 0;
@@ -133,7 +134,10 @@ CorrectionStats CorrectReadFile(const KMerData &data,
 
     INFO("Processed batch " << buffer_no);
     for (size_t i = 0; i < buf_size; ++i) {
-      reads[i].print(*(res[i] ? outf_good : outf_bad), qvoffset);
+      if (res[i])
+        outf_good->write(reads[i]);
+      else
+        reads[i].print(*outf_bad, qvoffset);
     }
     INFO("Written batch " << buffer_no);
     ++buffer_no;
@@ -143,7 +147,8 @@ CorrectionStats CorrectReadFile(const KMerData &data,
 
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
                             const std::string &fnamel, const std::string &fnamer,
-                            ofstream * ofbadl, ofstream * ofcorl, ofstream * ofbadr, ofstream * ofcorr, ofstream * ofunp) {
+                            ofstream * ofbadl, CachedReadWriter * ofcorl, ofstream * ofbadr, CachedReadWriter * ofcorr,
+                            CachedReadWriter * ofunp) {
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
@@ -156,7 +161,7 @@ CorrectionStats CorrectPairedReadFiles(const KMerData &data,
 
   unsigned buffer_no = 0;
 
-  ireadstream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
+  CachedReadStream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
   VERIFY(irsl.is_open()); VERIFY(irsr.is_open());
   CorrectionStats stats;
 
@@ -177,11 +182,17 @@ CorrectionStats CorrectPairedReadFiles(const KMerData &data,
     INFO("Processed batch " << buffer_no);
     for (size_t i = 0; i < buf_size; ++i) {
       if (left_res[i] && right_res[i]) {
-        l[i].print(*ofcorl, qvoffset);
-        r[i].print(*ofcorr, qvoffset);
+        ofcorl->write(l[i]);
+        ofcorr->write(r[i]);
       } else {
-        l[i].print(*(left_res[i] ? ofunp : ofbadl), qvoffset);
-        r[i].print(*(right_res[i] ? ofunp : ofbadr), qvoffset);
+        if (left_res[i])
+          ofunp->write(l[i]);
+        else
+          l[i].print(*ofbadl, qvoffset);
+        if (right_res[i])
+          ofunp->write(r[i]);
+        else
+          r[i].print(*ofbadr, qvoffset);
       }
     }
     INFO("Written batch " << buffer_no);
@@ -203,19 +214,20 @@ std::string getLargestPrefix(const std::string &str1, const std::string &str2) {
   return substr;
 }
 
-std::string CorrectSingleReadSet(size_t ilib, size_t iread, const std::string &fn, CorrectionStats &stats) {
+std::string CorrectSingleReadSet(size_t ilib, size_t iread, const std::string &fn, CorrectionStats &stats,
+                                 ReadCache *corrected_cache) {
   std::string usuffix = std::to_string(ilib) + "_" +
                         std::to_string(iread) + ".cor.fastq";
 
   std::string outcor = getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, usuffix);
-  std::ofstream ofgood(outcor.c_str());
+  CachedReadWriter ofgood(outcor, cfg::get().input_qvoffset, corrected_cache);
   std::ofstream ofbad(getReadsFilename(cfg::get().output_dir, fn, Globals::iteration_no, "bad.fastq").c_str(),
                       std::ios::out | std::ios::ate);
   stats += CorrectReadFile(*Globals::kmer_data, fn, &ofgood, &ofbad);
   return outcor;
 }
 
-size_t CorrectAllReads() {
+size_t CorrectAllReads(ReadCache *corrected_cache) {
   // Now for the reconstruction step; we still have the reads in rv, correcting them in place.
   int correct_nthreads = std::min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
 
@@ -242,13 +254,13 @@ size_t CorrectAllReads() {
       std::string outcorr = getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, usuffix);
       std::string outcoru = getReadsFilename(cfg::get().output_dir, unpaired,  Globals::iteration_no, usuffix);
 
-      std::ofstream ofcorl(outcorl.c_str());
+      CachedReadWriter ofcorl(outcorl, cfg::get().input_qvoffset, corrected_cache);
       std::ofstream ofbadl(getReadsFilename(cfg::get().output_dir, I->first,  Globals::iteration_no, "bad.fastq").c_str(),
                            std::ios::out | std::ios::ate);
-      std::ofstream ofcorr(outcorr.c_str());
+      CachedReadWriter ofcorr(outcorr, cfg::get().input_qvoffset, corrected_cache);
       std::ofstream ofbadr(getReadsFilename(cfg::get().output_dir, I->second, Globals::iteration_no, "bad.fastq").c_str(),
                            std::ios::out | std::ios::ate);
-      std::ofstream ofunp (outcoru.c_str());
+      CachedReadWriter ofunp(outcoru, cfg::get().input_qvoffset, corrected_cache);
 
       stats += CorrectPairedReadFiles(*Globals::kmer_data,
                              I->first, I->second,
@@ -259,12 +271,12 @@ size_t CorrectAllReads() {
 
     for (auto I = lib.merged_begin(), E = lib.merged_end(); I != E; ++I, ++iread) {
       INFO("Correcting merged reads: " << *I);
-      outlib.push_back_merged(CorrectSingleReadSet(ilib, iread, *I, stats));
+      outlib.push_back_merged(CorrectSingleReadSet(ilib, iread, *I, stats, corrected_cache));
     }
 
     for (auto I = lib.single_begin(), E = lib.single_end(); I != E; ++I, ++iread) {
       INFO("Correcting single reads: " << *I);
-      outlib.push_back_single(CorrectSingleReadSet(ilib, iread, *I, stats));
+      outlib.push_back_single(CorrectSingleReadSet(ilib, iread, *I, stats, corrected_cache));
     }
 
     outdataset.push_back(outlib);
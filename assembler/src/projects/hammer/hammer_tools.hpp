@@ -17,6 +17,7 @@
 #include "io/reads/ireadstream.hpp"
 #include "sequence/seq.hpp"
 #include "globals.hpp"
+#include "read_cache.hpp"
 #include "kmer_stat.hpp"
 #include "io/kmers/mmapped_reader.hpp"
 
@@ -51,17 +52,16 @@ CorrectionStats CorrectReadsBatch(std::vector<bool> &res, std::vector<Read> &rea
 
 /// correct reads in a given file
 CorrectionStats CorrectReadFile(const KMerData &data,
-                         size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
                          const std::string &fname,
-                         std::ofstream *outf_good, std::ofstream *outf_bad);
+                         CachedReadWriter *outf_good, std::ofstream *outf_bad);
 
 /// correct reads in a given pair of files
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
-                            size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
                             const std::string &fnamel, const std::string &fnamer,
-                            std::ofstream * ofbadl, std::ofstream * ofcorl, std::ofstream * ofbadr, std::ofstream * ofcorr, std::ofstream * ofunp);
-/// correct all reads
-size_t CorrectAllReads();
+                            std::ofstream * ofbadl, CachedReadWriter * ofcorl, std::ofstream * ofbadr, CachedReadWriter * ofcorr,
+                            CachedReadWriter * ofunp);
+/// correct all reads, the corrected reads are packed into corrected_cache unless it's null
+size_t CorrectAllReads(ReadCache *corrected_cache);
 
 std::string getFilename(const std::string & dirprefix, const std::string & suffix );
 std::string getFilename(const std::string & dirprefix, unsigned iter_count, const std::string & suffix );
@@ -20,6 +20,8 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <numeric>
+#include <sstream>
 
 using std::max_element;
 using std::min_element;
@@ -28,6 +30,51 @@ namespace numeric = boost::numeric::ublas;
 
 using namespace hammer;
 
+struct KMerClustering::Stats {
+  size_t newkmers = 0;
+  size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0, tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
+  numeric::matrix<uint64_t> errs = numeric::zero_matrix<uint64_t>(4, 4);
+
+  Stats &operator+=(const Stats &other) {
+    newkmers += other.newkmers;
+    gsingl += other.gsingl; tsingl += other.tsingl;
+    tcsingl += other.tcsingl; gcsingl += other.gcsingl;
+    tcls += other.tcls; gcls += other.gcls;
+    tkmers += other.tkmers; tncls += other.tncls;
+    errs += other.errs;
+    return *this;
+  }
+};
+
+// Statistics and output collected by a thread while processing a batch of clusters
+struct KMerClustering::ThreadState {
+  ThreadState(bool write_good, bool write_bad)
+      : write_good(write_good), write_bad(write_bad) {}
+
+  // Output is written out once this much is collected, so that big batches do not keep it all in memory
+  static const std::streamoff FLUSH_THRESHOLD = 1 << 20;
+
+  bool NeedsFlush() {
+    return good.tellp() + bad.tellp() + debug.tellp() > FLUSH_THRESHOLD;
+  }
+
+  // Should be called under the lock of the output streams
+  void Flush(std::ostream &good_os, std::ostream &bad_os) {
+    if (write_good)
+      good_os << good.str();
+    if (write_bad)
+      bad_os << bad.str();
+    if (debug.tellp() > 0)
+      std::cout << debug.str() << std::flush;
+    for (std::ostringstream *os : { &good, &bad, &debug })
+      os->str("");
+  }
+
+  Stats stats;
+  bool write_good, write_bad;
+  std::ostringstream good, bad, debug;
+};
+
 std::string KMerClustering::GetGoodKMersFname() const {
   // FIXME: This is ugly!
   std::ostringstream tmp;
@@ -95,7 +142,8 @@ static hammer::ExpandedSeq Consensus(const std::vector<hammer::ExpandedKMer> &km
 }
 
 double KMerClustering::ClusterBIC(const std::vector<Center> &centers,
-                                  const std::vector<size_t> &indices, const std::vector<hammer::ExpandedKMer> &kmers) const {
+                                  const std::vector<size_t> &indices, const std::vector<hammer::ExpandedKMer> &kmers,
+                                  ThreadState &state) const {
   size_t block_size = indices.size();
   size_t clusters = centers.size();
   if (block_size == 0)
@@ -112,10 +160,7 @@ double KMerClustering::ClusterBIC(const std::vector<Center> &centers,
   size_t nparams = (clusters - 1) + clusters*K + 2*clusters*K;
 
   if (cfg::get().bayes_debug_output > 1) {
-#   pragma omp critical
-    {
-        std::cout << "  logL: " << loglik << ", clusters: " << clusters << ", nparams: " << nparams << ", N: " << block_size << std::endl;
-    }
+    state.debug << "  logL: " << loglik << ", clusters: " << clusters << ", nparams: " << nparams << ", N: " << block_size << std::endl;
   }
   
   return loglik - (double)nparams * log((double)total) / 2.0;
@@ -123,7 +168,8 @@ double KMerClustering::ClusterBIC(const std::vector<Center> &centers,
 
 
 double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::ExpandedKMer> &kmers,
-                                        std::vector<size_t> &indices, std::vector<Center> &centers) {
+                                        std::vector<size_t> &indices, std::vector<Center> &centers,
+                                        ThreadState &state) {
   centers.resize(l); // there are l centers
 
   // if l==1 then clustering is trivial
@@ -132,7 +178,7 @@ double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::Ex
     centers[0].count_ = kmers.size();
     for (size_t i = 0; i < kmers.size(); ++i)
       indices[i] = 0;
-    return ClusterBIC(centers, indices, kmers);
+    return ClusterBIC(centers, indices, kmers, state);
   }
 
   // Provide the initial approximation.
@@ -171,12 +217,9 @@ double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::Ex
   }
 
   if (cfg::get().bayes_debug_output > 1) {
-#   pragma omp critical
-    {
-      std::cout << "    centers:\n";
-      for (size_t i=0; i < centers.size(); ++i) {
-        std::cout << "    " << centers[i].center_ << "\n";
-      }
+    state.debug << "    centers:\n";
+    for (size_t i=0; i < centers.size(); ++i) {
+      state.debug << "    " << centers[i].center_ << "\n";
     }
   }
 
@@ -222,10 +265,7 @@ double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::Ex
     }
 
     if (cfg::get().bayes_debug_output > 1) {
-#     pragma omp critical
-      {
-        std::cout << "      total likelihood=" << curlik << " as compared to previous " << totalLikelihood << std::endl;
-      }
+      state.debug << "      total likelihood=" << curlik << " as compared to previous " << totalLikelihood << std::endl;
     }
     improved = (curlik > totalLikelihood);
     if (improved)
@@ -245,29 +285,24 @@ double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::Ex
     centers[j].center_ = ConsensusWithMask(kmers, indices, j);
 
   if (cfg::get().bayes_debug_output > 1) {
-#   pragma omp critical
-    {
-      std::cout << "    final centers:\n";
-      for (size_t i=0; i < centers.size(); ++i) {
-        std::cout << "    " << centers[i].center_ << "\n";
-      }
+    state.debug << "    final centers:\n";
+    for (size_t i=0; i < centers.size(); ++i) {
+      state.debug << "    " << centers[i].center_ << "\n";
     }
   }
 
-  return ClusterBIC(centers, indices, kmers);
+  return ClusterBIC(centers, indices, kmers, state);
 }
 
 
-size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec) {
+size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec,
+                                        ThreadState &state) {
   size_t newkmers = 0;
 
   if (cfg::get().bayes_debug_output > 0) {
-#   pragma omp critical
-    {
-      std::cout << "  kmers:\n";
-      for (size_t i = 0; i < block.size(); i++) {
-        std::cout << data_.kmer(block[i]) << '\n';
-      }
+    state.debug << "  kmers:\n";
+    for (size_t i = 0; i < block.size(); i++) {
+      state.debug << data_.kmer(block[i]) << '\n';
     }
   }
 
@@ -291,10 +326,7 @@ size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::
   
   maxcls = std::min(maxcls, maxgcnt) + 1;
   if (cfg::get().bayes_debug_output > 0) {
-    #pragma omp critical
-    {
-      std::cout << "\nClustering an interesting block. Maximum # of clusters estimated: " << maxcls << std::endl;
-    }
+    state.debug << "\nClustering an interesting block. Maximum # of clusters estimated: " << maxcls << std::endl;
   }
 
   // Prepare the expanded k-mer structure
@@ -310,15 +342,12 @@ size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::
   unsigned max_l = cfg::get().bayes_hammer_mode ? 1 : (unsigned) origBlockSize;
   std::vector<Center> centers;
   for (unsigned l = 1; l <= max_l; ++l) {
-    double curLikelihood = lMeansClustering(l, kmers, indices, centers);
+    double curLikelihood = lMeansClustering(l, kmers, indices, centers, state);
     if (cfg::get().bayes_debug_output > 0) {
-      #pragma omp critical
-      {
-        std::cout << "    indices: ";
-        for (uint32_t i = 0; i < origBlockSize; i++) std::cout << indices[i] << " ";
-        std::cout << "\n";
-        std::cout << "  likelihood with " << l << " clusters is " << curLikelihood << std::endl;
-      }
+      state.debug << "    indices: ";
+      for (uint32_t i = 0; i < origBlockSize; i++) state.debug << indices[i] << " ";
+      state.debug << "\n";
+      state.debug << "  likelihood with " << l << " clusters is " << curLikelihood << std::endl;
     }
     if (curLikelihood > bestLikelihood) {
       bestLikelihood = curLikelihood;
@@ -337,27 +366,24 @@ size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::
   }
 
   if (cfg::get().bayes_debug_output > 0) {
-#   pragma omp critical
-    {
-      std::cout << "Centers: \n";
-      for (size_t k=0; k<bestCenters.size(); ++k) {
-        std::cout << "  " << std::setw(4) << bestCenters[k].count_ << ": ";
-        if (centersInCluster[k] != NO_CENTER) {
-          const KMerStat &kms = data_[block[centersInCluster[k]]];
-          std::cout << kms << " " << std::setw(8) << block[centersInCluster[k]] << "  ";
-        } else {
-          std::cout << bestCenters[k].center_;
-        }
-        std::cout << '\n';
-      }
-      std::cout << "The entire block:" << std::endl;
-      for (uint32_t i = 0; i < origBlockSize; i++) {
-        const KMerStat &kms = data_[block[i]];
-        std::cout << "  " << kms << " " << std::setw(8) << block[i] << "  ";
-        for (uint32_t j=0; j<K; ++j) std::cout << std::setw(3) << (unsigned)getQual(kms, j) << " "; std::cout << "\n";
+    state.debug << "Centers: \n";
+    for (size_t k=0; k<bestCenters.size(); ++k) {
+      state.debug << "  " << std::setw(4) << bestCenters[k].count_ << ": ";
+      if (centersInCluster[k] != NO_CENTER) {
+        const KMerStat &kms = data_[block[centersInCluster[k]]];
+        state.debug << kms << " " << std::setw(8) << block[centersInCluster[k]] << "  ";
+      } else {
+        state.debug << bestCenters[k].center_;
       }
-      std::cout << std::endl;
+      state.debug << '\n';
+    }
+    state.debug << "The entire block:" << std::endl;
+    for (uint32_t i = 0; i < origBlockSize; i++) {
+      const KMerStat &kms = data_[block[i]];
+      state.debug << "  " << kms << " " << std::setw(8) << block[i] << "  ";
+      for (uint32_t j=0; j<K; ++j) state.debug << std::setw(3) << (unsigned)getQual(kms, j) << " "; state.debug << "\n";
     }
+    state.debug << std::endl;
   }
 
   // it may happen that consensus string from one subcluster occurs in other subclusters
@@ -389,16 +415,13 @@ size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::
   }
 
   if (cfg::get().bayes_debug_output > 0 && origBlockSize > 2) {
-    #pragma omp critical
-    {
-      std::cout << "\nAfter the check we got centers: \n";
-      for (size_t k=0; k<bestCenters.size(); ++k) {
-        std::cout << "  " << bestCenters[k].center_ << " (" << bestCenters[k].count_ << ")";
-        if (centersInCluster[k] != NO_CENTER) std::cout << block[centersInCluster[k]];
-        std::cout << "\n";
-      }
-      std::cout << std::endl;
+    state.debug << "\nAfter the check we got centers: \n";
+    for (size_t k=0; k<bestCenters.size(); ++k) {
+      state.debug << "  " << bestCenters[k].center_ << " (" << bestCenters[k].count_ << ")";
+      if (centersInCluster[k] != NO_CENTER) state.debug << block[centersInCluster[k]];
+      state.debug << "\n";
     }
+    state.debug << std::endl;
   }
 
   for (size_t k = 0; k < bestCenters.size(); ++k) {
@@ -452,12 +475,8 @@ static void UpdateErrors(numeric::matrix<uint64_t> &m,
   }
 }
 
-size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
-                                      numeric::matrix<uint64_t> &errs,
-                                      std::ofstream &ofs, std::ofstream &ofs_bad,
-                                      size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                                      size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls) {
-    size_t newkmers = 0;
+void KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class, ThreadState &state) {
+    Stats &stats = state.stats;
 
     // No need for clustering for singletons
     if (cur_class.size() == 1) {
@@ -465,13 +484,10 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
         KMerStat &singl = data_[idx];
         if ((1-singl.total_qual) > cfg::get().bayes_singleton_threshold) {
             singl.mark_good();
-            gsingl += 1;
+            stats.gsingl += 1;
 
-            if (ofs.good()) {
-#               pragma omp critical
-                {
-                    ofs << " good singleton: " << idx << "\n  " << singl << '\n';
-                }
+            if (state.write_good) {
+                state.good << " good singleton: " << idx << "\n  " << singl << '\n';
             }
         } else {
             if (cfg::get().correct_use_threshold && (1-singl.total_qual) > cfg::get().correct_threshold)
@@ -479,27 +495,21 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
             else
                 singl.mark_bad();
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " bad singleton: " << idx << "\n  " << singl << '\n';
-                }
+            if (state.write_bad) {
+                state.bad << " bad singleton: " << idx << "\n  " << singl << '\n';
             }
         }
-        tsingl += 1;
-        return 0;
+        stats.tsingl += 1;
+        return;
     }
 
     std::vector<std::vector<size_t> > blocksInPlace;
     if (cfg::get().bayes_debug_output) {
-#       pragma omp critical
-        {
-          std::cout << "process_SIN with size=" << cur_class.size() << std::endl;
-        }
-      }
-    newkmers += SubClusterSingle(cur_class, blocksInPlace);
+        state.debug << "process_SIN with size=" << cur_class.size() << std::endl;
+    }
+    stats.newkmers += SubClusterSingle(cur_class, blocksInPlace, state);
 
-    tncls += 1;
+    stats.tncls += 1;
     for (size_t m = 0; m < blocksInPlace.size(); ++m) {
         const std::vector<size_t> &currentBlock = blocksInPlace[m];
         if (currentBlock.size() == 0)
@@ -520,9 +530,9 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
         }
 
         if (currentBlock.size() == 1)
-            tcsingl += 1;
+            stats.tcsingl += 1;
         else
-            tcls += 1;
+            stats.tcls += 1;
 
         if ((center_quality > cfg::get().bayes_singleton_threshold &&
              cluster_quality > cfg::get().bayes_nonsingleton_threshold) ||
@@ -530,50 +540,39 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
           center.mark_good();
 
           if (currentBlock.size() == 1)
-              gcsingl += 1;
+              stats.gcsingl += 1;
           else
-              gcls += 1;
-
-          if (ofs.good()) {
-#             pragma omp critical
-              {
-                  ofs << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                  << center << '\n';
-              }
+              stats.gcls += 1;
+
+          if (state.write_good) {
+              state.good << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                         << center << '\n';
           }
         } else {
             if (cfg::get().correct_use_threshold && center_quality > cfg::get().correct_threshold)
                 center.mark_good();
             else
                 center.mark_bad();
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << center << '\n';
-                }
+            if (state.write_bad) {
+                state.bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                          << center << '\n';
             }
         }
 
-        tkmers += currentBlock.size();
+        stats.tkmers += currentBlock.size();
 
         for (size_t j = 1; j < currentBlock.size(); ++j) {
             size_t eidx = currentBlock[j];
             KMerStat &kms = data_[eidx];
 
-            UpdateErrors(errs, data_.kmer(eidx), ckmer);
+            UpdateErrors(stats.errs, data_.kmer(eidx), ckmer);
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << kms << '\n';
-                }
+            if (state.write_bad) {
+                state.bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                          << kms << '\n';
             }
         }
     }
-
-    return newkmers;
 }
 
 
@@ -588,9 +587,6 @@ public:
 };
 
 void KMerClustering::process(const std::string &Prefix) {
-  size_t newkmers = 0;
-  size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0, tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
-
   std::ofstream ofs, ofs_bad;
   if (cfg::get().bayes_write_solid_kmers)
     ofs.open(GetGoodKMersFname());
@@ -600,35 +596,45 @@ void KMerClustering::process(const std::string &Prefix) {
   // Open and read index file
   MMappedRecordReader<size_t> findex(Prefix + ".idx",  /* unlink */ !debug_, -1ULL);
 
-  std::vector<numeric::matrix<uint64_t> > errs(nthreads_, numeric::matrix<double>(4, 4, 0.0));
+  // Split the clusters into batches and find where each batch starts in the clusters file
+  size_t nbatches = std::min<size_t>(findex.size(), nthreads_ * BATCHES_PER_THREAD);
+  std::vector<size_t *> batch_start(nbatches + 1);
+  std::vector<size_t> batch_offset(nbatches + 1, 0);
+  for (size_t batch = 0; batch <= nbatches; ++batch)
+      batch_start[batch] = findex.data() + (nbatches ? findex.size() * batch / nbatches : 0);
+  for (size_t batch = 0; batch < nbatches; ++batch)
+      batch_offset[batch + 1] = std::accumulate(batch_start[batch], batch_start[batch + 1], batch_offset[batch]);
+
+  // Every thread collects statistics and output of a batch on its own, these are merged once the batch is done
+  Stats total;
+  bool write_good = ofs.good(), write_bad = ofs_bad.good();
+# pragma omp parallel for num_threads(nthreads_) schedule(dynamic)
+  for (size_t batch = 0; batch < nbatches; ++batch) {
+      ThreadState state(write_good, write_bad);
 
-# pragma omp parallel for shared(ofs, ofs_bad, errs) num_threads(nthreads_) schedule(guided) reduction(+:newkmers, gsingl, tsingl, tcsingl, gcsingl, tcls, gcls, tkmers, tncls)
-  for (size_t chunk = 0; chunk < nthreads_ * nthreads_; ++chunk) {
-      size_t *current = findex.data() + findex.size() * chunk / nthreads_ / nthreads_;
-      size_t *next = findex.data() + findex.size() * (chunk + 1)/ nthreads_ / nthreads_;
       std::ifstream is(Prefix, std::ios::in | std::ios::binary);
+      is.seekg(batch_offset[batch] * sizeof(size_t));
 
-      // Calculate how much we need to seek
-      size_t soff = 0;
-      for (size_t *csz = findex.data(); csz != current; ++csz)
-          soff += *csz;
-
-      // Now see the stream and start processing
-      is.seekg(soff * sizeof(size_t));
-
-      for (; current != next; ++current) {
-          std::vector<size_t> cluster(*current);
+      std::vector<size_t> cluster;
+      for (size_t *current = batch_start[batch]; current != batch_start[batch + 1]; ++current) {
+          cluster.resize(*current);
           VERIFY(is.good());
           is.read((char*)&cluster[0], *current * sizeof(cluster[0]));
 
           // Underlying code expected classes to be sorted in count decreasing order.
           std::sort(cluster.begin(), cluster.end(), KMerStatCountComparator(data_));
 
-          newkmers += ProcessCluster(cluster,
-                                     errs[omp_get_thread_num()],
-                                     ofs, ofs_bad,
-                                     gsingl, tsingl, tcsingl, gcsingl,
-                                     tcls, gcls, tkmers, tncls);
+          ProcessCluster(cluster, state);
+          if (state.NeedsFlush()) {
+#             pragma omp critical(subcluster_output)
+              state.Flush(ofs, ofs_bad);
+          }
+      }
+
+#     pragma omp critical(subcluster_output)
+      {
+          total += state.stats;
+          state.Flush(ofs, ofs_bad);
       }
   }
 
@@ -638,15 +644,15 @@ void KMerClustering::process(const std::string &Prefix) {
                         "unlink(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
   }
 
-  for (unsigned i = 1; i < nthreads_; ++i)
-    errs[0] += errs[i];
-
-  numeric::matrix<uint64_t> rowsums = prod(errs[0], numeric::scalar_matrix<double>(4, 1, 1));
+  const numeric::matrix<uint64_t> &errs = total.errs;
+  numeric::matrix<uint64_t> rowsums = prod(errs, numeric::scalar_matrix<double>(4, 1, 1));
   numeric::matrix<double> err(4, 4);
   for (unsigned i = 0; i < 4; ++i)
     for (unsigned j = 0; j < 4; ++j)
-      err(i, j) = 1.0 * (double)errs[0](i, j) / (double)rowsums(i, 0);
+      err(i, j) = 1.0 * (double)errs(i, j) / (double)rowsums(i, 0);
 
+  size_t newkmers = total.newkmers, gsingl = total.gsingl, tsingl = total.tsingl, tcsingl = total.tcsingl,
+      gcsingl = total.gcsingl, tcls = total.tcls, gcls = total.gcls, tkmers = total.tkmers, tncls = total.tncls;
   INFO("Subclustering done. Total " << newkmers << " non-read kmers were generated.");
   INFO("Subclustering statistics:");
   INFO("  Total singleton hamming clusters: " << tsingl << ". Among them " << gsingl << " (" << 100.0 * (double)gsingl / (double)tsingl << "%) are good");
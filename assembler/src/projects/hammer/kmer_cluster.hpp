@@ -40,9 +40,15 @@ private:
     hammer::ExpandedSeq center_;
     size_t count_;
   };
+
+  struct Stats;
+  struct ThreadState;
+
+  static constexpr size_t BATCHES_PER_THREAD = 16;
     
   double ClusterBIC(const std::vector<Center> &centers,
-                    const std::vector<size_t> &indices, const std::vector<hammer::ExpandedKMer> &kmers) const;
+                    const std::vector<size_t> &indices, const std::vector<hammer::ExpandedKMer> &kmers,
+                    ThreadState &state) const;
 
   /**
     * perform l-means clustering on the set of k-mers with initial centers being the l most frequent k-mers here
@@ -51,18 +57,16 @@ private:
     * @return the resulting likelihood of this clustering
     */
   double lMeansClustering(unsigned l, const std::vector<hammer::ExpandedKMer> &kmers,
-                          std::vector<size_t> & indices, std::vector<Center> & centers);
+                          std::vector<size_t> & indices, std::vector<Center> & centers,
+                          ThreadState &state);
 
-  size_t SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec);
+  size_t SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec,
+                          ThreadState &state);
 
   std::string GetGoodKMersFname() const;
   std::string GetBadKMersFname() const;
 
-  size_t ProcessCluster(const std::vector<size_t> &cur_class,
-                        boost::numeric::ublas::matrix<uint64_t> &errs,
-                        std::ofstream &ofs, std::ofstream &ofs_bad,
-                        size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                        size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls);
+  void ProcessCluster(const std::vector<size_t> &cur_class, ThreadState &state);
 
 private:
   DECL_LOGGER("Hamming Subclustering");
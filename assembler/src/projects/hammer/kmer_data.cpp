@@ -6,6 +6,7 @@
 //***************************************************************************
 
 #include "kmer_data.hpp"
+#include "read_cache.hpp"
 #include "valid_kmer_generator.hpp"
 #include "config_struct_hammer.hpp"
 
@@ -61,10 +62,10 @@ class BufferFiller {
   BufferFiller(HammerFilteringKMerSplitter &splitter)
       : splitter_(splitter) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(const Read &r) {
     int trim_quality = cfg::get().input_trim_quality;
 
-    Read cr = *r;
+    Read cr = r;
     size_t sz = cr.trimNsAndBadQuality(trim_quality);
   
     if (sz < hammer::K)
@@ -95,7 +96,7 @@ HammerFilteringKMerSplitter::RawKMers HammerFilteringKMerSplitter::Split(size_t
   BufferFiller filler(*this);
   for (const auto &reads : cfg::get().dataset.reads()) {
     INFO("Processing " << reads);
-    ireadstream irs(reads, cfg::get().input_qvoffset);
+    CachedReadStream irs(reads, cfg::get().input_qvoffset);
     while (!irs.eof()) {
       hammer::ReadProcessor rp(nthreads);
       rp.Run(irs, filler);
@@ -160,11 +161,11 @@ class KMerDataFiller {
   KMerDataFiller(KMerData &data)
       : data_(data) {}
 
-  bool operator()(std::unique_ptr<Read> r) {
+  bool operator()(const Read &r) {
     uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
     // FIXME: Get rid of this
-    Read cr = *r;
+    Read cr = r;
     size_t sz = cr.trimNsAndBadQuality(trim_quality);
 
     if (sz < hammer::K)
@@ -198,11 +199,11 @@ class KMerMultiplicityCounter {
 
   ~KMerMultiplicityCounter() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(const Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
       // FIXME: Get rid of this
-      Read cr = *r;
+      Read cr = r;
       size_t sz = cr.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
@@ -236,11 +237,11 @@ class KMerCountEstimator {
 
   ~KMerCountEstimator() {}
 
-    bool operator()(std::unique_ptr<Read> r) {
+    bool operator()(const Read &r) {
       uint8_t trim_quality = (uint8_t)cfg::get().input_trim_quality;
 
       // FIXME: Get rid of this
-      Read cr = *r;
+      Read cr = r;
       size_t sz = cr.trimNsAndBadQuality(trim_quality);
 
       if (sz < hammer::K)
@@ -286,7 +287,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
           KMerCountEstimator mcounter(omp_get_max_threads());
           for (const auto &reads : cfg::get().dataset.reads()) {
               INFO("Processing " << reads);
-              ireadstream irs(reads, cfg::get().input_qvoffset);
+              CachedReadStream irs(reads, cfg::get().input_qvoffset);
               while (!irs.eof()) {
                   hammer::ReadProcessor rp(omp_get_max_threads());
                   rp.Run(irs, mcounter);
@@ -313,7 +314,7 @@ void KMerDataCounter::BuildKMerIndex(KMerData &data) {
       size_t n = 15, processed = 0;
       for (const auto &reads : cfg::get().dataset.reads()) {
           INFO("Processing " << reads);
-          ireadstream irs(reads, cfg::get().input_qvoffset);
+          CachedReadStream irs(reads, cfg::get().input_qvoffset);
           while (!irs.eof()) {
               hammer::ReadProcessor rp(omp_get_max_threads());
               rp.Run(irs, mcounter);
@@ -375,7 +376,7 @@ void KMerDataCounter::FillKMerData(KMerData &data) {
   const auto& dataset = cfg::get().dataset;
   for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
     INFO("Processing " << *I);
-    ireadstream irs(*I, cfg::get().input_qvoffset);
+    CachedReadStream irs(*I, cfg::get().input_qvoffset);
     hammer::ReadProcessor rp(omp_get_max_threads());
     rp.Run(irs, filler);
     VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
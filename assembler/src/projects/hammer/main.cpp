@@ -11,6 +11,7 @@
 #include "globals.hpp"
 #include "kmer_data.hpp"
 #include "expander.hpp"
+#include "read_cache.hpp"
 
 #include "adt/concurrent_dsu.hpp"
 #include "utils/segfault_handler.hpp"
@@ -35,8 +36,11 @@
 #include <cmath>
 #include <cstdlib>
 
+#include <unistd.h>
+
 std::vector<uint32_t> * Globals::subKMerPositions = NULL;
 KMerData *Globals::kmer_data = NULL;
+hammer::ReadCache *Globals::read_cache = NULL;
 int Globals::iteration_no = 0;
 
 char Globals::char_offset = 0;
@@ -53,6 +57,18 @@ struct UfCmp {
   }
 };
 
+// Memory the process could still take: the rest of the hard limit, but not more than the free physical memory
+static size_t AvailableMemory() {
+  size_t limit = utils::get_memory_limit(), used = utils::get_used_memory();
+  size_t available = limit > used ? limit - used : 0;
+#ifdef _SC_AVPHYS_PAGES
+  long pages = sysconf(_SC_AVPHYS_PAGES), page_size = sysconf(_SC_PAGESIZE);
+  if (pages > 0 && page_size > 0)
+    available = std::min(available, size_t(pages) * size_t(page_size));
+#endif
+  return available;
+}
+
 void create_console_logger() {
   using namespace logging;
 
@@ -114,6 +130,14 @@ int main(int argc, char * argv[]) {
 
     int max_iterations = cfg::get().general_max_iterations;
 
+    // Parse the reads once for all the passes over them. The reads corrected by an iteration are packed
+    // into the cache of the next one as they are written, so the input is parsed only here. A quarter
+    // of the memory is left to the cache, the k-mer counting and clustering take the rest
+    size_t read_cache_memory = AvailableMemory() / 4;
+    if (cfg::get().input_cache_reads)
+      Globals::read_cache = hammer::ReadCache::Load(cfg::get().dataset, cfg::get().input_qvoffset,
+                                                    read_cache_memory, cfg::get().general_max_nthreads).release();
+
     // now we can begin the iterations
     for (Globals::iteration_no = 0; Globals::iteration_no < max_iterations; ++Globals::iteration_no) {
       std::cout << "\n     === ITERATION " << Globals::iteration_no << " begins ===" << std::endl;
@@ -199,7 +223,7 @@ int main(int argc, char * argv[]) {
           Expander expander(*Globals::kmer_data);
           const io::DataSet<> &dataset = cfg::get().dataset;
           for (auto I = dataset.reads_begin(), E = dataset.reads_end(); I != E; ++I) {
-            ireadstream irs(*I, cfg::get().input_qvoffset);
+            hammer::CachedReadStream irs(*I, cfg::get().input_qvoffset);
             hammer::ReadProcessor rp(expand_nthreads);
             rp.Run(irs, expander);
             VERIFY_MSG(rp.read() == rp.processed(), "Queue unbalanced");
@@ -238,7 +262,14 @@ int main(int argc, char * argv[]) {
       size_t totalReads = 0;
       // reconstruct and output the reads
       if (cfg::get().correct_do || do_everything) {
-        totalReads = hammer::CorrectAllReads();
+        std::unique_ptr<hammer::ReadCache> corrected_cache;
+        if (Globals::read_cache && Globals::iteration_no + 1 < max_iterations)
+          corrected_cache.reset(new hammer::ReadCache(read_cache_memory));
+        totalReads = hammer::CorrectAllReads(corrected_cache.get());
+
+        // The next iteration works on the corrected reads
+        delete Globals::read_cache;
+        Globals::read_cache = corrected_cache.release();
       }
 
       // prepare the reads for next iteration
@@ -256,6 +287,8 @@ int main(int argc, char * argv[]) {
     cfg::get_writable().dataset.save(fname);
 
     // clean up
+    delete Globals::read_cache;
+    Globals::read_cache = NULL;
     Globals::subKMerPositions->clear();
     delete Globals::subKMerPositions;
 
@@ -0,0 +1,208 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "read_cache.hpp"
+
+#include "globals.hpp"
+
+#include "utils/logger/logger.hpp"
+
+#include <algorithm>
+
+namespace hammer {
+
+static const size_t NUCLS_PER_WORD = 32;
+
+void PackedReads::push_back(const Read &r) {
+  push_back(r.getName(), r.getSequenceString(), r.getQualityString());
+}
+
+void PackedReads::push_back(const std::string &name, const std::string &seq, const std::string &qual) {
+  names_.append(name.c_str(), name.size() + 1);
+  name_end_.push_back(names_.size());
+
+  seqs_.resize((nucls_ + seq.size() + NUCLS_PER_WORD - 1) / NUCLS_PER_WORD, 0);
+  for (char c : seq) {
+    uint64_t code = 0;
+    switch (c) {
+      case 'A': code = 0; break;
+      case 'C': code = 1; break;
+      case 'G': code = 2; break;
+      case 'T': code = 3; break;
+      default:
+        exception_pos_.push_back(nucls_);
+        exception_chars_.push_back(c);
+    }
+    seqs_[nucls_ / NUCLS_PER_WORD] |= code << (2 * (nucls_ % NUCLS_PER_WORD));
+    nucls_ += 1;
+  }
+  seq_end_.push_back(nucls_);
+
+  // Qualities are kept with the offset, so they could be passed to Read::setQuality as is
+  for (char q : qual)
+    quals_.push_back(char(q + offset_));
+  qual_end_.push_back(quals_.size());
+}
+
+size_t PackedReads::memory() const {
+  return names_.capacity() + quals_.capacity() + exception_chars_.capacity() +
+      sizeof(uint64_t) * (seqs_.capacity() + exception_pos_.capacity() +
+                          name_end_.capacity() + seq_end_.capacity() + qual_end_.capacity());
+}
+
+void PackedReads::shrink_to_fit() {
+  names_.shrink_to_fit(); quals_.shrink_to_fit(); exception_chars_.shrink_to_fit();
+  seqs_.shrink_to_fit(); exception_pos_.shrink_to_fit();
+  name_end_.shrink_to_fit(); seq_end_.shrink_to_fit(); qual_end_.shrink_to_fit();
+}
+
+void PackedReads::get(size_t i, Read &r, std::string &seq, std::string &qual) const {
+  VERIFY(i < size());
+
+  size_t seq_begin = seq_end_[i], seq_end = seq_end_[i + 1];
+  seq.resize(seq_end - seq_begin);
+  for (size_t pos = seq_begin; pos < seq_end; ++pos)
+    seq[pos - seq_begin] = nucl((seqs_[pos / NUCLS_PER_WORD] >> (2 * (pos % NUCLS_PER_WORD))) & 3);
+  for (auto it = std::lower_bound(exception_pos_.begin(), exception_pos_.end(), seq_begin);
+       it != exception_pos_.end() && *it < seq_end; ++it)
+    seq[*it - seq_begin] = exception_chars_[it - exception_pos_.begin()];
+
+  qual.assign(quals_, qual_end_[i], qual_end_[i + 1] - qual_end_[i]);
+
+  r.setName(names_.data() + name_end_[i]);
+  r.setQuality(qual.c_str(), offset_);
+  r.setSequence(seq.c_str());
+}
+
+std::unique_ptr<ReadCache> ReadCache::Load(const io::DataSet<> &dataset, int offset, size_t max_memory,
+                                           unsigned nthreads) {
+  std::vector<std::string> fnames;
+  for (const auto &fname : dataset.reads()) {
+    if (std::find(fnames.begin(), fnames.end(), fname) == fnames.end())
+      fnames.push_back(fname);
+  }
+
+  std::unique_ptr<ReadCache> cache(new ReadCache(max_memory));
+# pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+  for (size_t i = 0; i < fnames.size(); ++i)
+    cache->Add(fnames[i], offset);
+
+  INFO("Total " << cache->size() << " reads cached, " << cache->memory() / 1024 / 1024 << " MB occupied");
+  return cache;
+}
+
+void ReadCache::Add(const std::string &fname, int offset) {
+  ireadstream irs(fname, offset);
+  if (!irs.is_open())
+    return;
+
+  INFO("Caching " << fname);
+  Packer packer(*this, offset);
+  Read r;
+  while (!irs.eof()) {
+    irs >> r;
+    if (!packer.push_back(r)) {
+      INFO("Reads of " << fname << " do not fit into " << max_memory_ / 1024 / 1024 << " MB, "
+           "they will be read from disk on every pass");
+      return;
+    }
+  }
+  packer.commit(fname);
+}
+
+static const size_t RESERVE_READS = 4096;
+
+bool ReadCache::Packer::push_back(const Read &r) {
+  if (!reads_)
+    return false;
+  reads_->push_back(r);
+  return reads_->size() % RESERVE_READS || Reserve();
+}
+
+bool ReadCache::Packer::push_back(const std::string &name, const std::string &seq, const std::string &qual) {
+  if (!reads_)
+    return false;
+  reads_->push_back(name, seq, qual);
+  return reads_->size() % RESERVE_READS || Reserve();
+}
+
+bool ReadCache::Packer::Reserve() {
+  size_t memory = reads_->memory();
+  if (memory > reserved_ && (cache_.memory_ += memory - reserved_) > cache_.max_memory_) {
+    // Give the memory back to the other files
+    cache_.memory_ -= memory;
+    reserved_ = 0;
+    reads_.reset();
+    return false;
+  }
+
+  if (memory < reserved_)
+    cache_.memory_ -= reserved_ - memory;
+  reserved_ = memory;
+  return true;
+}
+
+void ReadCache::Packer::commit(const std::string &fname) {
+  if (!reads_)
+    return;
+
+  reads_->shrink_to_fit();
+  if (!Reserve())
+    return;
+
+  std::lock_guard<std::mutex> guard(cache_.lock_);
+  cache_.files_.emplace(fname, std::move(*reads_));
+  reads_.reset();
+  // The memory is accounted by the cache from now on
+  reserved_ = 0;
+}
+
+size_t ReadCache::size() const {
+  size_t res = 0;
+  for (const auto &entry : files_)
+    res += entry.second.size();
+  return res;
+}
+
+CachedReadStream::CachedReadStream(const std::string &fname, int offset)
+    : reads_(Globals::read_cache ? Globals::read_cache->find(fname) : nullptr), pos_(0) {
+  if (reads_ && reads_->offset() != offset)
+    reads_ = nullptr;
+  if (!reads_)
+    irs_.reset(new ireadstream(fname, offset));
+}
+
+CachedReadWriter::CachedReadWriter(const std::string &fname, int offset, ReadCache *cache)
+    : fname_(fname), offset_(offset), os_(fname) {
+  if (cache)
+    packer_.reset(new ReadCache::Packer(*cache, offset));
+}
+
+CachedReadWriter::~CachedReadWriter() {
+  if (packer_)
+    packer_->commit(fname_);
+}
+
+void CachedReadWriter::write(const Read &r) {
+  r.print(os_, offset_);
+  if (!packer_)
+    return;
+
+  if (r.ltrim() == 0 && r.rtrim() >= r.initial_size()) {
+    packer_->push_back(r);
+    return;
+  }
+
+  // Trimmed parts are printed as Ns of quality 2
+  size_t lpad = r.ltrim(), rpad = std::max(r.initial_size() - r.rtrim(), 0);
+  seq_.assign(lpad, 'N');
+  seq_.append(r.getSequenceString()).append(rpad, 'N');
+  qual_.assign(lpad, char(2));
+  qual_.append(r.getQualityString()).append(rpad, char(2));
+  packer_->push_back(r.getName(), seq_, qual_);
+}
+
+}
@@ -0,0 +1,159 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#ifndef HAMMER_READ_CACHE_HPP_
+#define HAMMER_READ_CACHE_HPP_
+
+#include "io/reads/read.hpp"
+#include "io/reads/ireadstream.hpp"
+#include "pipeline/library.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hammer {
+
+/// Reads of a single file packed in memory: nucleotides are stored in 2 bits, qualities in a byte,
+/// other characters of the sequences (Ns, etc.) are kept aside as exceptions.
+class PackedReads {
+ public:
+  PackedReads(int offset)
+      : offset_(offset), nucls_(0) {
+    name_end_.push_back(0); seq_end_.push_back(0); qual_end_.push_back(0);
+  }
+
+  void push_back(const Read &r);
+  /// Qualities are given without the offset, as Read keeps them
+  void push_back(const std::string &name, const std::string &seq, const std::string &qual);
+
+  size_t size() const { return seq_end_.size() - 1; }
+  int offset() const { return offset_; }
+  size_t memory() const;
+
+  void shrink_to_fit();
+
+  /// Unpacks i-th read into r exactly the way ireadstream would read it
+  void get(size_t i, Read &r, std::string &seq, std::string &qual) const;
+
+ private:
+  int offset_;
+  size_t nucls_;
+
+  std::string names_;
+  std::string quals_;
+  std::vector<uint64_t> seqs_;
+  std::vector<uint64_t> exception_pos_;
+  std::string exception_chars_;
+
+  std::vector<uint64_t> name_end_, seq_end_, qual_end_;
+};
+
+/// Packed copies of the read files of the dataset, parsed once and shared by all the passes over the reads.
+/// The packed reads of all the files together take at most max_memory bytes, the files which do not fit
+/// are not cached and are read from disk.
+class ReadCache {
+ public:
+  explicit ReadCache(size_t max_memory)
+      : max_memory_(max_memory), memory_(0) {}
+
+  /// Parses all the read files of the dataset, several files at a time
+  static std::unique_ptr<ReadCache> Load(const io::DataSet<> &dataset, int offset, size_t max_memory, unsigned nthreads);
+
+  const PackedReads *find(const std::string &fname) const {
+    auto it = files_.find(fname);
+    return it == files_.end() ? nullptr : &it->second;
+  }
+
+  size_t size() const;
+  size_t memory() const { return memory_; }
+  size_t max_memory() const { return max_memory_; }
+
+ private:
+  /// Packs the reads of a single file as they come, drops them as soon as they do not fit into the cache.
+  /// Packers of different files could run concurrently
+  class Packer {
+   public:
+    Packer(ReadCache &cache, int offset)
+        : cache_(cache), reads_(new PackedReads(offset)), reserved_(0) {}
+    ~Packer() { cache_.memory_ -= reserved_; }
+
+    /// @returns false once the reads do not fit
+    bool push_back(const Read &r);
+    bool push_back(const std::string &name, const std::string &seq, const std::string &qual);
+    /// Gives the packed reads over to the cache
+    void commit(const std::string &fname);
+
+   private:
+    bool Reserve();
+
+    ReadCache &cache_;
+    std::unique_ptr<PackedReads> reads_;
+    size_t reserved_;
+  };
+
+  void Add(const std::string &fname, int offset);
+
+  friend class CachedReadWriter;
+
+  // Guards the insertion of files only, lookups are done when the cache is complete
+  std::mutex lock_;
+  std::unordered_map<std::string, PackedReads> files_;
+  size_t max_memory_;
+  std::atomic<size_t> memory_;
+};
+
+/// Writes reads to a file the way Read::print does. If the cache is given, the reads are packed into it
+/// as well, exactly as ireadstream would read them back, so that the file need not be parsed later
+class CachedReadWriter {
+ public:
+  CachedReadWriter(const std::string &fname, int offset, ReadCache *cache);
+  ~CachedReadWriter();
+
+  void write(const Read &r);
+
+ private:
+  std::string fname_;
+  int offset_;
+  std::ofstream os_;
+  std::unique_ptr<ReadCache::Packer> packer_;
+  std::string seq_, qual_;
+};
+
+/// Reads the file from the read cache (Globals::read_cache) if it's there and from the disk otherwise
+class CachedReadStream {
+ public:
+  typedef Read ReadT;
+
+  CachedReadStream(const std::string &fname, int offset);
+
+  bool is_open() const { return reads_ || irs_->is_open(); }
+  bool eof() const { return reads_ ? pos_ == reads_->size() : irs_->eof(); }
+
+  CachedReadStream &operator>>(Read &r) {
+    if (reads_) {
+      VERIFY(!eof());
+      reads_->get(pos_++, r, seq_, qual_);
+    } else
+      *irs_ >> r;
+
+    return *this;
+  }
+
+ private:
+  const PackedReads *reads_;
+  size_t pos_;
+  std::unique_ptr<ireadstream> irs_;
+  std::string seq_, qual_;
+};
+
+}
+
+#endif // HAMMER_READ_CACHE_HPP_
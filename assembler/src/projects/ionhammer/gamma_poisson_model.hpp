@@ -9,6 +9,7 @@
 #include <boost/math/special_functions/binomial.hpp>
 #include <boost/math/special_functions/gamma.hpp>
 #include <boost/math/special_functions/trigamma.hpp>
+#include <algorithm>
 #include <vector>
 #include "kmer_data.hpp"
 #include "thread_utils.h"
@@ -126,8 +127,77 @@ class PoissonGammaDistribution {
 
     return 1.0 - boost::math::ibeta((double)count + 1, a, 1.0 / (1.0 + b));
   }
+
+  // out[i] = PartialLogLikelihood(counts[i]), evaluated via the table for the range of the counts
+  inline void PartialLogLikelihood(const size_t* counts, size_t n, double* out) const;
+};
+
+// (Partial) log-likelihoods of PoissonGammaDistribution with the fixed prior for all the counts in
+// [from, to]. Instead of calling lgamma for every count, lgamma(a + c) and lgamma(c + 1) are advanced
+// via lgamma(x + 1) = lgamma(x) + log(x) and recomputed exactly every ANCHOR_STEP counts to keep
+// the accumulated error small. Counts outside of the table are evaluated directly.
+class PoissonGammaLogLikelihoodTable {
+ private:
+  static constexpr size_t ANCHOR_STEP = 256;
+  static constexpr size_t MAX_SIZE = 1 << 20;
+
+  GammaDistribution prior_;
+  bool partial_;
+  size_t from_;
+  std::vector<double> table_;
+
+ public:
+  PoissonGammaLogLikelihoodTable(const GammaDistribution& prior, size_t from, size_t to,
+                                 bool partial = false)
+      : prior_(prior), partial_(partial), from_(from) {
+    VERIFY(from <= to);
+    table_.resize(std::min(to - from + 1, MAX_SIZE));
+
+    const double a = prior_.GetShape();
+    const double b = prior_.GetRate();
+    const double base = a * log(b) - prior_.LogGammaAtShape();
+    const double log_b1 = log(b + 1);
+
+    double lgamma_shape = 0, lgamma_count = 0;
+    for (size_t i = 0; i < table_.size(); ++i) {
+      const double c = (double)(from_ + i);
+      if (i % ANCHOR_STEP == 0) {
+        VERIFY(i == 0 || std::abs(lgamma_shape - boost::math::lgamma(a + c)) <=
+                         1e-9 * std::max(1.0, std::abs(lgamma_shape)));
+        lgamma_shape = boost::math::lgamma(a + c);
+        lgamma_count = boost::math::lgamma(c + 1);
+      }
+
+      table_[i] = base - (a + c) * log_b1 + lgamma_shape - (partial_ ? 0 : lgamma_count);
+
+      lgamma_shape += log(a + c);
+      lgamma_count += log(c + 1);
+    }
+  }
+
+  size_t from() const { return from_; }
+  size_t to() const { return from_ + table_.size() - 1; }
+
+  inline double operator()(size_t count) const {
+    if (count >= from_ && count - from_ < table_.size())
+      return table_[count - from_];
+
+    PoissonGammaDistribution dist(prior_);
+    return partial_ ? dist.PartialLogLikelihood(count) : dist.LogLikelihood(count);
+  }
 };
 
+inline void PoissonGammaDistribution::PartialLogLikelihood(const size_t* counts, size_t n,
+                                                           double* out) const {
+  if (n == 0)
+    return;
+
+  const auto range = std::minmax_element(counts, counts + n);
+  PoissonGammaLogLikelihoodTable table(prior_, *range.first, *range.second, /* partial */ true);
+  for (size_t i = 0; i < n; ++i)
+    out[i] = table(counts[i]);
+}
+
 constexpr int RunSizeLimit = 8;
 
 class ParametricClusterModel {
@@ -296,16 +366,17 @@ class TClusterModelEstimator {
     }
   };
 
-  inline void Expectation(const PoissonGammaDistribution& first,
-                          const PoissonGammaDistribution& second,
-                          const QualFunc& qualFunc,
-                          TClusterSufficientStat& center) const {
-    const double logPrior = qualFunc.GenomicLogLikelihood(center.qualtiy_) +
-                            log(boost::math::gamma_q(center.count_, threshold_));
+  inline double ExpectationLogPrior(const QualFunc& qualFunc,
+                                    const TClusterSufficientStat& center) const {
+    return qualFunc.GenomicLogLikelihood(center.qualtiy_) +
+           log(boost::math::gamma_q(center.count_, threshold_));
+  }
 
-    const double firstLL = first.PartialLogLikelihood((size_t)center.count_) + logPrior;
-    const double secondLL = second.PartialLogLikelihood((size_t)center.count_) +
-                            log(std::max(1.0 - exp(logPrior), 1e-20));
+  // Log-likelihoods of the count and the log-prior are evaluated for all the centers at once
+  inline void Expectation(double firstCountLL, double secondCountLL, double logPrior,
+                          TClusterSufficientStat& center) const {
+    const double firstLL = firstCountLL + logPrior;
+    const double secondLL = secondCountLL + log(std::max(1.0 - exp(logPrior), 1e-20));
 
     const double posterior = 1.0 / (1.0 + exp(secondLL - firstLL));
     center.genomic_class_prob_ = posterior;
@@ -729,6 +800,21 @@ class TClusterModelEstimator {
       return GammaDistribution(shape, rate);
     }();
 
+    // Counts and the log-priors of the centers do not change between EM steps
+    std::vector<size_t> centerCounts;
+    std::vector<double> centerLogPriors, genomicLL, nonGenomicLL;
+    if (useEM) {
+      centerCounts.resize(clusterSufficientStat.size());
+      centerLogPriors.resize(clusterSufficientStat.size());
+      genomicLL.resize(clusterSufficientStat.size());
+      nonGenomicLL.resize(clusterSufficientStat.size());
+#pragma omp parallel for num_threads(num_threads_)
+      for (size_t k = 0; k < clusterSufficientStat.size(); ++k) {
+        centerCounts[k] = (size_t)clusterSufficientStat[k].count_;
+        centerLogPriors[k] = ExpectationLogPrior(qualityFunc, clusterSufficientStat[k]);
+      }
+    }
+
     for (unsigned i = 0, steps = 0; i < max_terations_; ++i, ++steps) {
       auto gammaDerStats =
           n_computation_utils::TAdditiveStatisticsCalcer<TClusterSufficientStat,
@@ -796,11 +882,13 @@ class TClusterModelEstimator {
       if (useEM) {
         if ((shapeDiff < 1e-2) || gradientNorm < 1e-1 ||
             (steps == 5 && (i < max_terations_ - 10))) {
-          PoissonGammaDistribution genomic(genomicPrior);
-          PoissonGammaDistribution nonGenomic(nonGenomicPrior);
+          PoissonGammaDistribution(genomicPrior)
+              .PartialLogLikelihood(centerCounts.data(), centerCounts.size(), genomicLL.data());
+          PoissonGammaDistribution(nonGenomicPrior)
+              .PartialLogLikelihood(centerCounts.data(), centerCounts.size(), nonGenomicLL.data());
 #pragma omp parallel for num_threads(num_threads_)
           for (size_t k = 0; k < clusterSufficientStat.size(); ++k) {
-            Expectation(genomic, nonGenomic, qualityFunc,
+            Expectation(genomicLL[k], nonGenomicLL[k], centerLogPriors[k],
                         clusterSufficientStat[k]);
           }
 
@@ -45,8 +45,8 @@ class BufferFiller {
 
   size_t processed() const { return processed_; }
 
-  bool operator()(std::unique_ptr<io::SingleRead> r) {
-    ValidHKMerGenerator<hammer::K> gen(*r);
+  bool operator()(const io::SingleRead &r) {
+    ValidHKMerGenerator<hammer::K> gen(r);
     unsigned thread_id = omp_get_thread_num();
 
 #pragma omp atomic
@@ -132,8 +132,8 @@ class KMerDataFiller {
     return UniformRandGenerator(RandomEngine);
   }
 
-  bool operator()(std::unique_ptr<io::SingleRead> &&r) const {
-    ValidHKMerGenerator<hammer::K> gen(*r);
+  bool operator()(const io::SingleRead &r) const {
+    ValidHKMerGenerator<hammer::K> gen(r);
 
     // tiny quality regularization
     const double decay = 0.9999;
@@ -30,6 +30,7 @@
 #include <iterator>
 #include <limits>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -59,6 +60,8 @@ class GammaPoissonLikelihoodCalcer {
   double lower_quantile_;
   size_t noise_quantiles_lower_;
   size_t noise_quantile_upper_;
+  // Log-likelihoods of all the counts in [noise_quantiles_lower_, noise_quantile_upper_]
+  std::shared_ptr<const n_gamma_poisson_model::PoissonGammaLogLikelihoodTable> count_log_likelihood_;
   double correction_penalty_;
   double bad_kmer_penalty_;
   const KMerData& data_;
@@ -134,6 +137,9 @@ class GammaPoissonLikelihoodCalcer {
     const double eps = cfg::get().count_dist_eps;
     noise_quantiles_lower_ = (size_t)max(count_distribution_.Quantile(eps), 1.0);
     noise_quantile_upper_ = (size_t)count_distribution_.Quantile(1.0 - eps);
+    count_log_likelihood_ = std::make_shared<n_gamma_poisson_model::PoissonGammaLogLikelihoodTable>(
+        prior_, std::min(noise_quantiles_lower_, noise_quantile_upper_),
+        std::max(noise_quantiles_lower_, noise_quantile_upper_));
 
     correction_penalty_ = cfg::get().correction_penalty;
     bad_kmer_penalty_ = cfg::get().bad_kmer_penalty;
@@ -182,7 +188,7 @@ class GammaPoissonLikelihoodCalcer {
 
       // state.Likelihood += dist * log(Model.ErrorRate(event.FixedSize));
       state.likelihood_ += (double)state.hkmer_distance_to_read_ * correction_penalty_;
-      state.likelihood_ += count_distribution_.LogLikelihood(cnt);
+      state.likelihood_ += (*count_log_likelihood_)(cnt);
     }
 
     if (!is_good) {
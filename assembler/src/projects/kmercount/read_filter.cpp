@@ -146,7 +146,7 @@ int main(int argc, char* argv[]) {
         }
 
         for (size_t i = 0; i < dataset.lib_count(); ++i) {
-            io::ReadConverter::ConvertToBinary(dataset[i], pool.get());
+            io::ReadConverter::ConvertToBinary(dataset[i], pool.get(), args.nthreads);
         }
 
         std::vector<size_t> libs(dataset.lib_count());
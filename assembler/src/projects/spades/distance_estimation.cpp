@@ -15,6 +15,7 @@
 #include "paired_info/weighted_distance_estimation.hpp"
 #include "paired_info/smoothing_distance_estimation.hpp"
 #include "paired_info/weights.hpp"
+#include "utils/perf/perfcounter.hpp"
 #include "distance_estimation.hpp"
 
 #include <set>
@@ -32,7 +33,9 @@ void estimate_with_estimator(const Graph &graph,
                              PairedInfoIndexT<Graph> &clustered_index) {
     DEBUG("Estimating distances");
 
+    utils::perf_counter pc;
     estimator.Estimate(clustered_index, cfg::get().max_threads);
+    INFO("Distances estimated in " << pc.time() << " s");
 
     INFO("Filtering info");
     if(cfg::get().amb_de.enabled){
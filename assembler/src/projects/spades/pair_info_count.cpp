@@ -315,7 +315,8 @@ void ProcessPairedReads(GraphPack &gp,
     }
 
     using Indices = omnigraph::de::UnclusteredPairedInfoIndicesT<Graph>;
-    LatePairedIndexFiller pif(gp.get<Graph>(), weight, round_thr, gp.get_mutable<Indices>()[ilib]);
+    LatePairedIndexFiller pif(gp.get<Graph>(), weight, round_thr, gp.get_mutable<Indices>()[ilib],
+                              cfg::get().de.staged_paired_buffer);
     notifier.Subscribe(ilib, &pif);
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
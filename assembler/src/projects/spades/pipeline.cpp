@@ -225,7 +225,10 @@ void assemble_genome() {
     INFO("Starting from stage: " << cfg::get().entry_point);
 
     StageManager SPAdes(SavesPolicy(cfg::get().checkpoints,
-                                    cfg::get().output_saves, cfg::get().load_from));
+                                    cfg::get().output_saves, cfg::get().load_from,
+                                    cfg::get().async_checkpoints));
+    if (cfg::get().tt.enable || cfg::get().developer_mode)
+        SPAdes.enable_profiling(cfg::get().output_dir + "spades_profile_" + std::to_string(cfg::get().K) + ".json");
 
     bool two_step_rr = cfg::get().two_step_rr && cfg::get().rr_enable;
     INFO("Two-step repeat resolution " << (two_step_rr ? "enabled" : "disabled"));
@@ -237,7 +240,9 @@ void assemble_genome() {
                                             cfg::get().ds.reference_genome,
                                             cfg::get().flanking_range,
                                             cfg::get().pos.max_mapping_gap,
-                                            cfg::get().pos.max_gap_diff);
+                                            cfg::get().pos.max_gap_diff,
+                                            /*detach_indices*/true,
+                                            cfg::get().compact_graph);
     if (cfg::get().need_mapping) {
         INFO("Will need read mapping, kmer mapper will be attached");
         conj_gp.get_mutable<debruijn_graph::KmerMapper<debruijn_graph::Graph>>().Attach();
@@ -0,0 +1,81 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "hamming_utils.hpp"
+
+#include "adt/hamming_block.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/perf/perfcounter.hpp"
+#include "utils/verify.hpp"
+
+// All-pairs comparison of a block the way hammer processes it
+static void Benchmark() {
+    std::mt19937_64 rnd(42);
+    for (size_t n : { 16, 64, 512, 4096 }) {
+        auto kmers = RandomBlock(rnd, n);
+        size_t repeats = std::max<size_t>(1, (1 << 25) / (n * n));
+
+        utils::perf_counter pc;
+        size_t naive = 0;
+        for (size_t r = 0; r < repeats; ++r)
+            for (size_t i = 0; i < n; ++i)
+                for (size_t j = i + 1; j < n; ++j)
+                    naive += NaiveDistance(kmers[i], kmers[j]) <= 2;
+        double naive_time = pc.time_ms();
+
+        adt::HammingBlock block(KMer::size());
+        std::vector<unsigned> dist(n);
+        size_t scalar = 0, kernel = 0;
+        pc.reset();
+        for (size_t r = 0; r < repeats; ++r) {
+            block.clear();
+            for (const KMer &kmer : kmers)
+                block.push_back(kmer);
+            for (size_t i = 0; i < n; ++i) {
+                block.distances_scalar(i, i + 1, n, dist.data());
+                for (size_t j = 0; j < n - i - 1; ++j)
+                    scalar += dist[j] <= 2;
+            }
+        }
+        double scalar_time = pc.time_ms();
+
+        pc.reset();
+        for (size_t r = 0; r < repeats; ++r) {
+            block.clear();
+            for (const KMer &kmer : kmers)
+                block.push_back(kmer);
+            for (size_t i = 0; i < n; ++i) {
+                block.distances(i, i + 1, n, dist.data());
+                for (size_t j = 0; j < n - i - 1; ++j)
+                    kernel += dist[j] <= 2;
+            }
+        }
+        double kernel_time = pc.time_ms();
+
+        CHECK_FATAL_ERROR(naive == scalar && naive == kernel, "Block kernel distances do not match per-nucleotide ones");
+        INFO("Block of " << n << " k-mers, " << repeats << " repeats: per-nucleotide " << naive_time << " ms, "
+             << "popcount " << scalar_time << " ms, block kernel " << kernel_time << " ms"
+#ifdef ADT_HAMMING_AVX2
+             << (adt::HammingBlock::avx2_supported() ? " (AVX2)" : " (scalar)")
+#endif
+             );
+    }
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+int main() {
+    create_console_logger();
+    Benchmark();
+    return 0;
+}
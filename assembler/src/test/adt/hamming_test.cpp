@@ -0,0 +1,105 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "hamming_utils.hpp"
+
+#include "adt/hamming_block.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/logger/log_writers.hpp"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+TEST(HammingBlock, Distances) {
+    std::mt19937_64 rnd(42);
+    for (size_t nucls : { 1, 21, 32, 33, 55, 64, 127 }) {
+        const size_t n = 37, words = (nucls + 31) / 32;
+        std::vector<std::vector<uint64_t>> strings;
+        adt::HammingBlock block(nucls);
+        for (size_t i = 0; i < n; ++i) {
+            strings.push_back(RandomWords(rnd, words));
+            block.push_back_words(strings.back().data());
+        }
+
+        std::vector<unsigned> dist(n), scalar_dist(n);
+        for (size_t i = 0; i < n; ++i) {
+            block.distances(i, 0, n, dist.data());
+            block.distances_scalar(i, 0, n, scalar_dist.data());
+            for (size_t j = 0; j < n; ++j) {
+                unsigned expected = 0;
+                for (size_t p = 0; p < nucls; ++p) {
+                    size_t w = p / 32, shift = 2 * (p % 32);
+                    expected += ((strings[i][w] >> shift) & 3) != ((strings[j][w] >> shift) & 3);
+                }
+                EXPECT_EQ(expected, dist[j]) << "nucls " << nucls << ", pair " << i << ", " << j;
+                EXPECT_EQ(expected, scalar_dist[j]) << "nucls " << nucls << ", pair " << i << ", " << j;
+            }
+        }
+    }
+}
+
+TEST(HammingBlock, Seq) {
+    std::mt19937_64 rnd(42);
+    auto kmers = RandomBlock(rnd, 100);
+
+    adt::HammingBlock block(KMer::size());
+    for (const KMer &kmer : kmers)
+        block.push_back(kmer);
+
+    std::vector<unsigned> dist(kmers.size());
+    for (size_t i = 0; i < kmers.size(); ++i) {
+        block.distances(i, i, kmers.size(), dist.data());
+        for (size_t j = i; j < kmers.size(); ++j)
+            EXPECT_EQ(NaiveDistance(kmers[i], kmers[j]), dist[j - i]);
+    }
+}
+
+// All-pairs comparison of blocks the way hammer processes them
+TEST(HammingBlock, AllPairs) {
+    std::mt19937_64 rnd(42);
+    for (size_t n : { 1, 16, 33, 200 }) {
+        auto kmers = RandomBlock(rnd, n);
+
+        size_t naive = 0;
+        for (size_t i = 0; i < n; ++i)
+            for (size_t j = i + 1; j < n; ++j)
+                naive += NaiveDistance(kmers[i], kmers[j]) <= 2;
+
+        adt::HammingBlock block(KMer::size());
+        for (const KMer &kmer : kmers)
+            block.push_back(kmer);
+        std::vector<unsigned> dist(n);
+        size_t scalar = 0, kernel = 0;
+        for (size_t i = 0; i < n; ++i) {
+            block.distances_scalar(i, i + 1, n, dist.data());
+            for (size_t j = 0; j < n - i - 1; ++j)
+                scalar += dist[j] <= 2;
+            block.distances(i, i + 1, n, dist.data());
+            for (size_t j = 0; j < n - i - 1; ++j)
+                kernel += dist[j] <= 2;
+        }
+
+        EXPECT_EQ(naive, scalar) << n << " k-mers";
+        EXPECT_EQ(naive, kernel) << n << " k-mers";
+    }
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    create_console_logger();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,46 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "sequence/seq.hpp"
+
+#include <random>
+#include <vector>
+
+typedef Seq<21> KMer;
+
+inline unsigned NaiveDistance(const KMer &x, const KMer &y) {
+    unsigned dist = 0;
+    for (unsigned i = 0; i < KMer::size(); ++i)
+        dist += x[i] != y[i];
+    return dist;
+}
+
+inline std::vector<uint64_t> RandomWords(std::mt19937_64 &rnd, size_t words) {
+    std::vector<uint64_t> res(words);
+    for (auto &w : res)
+        w = rnd();
+    return res;
+}
+
+// Block of random strings, every next one is a mutated copy of one of the previous ones,
+// so that small distances are present as well
+inline std::vector<KMer> RandomBlock(std::mt19937_64 &rnd, size_t n) {
+    std::vector<KMer> res;
+    for (size_t i = 0; i < n; ++i) {
+        if (i == 0 || rnd() % 4 == 0) {
+            res.emplace_back(KMer::DataSize, RandomWords(rnd, KMer::DataSize).data());
+            continue;
+        }
+
+        KMer kmer = res[rnd() % res.size()];
+        for (size_t m = rnd() % 4; m > 0; --m)
+            kmer.set(rnd() % KMer::size(), char(rnd() % 4));
+        res.push_back(kmer);
+    }
+    return res;
+}
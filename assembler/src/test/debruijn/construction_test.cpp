@@ -13,6 +13,9 @@
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "modules/alignment/sequence_mapper.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
@@ -20,6 +23,7 @@
 #include <vector>
 #include <set>
 #include <string>
+#include <random>
 
 #include <gtest/gtest.h>
 
@@ -96,6 +100,102 @@ TEST_F( GraphConstruction, TestKmerFreeIndex ) {
     CheckIndex(reads, tmp_folder(), 5);
 }
 
+TEST_F( GraphConstruction, BatchedMapping ) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    const size_t k = 21;
+    std::mt19937 rnd(42);
+    auto random_seq = [&](size_t len) {
+        std::string res;
+        for (size_t i = 0; i < len; ++i)
+            res.push_back(nucl(char(rnd() % 4)));
+        return res;
+    };
+
+    // Repeats make the graph branch, so reads span several edges
+    std::string repeat = random_seq(100);
+    std::string genome = random_seq(1000) + repeat + random_seq(1000) + repeat + random_seq(1000);
+    std::vector<std::string> reads;
+    for (size_t i = 0; i + 100 <= genome.size(); i += 10)
+        reads.push_back(genome.substr(i, 100));
+
+    GraphPack gp(k, tmp_folder(), 0);
+    auto workdir = fs::tmp::make_temp_dir(gp.workdir(), "tests");
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    auto &graph = gp.get_mutable<Graph>();
+    auto &index = gp.get_mutable<EdgeIndex<Graph>>();
+    ConstructGraphWithIndex(config::debruijn_config::construction(), workdir, streams, graph, index);
+    ASSERT_GT(graph.e_size(), 2);
+
+    const auto &kmer_mapper = gp.get<KmerMapper<Graph>>();
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> mapper(graph, index, kmer_mapper);
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> single_mapper(graph, index, kmer_mapper, true, /*max_lookup_batch*/1);
+
+    // Sequencing errors interleave threaded k-mers with the ones that are not in the graph
+    for (size_t i = 0; i < 1000; ++i) {
+        size_t len = 50 + rnd() % 200;
+        std::string read = genome.substr(rnd() % (genome.size() - len), len);
+        for (size_t errors = rnd() % 5; errors > 0; --errors)
+            read[rnd() % len] = nucl(char(rnd() % 4));
+        if (i % 10 == 0)
+            read = random_seq(len);
+
+        Sequence seq(read);
+        auto expected = single_mapper.MapSequence(seq);
+        auto path = mapper.MapSequence(seq);
+        ASSERT_EQ(expected.size(), path.size()) << read;
+        for (size_t j = 0; j < path.size(); ++j) {
+            EXPECT_EQ(expected[j].first, path[j].first) << read;
+            EXPECT_TRUE(expected[j].second == path[j].second) << read;
+        }
+
+        std::vector<RtSeq> kmers;
+        kmers.push_back(seq.start<RtSeq>(k + 1));
+        for (size_t j = k + 1; j < seq.size(); ++j)
+            kmers.push_back(kmers.back() << seq[j]);
+        std::vector<std::pair<EdgeId, size_t>> positions(kmers.size());
+        index.get(kmers.data(), kmers.size(), positions.data());
+        for (size_t j = 0; j < kmers.size(); ++j)
+            EXPECT_EQ(index.get(kmers[j]), positions[j]);
+    }
+}
+
+TEST_F( GraphConstruction, InMemoryKMerCounting ) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    const unsigned k = 22;
+    std::mt19937 rnd(42);
+    std::string genome;
+    for (size_t i = 0; i < 20000; ++i)
+        genome.push_back(nucl(char(rnd() % 4)));
+    std::vector<std::string> reads;
+    for (size_t i = 0; i + 100 <= genome.size(); i += 7) {
+        std::string read = genome.substr(i, 100);
+        read[rnd() % read.size()] = nucl(char(rnd() % 4));
+        reads.push_back(read);
+    }
+
+    using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleRead, utils::StoringTypeFilter<utils::SimpleStoring>>;
+    auto count = [&](bool in_memory) {
+        auto workdir = fs::tmp::make_temp_dir(tmp_folder(), "tests");
+        io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+        // Small buffers, so that the k-mers are flushed several times
+        kmers::KMerDiskCounter<RtSeq> counter(workdir, Splitter(workdir, k, streams, 1 << 16), in_memory);
+        auto storage = counter.Count(16, 4);
+
+        std::vector<std::string> buckets;
+        for (size_t i = 0; i < storage.num_buckets(); ++i) {
+            buckets.emplace_back();
+            for (auto kmer : storage.bucket(i))
+                buckets.back().append((const char*)kmer.first, kmer.second);
+        }
+        return buckets;
+    };
+
+    auto on_disk = count(false), in_memory = count(true);
+    ASSERT_EQ(on_disk.size(), in_memory.size());
+    for (size_t i = 0; i < on_disk.size(); ++i)
+        EXPECT_TRUE(on_disk[i] == in_memory[i]) << "bucket " << i;
+}
+
 TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
     std::vector<MyPairedRead> paired_reads = {{"CCCAC", "CCACG"}, {"ACCAC", "CCACA"}};
     std::vector<MyEdge> edges = {"CCCA", "ACCA", "CCAC", "CACG", "CACA"};
@@ -0,0 +1,45 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "random_graph.hpp"
+#include "reference_dijkstra.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace debruijn_graph;
+
+typedef omnigraph::DijkstraHelper<Graph> DijkstraHelper;
+
+// Runs bounded searches from every vertex, as the simplification does, and reports the time
+// spent by the reference implementation and the one working in the reused workspace
+TEST( DijkstraBench, BoundedSearches ) {
+    Graph g(55);
+    RandomGraph<Graph>(g, /*max_size*/1000).Generate(/*iterations*/10000);
+    const size_t bound = 3000, passes = 20;
+
+    utils::perf_counter pc;
+    size_t reference_checksum = 0;
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (VertexId v : g)
+            reference_checksum += ReferenceDistances(g, v, bound).size();
+    }
+    double reference_time = pc.time();
+
+    pc.reset();
+    size_t checksum = 0;
+    for (size_t pass = 0; pass < passes; ++pass) {
+        for (VertexId v : g) {
+            auto dijkstra = DijkstraHelper::CreateBoundedDijkstra(g, bound);
+            dijkstra.Run(v);
+            checksum += dijkstra.ProcessedVertices().size();
+        }
+    }
+    INFO("Bounded Dijkstra over " << g.size() << " vertices: reference " << reference_time
+         << " s, workspace " << pc.time() << " s");
+    EXPECT_EQ(reference_checksum, checksum);
+}
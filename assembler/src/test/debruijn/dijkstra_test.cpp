@@ -0,0 +1,86 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "random_graph.hpp"
+#include "reference_dijkstra.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+
+#include <algorithm>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace debruijn_graph;
+
+typedef omnigraph::DijkstraHelper<Graph> DijkstraHelper;
+
+static const Graph &DijkstraGraph() {
+    static Graph graph(55);
+    if (!graph.size())
+        RandomGraph<Graph>(graph, /*max_size*/1000).Generate(/*iterations*/10000);
+    return graph;
+}
+
+static void CheckDistances(const DijkstraHelper::BoundedDijkstra &dijkstra, const Graph &g,
+                           VertexId start, size_t bound) {
+    auto expected = ReferenceDistances(g, start, bound);
+    auto reached = dijkstra.ReachedVertices();
+    ASSERT_EQ(expected.size(), reached.size());
+    for (VertexId v : reached) {
+        ASSERT_TRUE(expected.count(v));
+        EXPECT_EQ(expected[v], dijkstra.GetDistance(v));
+        EXPECT_EQ(1u, dijkstra.ProcessedVertices().count(v));
+    }
+}
+
+TEST( Dijkstra, BoundedDistances ) {
+    const Graph &g = DijkstraGraph();
+    const size_t bound = 2000;
+
+    auto outer = DijkstraHelper::CreateBoundedDijkstra(g, bound);
+    for (VertexId v : g) {
+        outer.Run(v);
+        {
+            // Both searches are alive, so they should not share the workspace
+            auto inner = DijkstraHelper::CreateBoundedDijkstra(g, bound / 2, -1ul, /*collect_traceback*/true);
+            inner.Run(g.conjugate(v));
+            CheckDistances(inner, g, g.conjugate(v), bound / 2);
+
+            for (VertexId u : inner.ReachedVertices()) {
+                size_t length = 0;
+                for (EdgeId e : inner.GetShortestPathTo(u))
+                    length += g.length(e);
+                EXPECT_GE(length, inner.GetDistance(u));
+            }
+        }
+        CheckDistances(outer, g, v, bound);
+    }
+}
+
+TEST( Dijkstra, ReleaseIdleWorkspaces ) {
+    const Graph &g = DijkstraGraph();
+    const size_t bound = 2000;
+    std::vector<VertexId> starts(g.begin(), g.end());
+    starts.resize(std::min<size_t>(starts.size(), 100));
+
+    auto alive = DijkstraHelper::CreateBoundedDijkstra(g, bound);
+    alive.Run(starts.front());
+
+    // Fill the idle pools of several threads, then free them from the main one
+#   pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < starts.size(); ++i)
+        DijkstraHelper::CreateBoundedDijkstra(g, bound).Run(starts[i]);
+    omnigraph::ReleaseIdleDijkstraWorkspaces();
+
+    // The workspace in use is kept, the new searches get fresh ones
+    CheckDistances(alive, g, starts.front(), bound);
+#   pragma omp parallel for num_threads(4)
+    for (size_t i = 0; i < starts.size(); ++i) {
+        auto dijkstra = DijkstraHelper::CreateBoundedDijkstra(g, bound);
+        dijkstra.Run(starts[i]);
+        CheckDistances(dijkstra, g, starts[i], bound);
+    }
+}
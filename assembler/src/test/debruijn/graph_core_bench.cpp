@@ -0,0 +1,47 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "assembly_graph/core/graph.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace debruijn_graph;
+using omnigraph::GraphLayout;
+
+class GraphCoreBench : public ::testing::TestWithParam<GraphLayout> {};
+
+// Traverses the graph of many short branching paths from every vertex and reports the time for both layouts
+TEST_P( GraphCoreBench, Traversal ) {
+    const size_t VERTICES = 100000, EDGES = 250000, PASSES = 5;
+
+    Graph g(11, GetParam());
+    std::mt19937 rnd(42);
+    std::vector<VertexId> vertices;
+    for (size_t i = 0; i < VERTICES; ++i)
+        vertices.push_back(g.AddVertex());
+    for (size_t i = 0; i < EDGES; ++i)
+        g.AddEdge(vertices[rnd() % VERTICES], vertices[rnd() % VERTICES], Sequence("AAAAAAAAAAAAA"));
+
+    utils::perf_counter pc;
+    size_t checksum = 0;
+    for (size_t pass = 0; pass < PASSES; ++pass) {
+        for (VertexId v : g) {
+            for (EdgeId e : g.OutgoingEdges(v)) {
+                VertexId u = g.EdgeEnd(e);
+                checksum += g.OutgoingEdgeCount(u) + g.IncomingEdgeCount(u) + g.conjugate(e).int_id();
+            }
+        }
+    }
+    INFO((GetParam() == GraphLayout::Compact ? "Compact" : "Default") << " layout traversal: "
+         << pc.time() << " s, checksum " << checksum);
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, GraphCoreBench,
+                         ::testing::Values(GraphLayout::Default, GraphLayout::Compact));
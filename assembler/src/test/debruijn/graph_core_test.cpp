@@ -5,23 +5,30 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/compact_adjacency.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <vector>
 #include <set>
 #include <string>
+#include <random>
+#include <algorithm>
 
 #include <gtest/gtest.h>
 
 using namespace debruijn_graph;
+using omnigraph::GraphLayout;
 
-TEST( GraphCore, Empty ) {
-    Graph g(11);
+class GraphCore : public ::testing::TestWithParam<GraphLayout> {};
+
+TEST_P( GraphCore, Empty ) {
+    Graph g(11, GetParam());
     EXPECT_EQ(11u, g.k());
     EXPECT_EQ(0u, g.size());
 }
 
-TEST( GraphCore, OneVertex ) {
-    Graph g(11);
+TEST_P( GraphCore, OneVertex ) {
+    Graph g(11, GetParam());
     g.AddVertex();
     EXPECT_EQ(2u, g.size());
     VertexId v = *(g.begin());
@@ -43,8 +50,8 @@ std::pair<std::vector<VertexId>, std::vector<EdgeId>> createGraph(Graph &graph,
     return make_pair(v, e);
 }
 
-TEST( GraphCore, OneEdge ) {
-    Graph g(11);
+TEST_P( GraphCore, OneEdge ) {
+    Graph g(11, GetParam());
     auto data = createGraph(g, 1);
     EXPECT_EQ(1u, g.OutgoingEdgeCount(data.first[0]));
     EXPECT_EQ(0u, g.OutgoingEdgeCount(data.first[1]));
@@ -57,8 +64,8 @@ TEST( GraphCore, OneEdge ) {
             g.EdgeNucls(g.conjugate(data.second[0])));
 }
 
-TEST( GraphCore, VertexMethods ) {
-    Graph g(11);
+TEST_P( GraphCore, VertexMethods ) {
+    Graph g(11, GetParam());
     auto data = createGraph(g, 2);
     EXPECT_EQ(data.second[0], g.GetUniqueIncomingEdge(data.first[1]));
     EXPECT_EQ(data.second[0], g.GetUniqueOutgoingEdge(data.first[0]));
@@ -74,8 +81,8 @@ TEST( GraphCore, VertexMethods ) {
     EXPECT_FALSE(g.IsDeadStart(data.first[1]));
 }
 
-TEST( GraphCore, SmartIterator ) {
-    Graph g(11);
+TEST_P( GraphCore, SmartIterator ) {
+    Graph g(11, GetParam());
     auto data = createGraph(g, 4);
     size_t num = 0;
     std::set<VertexId> visited;
@@ -94,8 +101,8 @@ TEST( GraphCore, SmartIterator ) {
 }
 
 
-TEST( GraphCore, SelfRCEdgeMerge ) {
-    Graph g(5);
+TEST_P( GraphCore, SelfRCEdgeMerge ) {
+    Graph g(5, GetParam());
     VertexId v1 = g.AddVertex();
     VertexId v2 = g.AddVertex();
     EdgeId edge1 = g.AddEdge(v1, v2, Sequence("AACGCTATT"));
@@ -106,3 +113,175 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+TEST_P( GraphCore, RemoveEdges ) {
+    Graph g(11, GetParam());
+    VertexId v = g.AddVertex();
+    std::vector<VertexId> ends;
+    std::vector<EdgeId> edges;
+    for (const char *nucls : { "AAAAAAAAAAAAA", "ACCCCCCCCCCCC", "AGGGGGGGGGGGG", "ATTTTTTTTTTTA", "ACGTACGTACGTA" }) {
+        ends.push_back(g.AddVertex());
+        edges.push_back(g.AddEdge(v, ends.back(), Sequence(nucls)));
+    }
+    EXPECT_EQ(5u, g.OutgoingEdgeCount(v));
+    EXPECT_TRUE(std::is_sorted(g.out_begin(v), g.out_end(v)));
+    for (size_t i = 0; i < ends.size(); ++i)
+        EXPECT_EQ(edges[i], g.GetUniqueIncomingEdge(ends[i]));
+
+    for (size_t i = 0; i < edges.size(); i += 2)
+        g.DeleteEdge(edges[i]);
+    std::vector<EdgeId> rest(g.out_begin(v), g.out_end(v));
+    EXPECT_EQ(std::vector<EdgeId>({ edges[1], edges[3] }), rest);
+    EXPECT_EQ(2u, g.IncomingEdgeCount(g.conjugate(v)));
+    EXPECT_TRUE(g.IsDeadStart(ends[0]));
+
+    g.DeleteEdge(edges[1]);
+    g.DeleteEdge(edges[3]);
+    EXPECT_TRUE(g.IsDeadEnd(v));
+    EdgeId e = g.AddEdge(v, ends[0], Sequence("AAAAAAAAAAAAA"));
+    EXPECT_EQ(e, g.GetUniqueOutgoingEdge(v));
+}
+
+// Records the events together with the lengths of the edges involved
+class EventRecorder : public omnigraph::GraphActionHandler<Graph> {
+public:
+    EventRecorder(const Graph &g, bool batchable)
+            : omnigraph::GraphActionHandler<Graph>(g, "EventRecorder"), batchable_(batchable) {}
+
+    void HandleAdd(EdgeId e) override { events_.push_back("add " + str(e)); }
+    void HandleDelete(EdgeId e) override { events_.push_back("delete " + str(e)); }
+    void HandleDelete(VertexId v) override { events_.push_back("delete vertex " + std::to_string(v.int_id())); }
+
+    void HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) override {
+        std::string event = "merge";
+        for (EdgeId e : old_edges)
+            event += " " + str(e);
+        events_.push_back(event + " into " + str(new_edge));
+    }
+
+    void HandleSplit(EdgeId old_edge, EdgeId new_edge1, EdgeId new_edge2) override {
+        events_.push_back("split " + str(old_edge) + " into " + str(new_edge1) + " " + str(new_edge2));
+    }
+
+    bool IsBatchable() const override { return batchable_; }
+
+    const std::vector<std::string> &events() const { return events_; }
+
+private:
+    std::string str(EdgeId e) const {
+        return std::to_string(e.int_id()) + ":" + std::to_string(g().length(e));
+    }
+
+    bool batchable_;
+    std::vector<std::string> events_;
+};
+
+TEST_P( GraphCore, BatchedEvents ) {
+    Graph g(11, GetParam());
+    auto data = createGraph(g, 3);
+    EventRecorder immediate(g, false), batched(g, true), removed(g, true);
+
+    g.StartBatching();
+    EXPECT_TRUE(batched.IsBatched());
+    EXPECT_FALSE(immediate.IsBatched());
+    // Removed handler should not stay batched nor get the recorded events
+    EXPECT_TRUE(removed.IsBatched());
+    g.RemoveActionHandler(&removed);
+    EXPECT_FALSE(removed.IsBatched());
+
+    EdgeId merged = g.MergePath({ data.second[0], data.second[1] });
+    auto split = g.SplitEdge(merged, 4);
+    g.DeleteEdge(data.second[2]);
+    EdgeId added = g.AddEdge(data.first[2], data.first[3], Sequence("ACGTACGTACGTA"));
+
+    EXPECT_TRUE(batched.events().empty());
+    EXPECT_FALSE(immediate.events().empty());
+    EXPECT_FALSE(g.contains(data.second[2]));
+    EXPECT_FALSE(g.contains(merged));
+    EXPECT_TRUE(g.contains(split.first));
+    // Ids of deleted elements are not reused until the sync point
+    for (EdgeId e : data.second)
+        EXPECT_NE(e, added);
+    EXPECT_NE(merged, added);
+    EXPECT_EQ(split.first, g.GetUniqueOutgoingEdge(data.first[0]));
+
+    g.FlushEvents();
+    EXPECT_EQ(immediate.events(), batched.events());
+    EXPECT_TRUE(removed.events().empty());
+
+    g.DeleteEdge(added);
+    g.StopBatching();
+    EXPECT_FALSE(batched.IsBatched());
+    EXPECT_EQ(immediate.events(), batched.events());
+
+    g.DeleteEdge(split.first);
+    EXPECT_EQ(immediate.events(), batched.events());
+}
+
+// Both layouts should give the same adjacency for the same sequence of modifications
+TEST( GraphCore, LayoutsAgree ) {
+    const size_t VERTICES = 1000, EDGES = 2500;
+
+    Graph g(11), compact_g(11, GraphLayout::Compact);
+    std::mt19937 rnd(42);
+    std::vector<VertexId> vertices;
+    for (size_t i = 0; i < VERTICES; ++i) {
+        vertices.push_back(g.AddVertex());
+        EXPECT_EQ(vertices.back(), compact_g.AddVertex());
+    }
+    for (size_t i = 0; i < EDGES; ++i) {
+        VertexId v1 = vertices[rnd() % VERTICES], v2 = vertices[rnd() % VERTICES];
+        EXPECT_EQ(g.AddEdge(v1, v2, Sequence("AAAAAAAAAAAAA")),
+                  compact_g.AddEdge(v1, v2, Sequence("AAAAAAAAAAAAA")));
+    }
+    for (size_t i = 0; i < VERTICES / 10; ++i) {
+        VertexId v = vertices[rnd() % VERTICES];
+        if (!g.contains(v))
+            continue;
+        g.ForceDeleteVertex(v);
+        compact_g.ForceDeleteVertex(v);
+    }
+
+    ASSERT_EQ(g.size(), compact_g.size());
+    ASSERT_EQ(g.e_size(), compact_g.e_size());
+    for (VertexId v : g) {
+        ASSERT_TRUE(compact_g.contains(v));
+        std::vector<EdgeId> out(g.out_begin(v), g.out_end(v));
+        std::vector<EdgeId> compact_out(compact_g.out_begin(v), compact_g.out_end(v));
+        EXPECT_EQ(out, compact_out);
+        EXPECT_EQ(g.IncomingEdgeCount(v), compact_g.IncomingEdgeCount(v));
+    }
+}
+
+// Lists of different ids are modified concurrently, e.g. during parallel graph construction
+TEST( GraphCore, CompactAdjacencyConcurrent ) {
+    const size_t IDS = 2000, OPS = 200;
+
+    omnigraph::impl::CompactAdjacency<uint64_t> adj;
+    adj.resize(IDS);
+    std::vector<std::vector<uint64_t>> expected(IDS);
+#   pragma omp parallel for schedule(dynamic, 1) num_threads(4)
+    for (size_t id = 0; id < IDS; ++id) {
+        std::mt19937 rnd((unsigned)id);
+        auto &list = expected[id];
+        for (size_t i = 0; i < OPS; ++i) {
+            if (!list.empty() && rnd() % 3 == 0) {
+                uint64_t value = list[rnd() % list.size()];
+                EXPECT_TRUE(adj.erase(id, value));
+                list.erase(std::find(list.begin(), list.end(), value));
+            } else {
+                uint64_t value = rnd() % 1000;
+                adj.insert(id, value);
+                list.insert(std::upper_bound(list.begin(), list.end(), value), value);
+            }
+        }
+    }
+
+    for (size_t id = 0; id < IDS; ++id) {
+        ASSERT_EQ(expected[id].size(), adj.size(id));
+        EXPECT_TRUE(std::equal(expected[id].begin(), expected[id].end(), adj.begin(id)));
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Layouts, GraphCore,
+                         ::testing::Values(GraphLayout::Default, GraphLayout::Compact));
@@ -6,13 +6,24 @@
 
 #include "test_utils.hpp"
 #include "random_graph.hpp"
+#include "graphio.hpp"
+#include "tmp_folder_fixture.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
 #include "io/binary/graph.hpp"
+#include "io/binary/graph_pack.hpp"
+#include "io/binary/mapped_graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/reads/binary_converter.hpp"
+#include "io/reads/gz_reader.hpp"
+#include "io/reads/vector_reader.hpp"
 
 #include <gtest/gtest.h>
 
+#include <cstring>
+#include <fstream>
+#include <numeric>
+
 using namespace debruijn_graph;
 
 template<typename T>
@@ -23,7 +34,7 @@ void CompareContainers(const T &lhs, const T &rhs) {
         EXPECT_EQ(*i, *j);
     }
     EXPECT_EQ(i, lhs.end());
-    EXPECT_EQ(j, lhs.end());
+    EXPECT_EQ(j, rhs.end());
 }
 
 template<typename I>
@@ -63,6 +74,56 @@ TEST(Io, Order) {
     CompareGraphIterators(graph.SmartEdgeBegin(), new_graph.SmartEdgeBegin());
 }
 
+TEST(Io, MappedGraph) {
+    const auto &graph = CommonGraph();
+
+    MappedGraphIO<Graph>().Save(file_name, graph);
+
+    Graph new_graph(graph.k());
+    EXPECT_TRUE(MappedGraphIO<Graph>().Load(file_name, new_graph));
+
+    EXPECT_EQ(graph.size(), new_graph.size());
+    EXPECT_EQ(graph.e_size(), new_graph.e_size());
+    for (EdgeId e : graph.edges()) {
+        ASSERT_TRUE(new_graph.contains(e));
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(e));
+        EXPECT_EQ(graph.conjugate(e), new_graph.conjugate(e));
+        EXPECT_EQ(graph.EdgeStart(e), new_graph.EdgeStart(e));
+        EXPECT_EQ(graph.EdgeEnd(e), new_graph.EdgeEnd(e));
+        EXPECT_EQ(graph.coverage_index().RawCoverage(e), new_graph.coverage_index().RawCoverage(e));
+    }
+    for (VertexId v : graph) {
+        ASSERT_TRUE(new_graph.contains(v));
+        EXPECT_EQ(graph.conjugate(v), new_graph.conjugate(v));
+        CompareContainers(graph.OutgoingEdges(v), new_graph.OutgoingEdges(v));
+    }
+}
+
+TEST(Io, PackSnapshot) {
+    TmpFolderFixture fixture;
+    GraphPack gp(55, fixture.tmp_folder(), 0);
+    ASSERT_TRUE(graphio::ScanGraphPack("./src/test/debruijn/graph_fragments/complex_bulge/complex_bulge", gp));
+    const auto &graph = gp.get<Graph>();
+
+    FileImages images;
+    FullPackIO().Snapshot(file_name, gp, images);
+    EXPECT_GT(images.size(), 0);
+    images.Write();
+    EXPECT_EQ(images.size(), 0);
+
+    GraphPack new_gp(55, fixture.tmp_folder(), 0);
+    EXPECT_TRUE(FullPackIO().Load(file_name, new_gp));
+    const auto &new_graph = new_gp.get<Graph>();
+
+    EXPECT_EQ(graph.size(), new_graph.size());
+    EXPECT_EQ(graph.e_size(), new_graph.e_size());
+    for (EdgeId e : graph.edges()) {
+        ASSERT_TRUE(new_graph.contains(e));
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(e));
+        EXPECT_EQ(graph.coverage_index().RawCoverage(e), new_graph.coverage_index().RawCoverage(e));
+    }
+}
+
 TEST(Io, PairedInfo) {
     using namespace omnigraph::de;
     using Index = UnclusteredPairedInfoIndexT<Graph>;
@@ -109,3 +170,122 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+// Compresses data into a single BGZF block, empty data gives the EOF marker block
+static std::string BGZFBlock(const std::string &data) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY);
+    std::string cdata(deflateBound(&zs, uLong(data.size())), '\0');
+    zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in = uInt(data.size());
+    zs.next_out = reinterpret_cast<Bytef*>(&cdata[0]);
+    zs.avail_out = uInt(cdata.size());
+    EXPECT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+    cdata.resize(zs.total_out);
+    deflateEnd(&zs);
+
+    auto le = [](std::string &s, uint32_t val, size_t bytes) {
+        for (size_t i = 0; i < bytes; ++i)
+            s.push_back(char((val >> (8 * i)) & 0xFF));
+    };
+
+    // gzip header with 'BC' extra subfield holding the total block size minus one
+    std::string block = { 31, char(139), 8, 4, 0, 0, 0, 0, 0, char(255), 6, 0, 'B', 'C', 2, 0 };
+    le(block, uint32_t(block.size() + 2 + cdata.size() + 8 - 1), 2);
+    block += cdata;
+    le(block, uint32_t(crc32(crc32(0L, Z_NULL, 0), reinterpret_cast<const Bytef*>(data.data()), uInt(data.size()))), 4);
+    le(block, uint32_t(data.size()), 4);
+    return block;
+}
+
+static std::string ReadAll(const std::string &filename, unsigned nthreads) {
+    io::GzReader reader(filename, nthreads);
+    EXPECT_TRUE(reader.is_open());
+
+    std::string res;
+    char buf[1000];
+    while (int cnt = reader.read(buf, sizeof(buf)))
+        res.append(buf, size_t(cnt));
+
+    return res;
+}
+
+TEST(GzReader, BGZFBatches) {
+    TmpFolderFixture fixture;
+    std::string filename = fs::append_path(fixture.tmp_folder(), "reads.fq.gz");
+
+    // Blocks are inflated in batches of 16 blocks per thread, so check exact multiples of that,
+    // when the EOF marker block forms a batch on its own
+    for (unsigned nthreads : { 1, 2 }) {
+        for (size_t nblocks : { 0, 1, 15, 16, 17, 32, 33 }) {
+            std::string data, compressed;
+            for (size_t i = 0; i < nblocks; ++i) {
+                std::string block_data(1000 + i, "ACGT\n"[i % 5]);
+                data += block_data;
+                compressed += BGZFBlock(block_data);
+            }
+            compressed += BGZFBlock("");
+            std::ofstream(filename, std::ios::binary) << compressed;
+
+            EXPECT_TRUE(io::GzReader(filename, nthreads).is_bgzf());
+            EXPECT_EQ(data, ReadAll(filename, nthreads)) << nblocks << " blocks, " << nthreads << " threads";
+        }
+    }
+}
+
+TEST(GzReader, EmptyFile) {
+    TmpFolderFixture fixture;
+    std::string filename = fs::append_path(fixture.tmp_folder(), "reads.fq.gz");
+    std::ofstream(filename, std::ios::binary).close();
+
+    EXPECT_EQ("", ReadAll(filename, 0));
+    EXPECT_EQ("", ReadAll(filename, 2));
+}
+
+static io::ReadStreamList<io::SingleRead> ReadStreams(const std::vector<size_t> &sizes) {
+    io::ReadStreamList<io::SingleRead> res;
+    for (size_t s = 0; s < sizes.size(); ++s) {
+        std::vector<io::SingleRead> reads;
+        for (size_t i = 0; i < sizes[s]; ++i) {
+            std::string seq(20 + (s * 7 + i * 13) % 100, 'A');
+            for (size_t j = 0; j < seq.size(); ++j)
+                seq[j] = "ACGT"[(i + j * j + s) % 4];
+            reads.emplace_back("r" + std::to_string(s) + "_" + std::to_string(i), seq);
+        }
+        res.push_back(io::VectorReadStream<io::SingleRead>(reads));
+    }
+    return res;
+}
+
+static std::string FileContents(const std::string &filename) {
+    std::ifstream is(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(is), {});
+}
+
+TEST(BinaryWriter, ConcurrentConversion) {
+    TmpFolderFixture fixture;
+    std::string prefix = fs::append_path(fixture.tmp_folder(), "reads");
+
+    // A single stream is split between threads, several streams are read at once, empty streams are skipped
+    for (const auto &sizes : std::vector<std::vector<size_t>>{ { 3456 }, { 250, 0, 4321, 1, 1000, 999 } }) {
+        size_t total = std::accumulate(sizes.begin(), sizes.end(), size_t(0));
+        std::string seq, off;
+        for (unsigned nthreads : { 1, 2, 4 }) {
+            auto streams = ReadStreams(sizes);
+            io::ReadStreamStat stat;
+            {
+                io::BinaryWriter writer(prefix);
+                stat = writer.ToBinary(streams, nthreads);
+            }
+            EXPECT_EQ(total, stat.read_count);
+            if (nthreads == 1) {
+                seq = FileContents(prefix + ".seq");
+                off = FileContents(prefix + ".off");
+                continue;
+            }
+            EXPECT_EQ(seq, FileContents(prefix + ".seq")) << nthreads << " threads";
+            EXPECT_EQ(off, FileContents(prefix + ".off")) << nthreads << " threads";
+        }
+    }
+}
@@ -0,0 +1,103 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "random_graph.hpp"
+
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "assembly_graph/paths/path_processor.hpp"
+#include "paired_info/concurrent_pair_info_buffer.hpp"
+#include "paired_info/distance_estimation.hpp"
+#include "paired_info/staged_pair_info_buffer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace omnigraph::de;
+using namespace debruijn_graph;
+
+// Fills both buffers with the same points from several threads and reports the time spent
+// including the merge into the index
+TEST(PairedInfoBench, StagedVsConcurrentBuffer) {
+    const unsigned NTHREADS = 4;
+
+    Graph graph(55);
+    RandomGraph<Graph>(graph, /*max_size*/1000).Generate(/*iterations*/2000);
+    RandomPairedPoints<Graph> points(graph, /*points_per_thread*/50000);
+    ASSERT_FALSE(points.empty());
+
+    typedef UnclusteredPairedInfoIndexT<Graph> Index;
+    Index concurrent_pi(graph), staged_pi(graph);
+
+    ConcurrentPairedInfoBuffer<Graph> concurrent_buffer(graph);
+    utils::perf_counter pc;
+#   pragma omp parallel num_threads(NTHREADS)
+    points.Add(omp_get_thread_num(),
+               [&](EdgeId e1, EdgeId e2, RawPoint p) { concurrent_buffer.Add(e1, e2, p); });
+    concurrent_pi.MoveAssign(concurrent_buffer);
+    double concurrent_time = pc.time();
+
+    StagedPairedInfoBuffer<Graph> staged_buffer(graph, NTHREADS);
+    pc.reset();
+#   pragma omp parallel num_threads(NTHREADS)
+    {
+        size_t thread = omp_get_thread_num();
+        points.Add(thread,
+                   [&](EdgeId e1, EdgeId e2, RawPoint p) { staged_buffer.Add(thread, e1, e2, p); });
+    }
+    staged_buffer.MoveInto(staged_pi, NTHREADS);
+    double staged_time = pc.time();
+
+    INFO("Concurrent buffer: " << concurrent_time << " s, staged buffer: " << staged_time << " s");
+    EXPECT_EQ(concurrent_pi.size(), staged_pi.size());
+}
+
+// Finds lengths of paths from every edge to all the edges starting within the insert size, as the distance
+// estimation does, and reports the time spent by the enumeration per edge pair and by the distance finder
+TEST(PairedInfoBench, GraphDistanceLengths) {
+    const size_t insert_size = 1500, read_length = 100, delta = 50;
+
+    Graph graph(55);
+    RandomGraph<Graph>(graph, /*max_size*/1000).Generate(/*iterations*/10000);
+    size_t upper_bound = omnigraph::PairInfoPathLengthUpperBound(graph.k(), insert_size, double(delta));
+
+    std::vector<std::pair<EdgeId, std::map<EdgeId, std::vector<size_t>>>> queries;
+    for (auto it = graph.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(graph, upper_bound);
+        dijkstra.Run(graph.EdgeEnd(*it));
+        std::map<EdgeId, std::vector<size_t>> second_edges;
+        for (VertexId v : dijkstra.ReachedVertices())
+            for (EdgeId e2 : graph.OutgoingEdges(v))
+                second_edges[e2];
+        queries.emplace_back(*it, std::move(second_edges));
+    }
+
+    utils::perf_counter pc;
+    size_t pairs = 0;
+    for (const auto &query : queries) {
+        EdgeId e1 = query.first;
+        omnigraph::PathProcessor<Graph> processor(graph, graph.EdgeEnd(e1), upper_bound);
+        for (const auto &entry : query.second) {
+            size_t lower_bound = omnigraph::PairInfoPathLengthLowerBound(graph.k(), graph.length(e1),
+                                                                        graph.length(entry.first),
+                                                                        int(insert_size - 2 * read_length), double(delta));
+            omnigraph::DistancesLengthsCallback<Graph> callback(graph);
+            processor.Process(graph.EdgeStart(entry.first), lower_bound, upper_bound, callback);
+            ++pairs;
+        }
+    }
+    double enumeration_time = pc.time();
+
+    GraphDistanceFinder finder(graph, insert_size, read_length, delta);
+    pc.reset();
+    for (auto &query : queries)
+        finder.FillGraphDistancesLengths(query.first, query.second);
+    double finder_time = pc.time();
+
+    INFO(queries.size() << " edges, " << pairs << " edge pairs. Enumeration: " << enumeration_time
+         << " s, distance finder: " << finder_time << " s");
+    EXPECT_GT(pairs, 0u);
+}
@@ -8,6 +8,10 @@
 
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
+#include "paired_info/concurrent_pair_info_buffer.hpp"
+#include "paired_info/staged_pair_info_buffer.hpp"
+#include "paired_info/distance_estimation.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 //#include "io/binary/paired_index.hpp"
 
 #include <gtest/gtest.h>
@@ -458,3 +462,127 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, StagedBuffer) {
+    MockGraph graph;
+    StagedPairedInfoBuffer<MockGraph> buffer(graph, 2);
+    buffer.Add(0, 1, 3, {10, 1});
+    buffer.Add(1, 4, 2, {12, 1}); // Conjugate to the previous one
+    buffer.Add(1, 1, 9, {20, 1});
+    buffer.Add(0, 1, 1, {0, 1});
+    MockIndex pi(graph);
+    buffer.MoveInto(pi, 2);
+    EXPECT_EQ(buffer.size(), 0);
+
+    MockIndex etalon(graph);
+    etalon.Add(1, 3, {10, 2});
+    etalon.Add(1, 9, {20, 1});
+    etalon.Add(1, 1, {0, 1});
+    EXPECT_EQ(pi.size(), etalon.size());
+    EXPECT_EQ(GetEdgePairInfo(pi), GetEdgePairInfo(etalon));
+    for (auto it = pair_begin(pi); it != pair_end(pi); ++it) {
+        auto info = *it, etalon_info = etalon.Get(it.first(), it.second());
+        ASSERT_EQ(info.size(), etalon_info.size());
+        for (auto i = info.begin(), ei = etalon_info.begin(); i != info.end(); ++i, ++ei)
+            EXPECT_FLOAT_EQ((*i).weight, (*ei).weight);
+    }
+}
+
+TEST(PairedInfo, StagedVsConcurrentBuffer) {
+    const unsigned NTHREADS = 4;
+
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/200);
+    debruijn_graph::RandomPairedPoints<debruijn_graph::Graph> points(graph, /*points_per_thread*/5000);
+    ASSERT_FALSE(points.empty());
+
+    TestIndex concurrent_pi(graph), staged_pi(graph);
+
+    ConcurrentPairedInfoBuffer<debruijn_graph::Graph> concurrent_buffer(graph);
+#   pragma omp parallel num_threads(NTHREADS)
+    points.Add(omp_get_thread_num(),
+               [&](EdgeId e1, EdgeId e2, RawPoint p) { concurrent_buffer.Add(e1, e2, p); });
+    concurrent_pi.MoveAssign(concurrent_buffer);
+
+    // Small cap, so that the threads spill their runs while the others are still adding points
+    StagedPairedInfoBuffer<debruijn_graph::Graph> staged_buffer(graph, NTHREADS, /*max_sealed*/1 << 10);
+#   pragma omp parallel num_threads(NTHREADS)
+    {
+        size_t thread = omp_get_thread_num();
+        points.Add(thread,
+                   [&](EdgeId e1, EdgeId e2, RawPoint p) { staged_buffer.Add(thread, e1, e2, p); });
+    }
+    staged_buffer.MoveInto(staged_pi, NTHREADS);
+
+    EXPECT_EQ(concurrent_pi.size(), staged_pi.size());
+    for (auto it = pair_begin(concurrent_pi); it != pair_end(concurrent_pi); ++it) {
+        auto info = *it, staged_info = staged_pi.Get(it.first(), it.second());
+        ASSERT_EQ(info.size(), staged_info.size());
+        for (auto i = info.begin(), si = staged_info.begin(); i != info.end(); ++i, ++si) {
+            EXPECT_EQ(*i, *si);
+            EXPECT_FLOAT_EQ((*i).weight, (*si).weight);
+        }
+    }
+}
+
+// Compares the finder with PathProcessor enumeration for every step-th edge, returns the numbers of
+// non-empty length sets and of interrupted enumerations
+static std::pair<size_t, size_t> CheckGraphDistanceLengths(const Graph &graph, size_t step) {
+    const size_t insert_size = 1500, read_length = 100, delta = 50;
+    GraphDistanceFinder finder(graph, insert_size, read_length, delta);
+    size_t upper_bound = omnigraph::PairInfoPathLengthUpperBound(graph.k(), insert_size, double(delta));
+
+    std::vector<EdgeId> edges;
+    for (auto it = graph.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+    size_t checked = 0, truncated = 0;
+    for (size_t i = 0; i < edges.size(); i += step) {
+        EdgeId e1 = edges[i];
+        std::map<EdgeId, std::vector<size_t>> second_edges;
+        for (EdgeId e2 : edges)
+            second_edges[e2];
+        finder.FillGraphDistancesLengths(e1, second_edges);
+
+        // Lengths should be the same as the ones of enumerated paths, including the interrupted enumerations
+        omnigraph::PathProcessor<Graph> processor(graph, graph.EdgeEnd(e1), upper_bound);
+        for (const auto &entry : second_edges) {
+            EdgeId e2 = entry.first;
+            size_t lower_bound = omnigraph::PairInfoPathLengthLowerBound(graph.k(), graph.length(e1), graph.length(e2),
+                                                                        int(insert_size - 2 * read_length), double(delta));
+            omnigraph::DistancesLengthsCallback<Graph> callback(graph);
+            truncated += processor.Process(graph.EdgeStart(e2), lower_bound, upper_bound, callback) & 1;
+
+            std::vector<size_t> expected = callback.distances();
+            for (size_t &length : expected)
+                length += graph.length(e1);
+            if (e1 == e2)
+                expected.insert(expected.begin(), 0);
+            EXPECT_EQ(expected, entry.second);
+            checked += !expected.empty();
+        }
+    }
+    return { checked, truncated };
+}
+
+TEST(PairedInfo, GraphDistanceLengths) {
+    Graph graph(55);
+    RandomGraph<Graph>(graph, /*max_size*/1000).Generate(/*iterations*/10000);
+    EXPECT_GT(CheckGraphDistanceLengths(graph, /*step*/10).first, 0u);
+}
+
+TEST(PairedInfo, GraphDistanceLengthsTangle) {
+    // Short edges between a few vertices give too many paths to enumerate within the limits
+    Graph graph(55);
+    std::vector<VertexId> vertices;
+    for (size_t i = 0; i < 4; ++i)
+        vertices.push_back(graph.AddVertex());
+    srand(42);
+    for (VertexId v1 : vertices) {
+        for (VertexId v2 : vertices)
+            graph.AddEdge(v1, v2, RandomSequence(graph.k() + 20 + rand() % 40));
+    }
+
+    auto counts = CheckGraphDistanceLengths(graph, /*step*/1);
+    EXPECT_GT(counts.first, 0u);
+    EXPECT_GT(counts.second, 0u);
+}
@@ -6,7 +6,10 @@
 
 
 #include "modules/path_extend/path_visualizer.hpp"
+#include "modules/path_extend/path_extender.hpp"
+#include "modules/path_extend/pe_resolver.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "assembly_graph/graph_support/detail_coverage.hpp"
 
 #include "graphio.hpp"
 
@@ -755,3 +758,137 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+namespace {
+
+// Follows the only outgoing edge until the loop is closed
+class UniqueOutgoingExtender : public PathExtender {
+public:
+    UniqueOutgoingExtender(const Graph &g, UsedUniqueStorage &used)
+            : PathExtender(g), used_(used) {}
+
+    bool MakeGrowStep(BidirectionalPath &path, PathContainer *) override {
+        if (path.Empty() || g_.OutgoingEdgeCount(g_.EdgeEnd(path.Back())) != 1)
+            return false;
+
+        EdgeId e = g_.GetUniqueOutgoingEdge(g_.EdgeEnd(path.Back()));
+        return path.FindFirst(e) == -1 && used_.TryUseEdge(path, e, Gap());
+    }
+
+private:
+    UsedUniqueStorage &used_;
+};
+
+template<class Factory>
+PathContainer GrowSeeds(const Graph &g, size_t nthreads, const Factory &factory) {
+    PathExtendResolver resolver(g);
+    auto seeds = resolver.MakeSimpleSeeds();
+    seeds.SortByLength();
+
+    ScaffoldingUniqueEdgeStorage unique;
+    GraphCoverageMap cover_map(g);
+    UsedUniqueStorage used(unique, g);
+    CompositeExtender extender(g, cover_map, used, factory(cover_map, used));
+    if (nthreads > 1)
+        extender.EnableParallelGrowth(factory, nthreads);
+
+    return resolver.ExtendSeeds(seeds, extender);
+}
+
+void ExpectSamePaths(const PathContainer &serial, const PathContainer &parallel) {
+    ASSERT_EQ(serial.size(), parallel.size());
+    for (size_t i = 0; i < serial.size(); ++i) {
+        EXPECT_TRUE(serial.Get(i) == parallel.Get(i));
+        EXPECT_TRUE(serial.GetConjugate(i) == parallel.GetConjugate(i));
+    }
+}
+
+}
+
+TEST( PathExtend, ParallelGrowth ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+
+    auto factory = [&g](GraphCoverageMap &, UsedUniqueStorage &used) {
+        return CompositeExtender::Extenders{ std::make_shared<UniqueOutgoingExtender>(g, used) };
+    };
+    ExpectSamePaths(GrowSeeds(g, 1, factory), GrowSeeds(g, 4, factory));
+}
+
+// Loop detection state of SimpleExtender is kept per thread and should not change the result
+TEST( PathExtend, ParallelGrowthSimpleExtender ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    omnigraph::FlankingCoverage<Graph> flanking_cov(g, 50);
+
+    auto factory = [&g, &flanking_cov](GraphCoverageMap &cover_map, UsedUniqueStorage &used) {
+        auto chooser = std::make_shared<TrivialExtensionChooser>(g);
+        return CompositeExtender::Extenders{
+            std::make_shared<SimpleExtender>(g, flanking_cov, cover_map, used, chooser,
+                                             /*investigate_short_loops*/false,
+                                             /*use_short_loop_cov_resolver*/false, /*is*/300) };
+    };
+    PathContainer serial = GrowSeeds(g, 1, factory);
+    EXPECT_LT(0, serial.size());
+    ExpectSamePaths(serial, GrowSeeds(g, 4, factory));
+}
+
+namespace {
+
+// Follows the outgoing edge of the same rank as the last edge has among the incoming ones.
+// Stops as soon as any of the outgoing edges is covered.
+class RankMatchingExtender : public PathExtender {
+public:
+    RankMatchingExtender(const Graph &g, const GraphCoverageMap &cover_map)
+            : PathExtender(g), cover_map_(cover_map) {}
+
+    bool MakeGrowStep(BidirectionalPath &path, PathContainer *) override {
+        if (path.Empty())
+            return false;
+
+        VertexId v = g_.EdgeEnd(path.Back());
+        std::vector<EdgeId> incoming(g_.IncomingEdges(v).begin(), g_.IncomingEdges(v).end());
+        std::vector<EdgeId> outgoing(g_.OutgoingEdges(v).begin(), g_.OutgoingEdges(v).end());
+        std::sort(incoming.begin(), incoming.end());
+        std::sort(outgoing.begin(), outgoing.end());
+        for (EdgeId e : outgoing) {
+            if (cover_map_.IsCovered(e))
+                return false;
+        }
+
+        size_t rank = std::find(incoming.begin(), incoming.end(), path.Back()) - incoming.begin();
+        if (rank >= outgoing.size())
+            return false;
+        path.PushBack(outgoing[rank]);
+        return true;
+    }
+
+private:
+    const GraphCoverageMap &cover_map_;
+};
+
+}
+
+// Seeds a and b meet at the branching vertex, a takes x and b only looks at x before taking y.
+// Serially b stops there, so the speculation of b only looking at the edge of a has to be rejected.
+TEST( PathExtend, ParallelGrowthCompetingSeeds ) {
+    Graph g(13);
+    VertexId s1 = g.AddVertex(), s2 = g.AddVertex(), v = g.AddVertex();
+    VertexId t1 = g.AddVertex(), t2 = g.AddVertex();
+    EdgeId a = g.AddEdge(s1, v, Sequence(std::string(100, 'A')));
+    EdgeId b = g.AddEdge(s2, v, Sequence(std::string(90, 'A')));
+    g.AddEdge(v, t1, Sequence(std::string(50, 'A')));
+    EdgeId y = g.AddEdge(v, t2, Sequence(std::string(40, 'A')));
+
+    auto factory = [&g](GraphCoverageMap &cover_map, UsedUniqueStorage &) {
+        return CompositeExtender::Extenders{ std::make_shared<RankMatchingExtender>(g, cover_map) };
+    };
+    PathContainer serial = GrowSeeds(g, 1, factory);
+    ASSERT_EQ(3, serial.size());
+    EXPECT_EQ(a, serial.Get(0).Front());
+    EXPECT_EQ(2, serial.Get(0).Size());
+    EXPECT_EQ(b, serial.Get(1).Front());
+    EXPECT_EQ(1, serial.Get(1).Size());
+    EXPECT_EQ(y, serial.Get(2).Back());
+    ExpectSamePaths(serial, GrowSeeds(g, 4, factory));
+}
@@ -12,6 +12,9 @@
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
 
+#include <functional>
+#include <random>
+
 namespace debruijn_graph {
 
 const size_t MAX_SEQ_LENGTH = 1000;
@@ -191,6 +194,41 @@ private:
     }
 };
 
+/**
+ * Reproducible stream of random points between the edges of a graph, as if added by a given thread.
+ * A few "repeat" edges receive half of the points, making the first edge of the pair highly contended.
+ */
+template<class Graph>
+class RandomPairedPoints {
+public:
+    typedef typename Graph::EdgeId EdgeId;
+    typedef std::function<void(EdgeId, EdgeId, omnigraph::de::RawPoint)> AddF;
+
+    RandomPairedPoints(const Graph &graph, size_t points_per_thread,
+                       size_t max_dist = 300, size_t hot_edges = 8)
+            : points_per_thread_(points_per_thread), max_dist_(max_dist) {
+        for (auto it = graph.ConstEdgeBegin(); !it.IsEnd(); ++it)
+            edges_.push_back(*it);
+        hot_edges_ = std::min(hot_edges, edges_.size());
+    }
+
+    void Add(size_t thread, const AddF &add) const {
+        using namespace omnigraph::de;
+        std::mt19937 rnd((unsigned)thread);
+        for (size_t i = 0; i < points_per_thread_; ++i) {
+            size_t e1 = rnd() % (i % 2 ? edges_.size() : hot_edges_);
+            size_t e2 = rnd() % edges_.size();
+            add(edges_[e1], edges_[e2], RawPoint(DEDistance(rnd() % max_dist_), DEWeight(1)));
+        }
+    }
+
+    bool empty() const { return edges_.empty(); }
+
+private:
+    std::vector<EdgeId> edges_;
+    size_t points_per_thread_, max_dist_, hot_edges_;
+};
+
 template<typename Graph>
 class RandomKmerMapper : public RandomConstructor<KmerMapper<Graph>> {
 
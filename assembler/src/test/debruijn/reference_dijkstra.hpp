@@ -0,0 +1,38 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <queue>
+#include <vector>
+
+namespace debruijn_graph {
+
+// Bounded Dijkstra allocating its hash maps and queue on every run, distances from the start are returned
+inline phmap::flat_hash_map<VertexId, size_t> ReferenceDistances(const Graph &g, VertexId start, size_t bound) {
+    typedef std::pair<size_t, VertexId> Item;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> queue;
+    phmap::flat_hash_map<VertexId, size_t> distances;
+    queue.emplace(0, start);
+    while (!queue.empty()) {
+        Item item = queue.top();
+        queue.pop();
+        if (!distances.emplace(item.second, item.first).second)
+            continue;
+        for (EdgeId e : g.OutgoingEdges(item.second)) {
+            size_t d = item.first + g.length(e);
+            if (d <= bound && !distances.count(g.EdgeEnd(e)))
+                queue.emplace(d, g.EdgeEnd(e));
+        }
+    }
+    return distances;
+}
+
+}
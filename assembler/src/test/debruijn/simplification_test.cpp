@@ -10,6 +10,7 @@
 #include "stages/simplification_pipeline/rna_simplification.hpp"
 
 #include "graphio.hpp"
+#include "random_graph.hpp"
 #include "tmp_folder_fixture.hpp"
 
 #include <gtest/gtest.h>
@@ -162,6 +163,42 @@ TEST_F( Simplification,  SimpleBulgeRemovalTest ) {
     EXPECT_EQ(4, g.size());
 }
 
+// Every bulge of the chain shares vertices with its neighbours, so the parallel remover has to glue them in several rounds
+TEST_F( Simplification,  ParallelBulgeRemoverChainOfBulges ) {
+    const size_t k = 55, bulge_cnt = 3000, length = 100;
+    Graph g(k);
+    std::string genome = RandomSequence(bulge_cnt * length + k).str();
+
+    VertexId prev = g.AddVertex();
+    for (size_t i = 0; i < bulge_cnt; ++i) {
+        VertexId next = g.AddVertex();
+        std::string nucls = genome.substr(i * length, length + k);
+        g.coverage_index().SetAvgCoverage(g.AddEdge(prev, next, Sequence(nucls)), 50.);
+
+        size_t pos = k + (length - k) / 2;
+        nucls[pos] = nucl((char)((dignucl(nucls[pos]) + 1) % 4));
+        g.coverage_index().SetAvgCoverage(g.AddEdge(prev, next, Sequence(nucls)), 5.);
+        prev = next;
+    }
+
+    omnigraph::ParallelBulgeRemover<Graph> remover(g, standard_simplif_relevant_info().chunk_cnt(),
+                                                   standard_br_config().buff_size,
+                                                   standard_br_config().buff_cov_diff,
+                                                   standard_br_config().buff_cov_rel_diff,
+                                                   debruijn::simplification::ParseBRConfig(g, standard_br_config()));
+    // Independent bulges of a round are glued concurrently, the remover tracks the changes meanwhile
+    int threads = omp_get_max_threads();
+    omp_set_num_threads(4);
+    EXPECT_EQ(bulge_cnt, remover.Run(/*force_primary_launch*/false, 0.));
+    omp_set_num_threads(threads);
+
+    EXPECT_EQ(4u, g.size());
+    ASSERT_EQ(2u, GraphComponent<Graph>::WholeGraph(g).e_size());
+    EdgeId e = *g.ConstEdgeBegin();
+    Sequence result = g.EdgeNucls(e);
+    EXPECT_TRUE(result == Sequence(genome) || !result == Sequence(genome));
+}
+
 TEST_F( Simplification,  TipobulgeTest ) {
     Graph g(55);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/tipobulge/tipobulge", g));
@@ -0,0 +1,122 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "hamcluster.hpp"
+#include "config_struct_hammer.hpp"
+#include "globals.hpp"
+
+#include "adt/concurrent_dsu.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/logger/log_writers.hpp"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+std::vector<uint32_t> *Globals::subKMerPositions = nullptr;
+
+// Only the options read by the clusterer are set
+struct ClusteringOptions {
+    unsigned nthreads;
+    unsigned blocksize_quadratic_threshold;
+};
+
+void load(hammer_config &cfg, const ClusteringOptions &options) {
+    cfg.general_max_nthreads = options.nthreads;
+    cfg.hamming_blocksize_quadratic_threshold = options.blocksize_quadratic_threshold;
+    cfg.hamming_in_memory = true;
+}
+
+static void InitSubKMerPositions(unsigned tau) {
+    delete Globals::subKMerPositions;
+    Globals::subKMerPositions = new std::vector<uint32_t>(tau + 2);
+    for (unsigned i = 0; i < tau + 1; ++i)
+        (*Globals::subKMerPositions)[i] = i * hammer::K / (tau + 1);
+    (*Globals::subKMerPositions)[tau + 1] = hammer::K;
+}
+
+// Random centers, each surrounded by several k-mers within the given distance from it
+static void GenerateKMers(KMerData &data, size_t centers, unsigned tau) {
+    std::mt19937_64 rnd(42);
+    std::unordered_set<std::string> seen;
+    auto add = [&](const std::string &s) {
+        if (seen.insert(s).second)
+            data.push_back(hammer::KMer(s.c_str()), KMerStat());
+    };
+
+    const char nucls[] = "ACGT";
+    for (size_t i = 0; i < centers; ++i) {
+        std::string center(hammer::K, 'A');
+        for (char &c : center)
+            c = nucls[rnd() % 4];
+        add(center);
+
+        for (size_t j = 0, mutants = rnd() % 8; j < mutants; ++j) {
+            std::string mutant = center;
+            for (unsigned m = 0, n = 1 + (unsigned)(rnd() % tau); m < n; ++m)
+                mutant[rnd() % hammer::K] = nucls[rnd() % 4];
+            add(mutant);
+        }
+    }
+}
+
+static std::vector<size_t> Classes(const KMerData &data, unsigned tau, bool in_memory, const std::string &prefix) {
+    cfg::get_writable().hamming_in_memory = in_memory;
+    dsu::ConcurrentDSU uf(data.size());
+    KMerHamClusterer(tau).cluster(prefix, data, uf);
+
+    std::vector<size_t> classes(data.size());
+    for (size_t i = 0; i < data.size(); ++i)
+        classes[i] = uf.find_set(i);
+    return classes;
+}
+
+TEST(KMerHamClusterer, InMemoryMatchesOnDisk) {
+    const unsigned TAU = 2;
+    // Small threshold, so that both passes get blocks
+    cfg::create_instance(ClusteringOptions{4, 3});
+    InitSubKMerPositions(TAU);
+
+    KMerData data;
+    GenerateKMers(data, 20000, TAU);
+
+    auto workdir = fs::tmp::make_temp_dir(".", "hamcluster");
+    std::vector<size_t> on_disk = Classes(data, TAU, false, workdir->dir() + "/kmers.hamcls");
+    std::vector<size_t> in_memory = Classes(data, TAU, true, workdir->dir() + "/kmers.hamcls");
+
+    // Class ids are the roots, so they differ. The partitions must be the same
+    std::unordered_map<size_t, size_t> disk_to_memory, memory_to_disk;
+    for (size_t i = 0; i < data.size(); ++i) {
+        ASSERT_EQ(disk_to_memory.emplace(on_disk[i], in_memory[i]).first->second, in_memory[i]) << "k-mer " << i;
+        ASSERT_EQ(memory_to_disk.emplace(in_memory[i], on_disk[i]).first->second, on_disk[i]) << "k-mer " << i;
+    }
+
+    INFO(data.size() << " k-mers, " << disk_to_memory.size() << " classes");
+    EXPECT_LT(disk_to_memory.size(), data.size() / 2);
+
+    delete Globals::subKMerPositions;
+    Globals::subKMerPositions = nullptr;
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    create_console_logger();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
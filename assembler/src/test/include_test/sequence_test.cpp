@@ -7,6 +7,8 @@
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
 #include <string>
+#include <sstream>
+#include <vector>
 #include <gtest/gtest.h>
 
 TEST( Sequence, Selector ) {
@@ -42,3 +44,80 @@ TEST( Sequence, ReverseComplement ) {
     Sequence s2 = Sequence("ACG");
     EXPECT_EQ("CGT", (!s2).str());
 }
+
+TEST( Sequence, ArenaMake ) {
+    NuclArena arena;
+    std::string s1 = "ACGTACGTACGTACGTACGTACGTACGTACGTAC", s2 = "TTGCA";
+    Sequence a = arena.Make(s1), b = arena.Make(s2), c = arena.Make(s2, true);
+    EXPECT_EQ(s1, a.str());
+    EXPECT_EQ(s2, b.str());
+    EXPECT_EQ("TGCAA", c.str());
+    EXPECT_EQ(Sequence(s1), a);
+    EXPECT_EQ("ACGTA", a.Subseq(4, 9).str());
+    EXPECT_EQ(1, arena.slabs());
+}
+
+TEST( Sequence, ArenaCopy ) {
+    NuclArena arena;
+    Sequence s("ACGTTGCAAACCGGTTTTGGCCAACCAGTAGTCAGTCGATGCTAGCCTA");
+    for (size_t from = 0; from < 20; ++from) {
+        for (size_t to = from; to <= s.size(); to += 7) {
+            Sequence sub = s.Subseq(from, to);
+            EXPECT_EQ(sub, arena.Copy(sub));
+            EXPECT_EQ(!sub, arena.Copy(!sub));
+        }
+    }
+}
+
+TEST( Sequence, ArenaReset ) {
+    NuclArena arena;
+    Sequence a = arena.Make(std::string(100, 'A'));
+    EXPECT_EQ(4 * sizeof(seq_element_type), arena.allocated());
+
+    arena.Reset();
+    EXPECT_EQ(0, arena.allocated());
+    Sequence b = arena.Copy(a);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ(2, arena.slabs());
+    EXPECT_EQ(4 * sizeof(seq_element_type), arena.allocated());
+}
+
+TEST( Sequence, ArenaLongFirst ) {
+    // Longer than the first slab, but still packed
+    NuclArena arena;
+    std::string s1(400 * 4 * sizeof(seq_element_type), 'A'), s2 = "TTGCA";
+    for (size_t i = 0; i < s1.size(); i += 3)
+        s1[i] = 'G';
+    Sequence a = arena.Make(s1), b = arena.Make(s2);
+    EXPECT_EQ(s1, a.str());
+    EXPECT_EQ(s2, b.str());
+    EXPECT_EQ(NuclArena::PackedSize(s1.size()), 400 * sizeof(seq_element_type));
+}
+
+TEST( Sequence, ArenaParallel ) {
+    NuclArena arena;
+    std::vector<std::string> strs(2000);
+    for (size_t i = 0; i < strs.size(); ++i) {
+        for (size_t j = 0; j < 1 + (i * 37) % 700; ++j)
+            strs[i] += nucl(char((i + j * j) % 4));
+    }
+
+    std::vector<Sequence> seqs(strs.size());
+#   pragma omp parallel for num_threads(4) schedule(dynamic, 1)
+    for (size_t i = 0; i < strs.size(); ++i)
+        seqs[i] = arena.Make(strs[i]);
+
+    for (size_t i = 0; i < strs.size(); ++i)
+        EXPECT_EQ(strs[i], seqs[i].str());
+}
+
+TEST( Sequence, BinWriteView ) {
+    Sequence s("ACGTTGCAAACCGGTTTTGGCCAACCAGTAGTCAGTCGATGCTAGCCTA");
+    for (Sequence sub : { s.Subseq(3, 40), !s.Subseq(1), s.Subseq(32) }) {
+        std::stringstream ss;
+        sub.BinWrite(ss);
+        Sequence read;
+        read.BinRead(ss);
+        EXPECT_EQ(sub, read);
+    }
+}
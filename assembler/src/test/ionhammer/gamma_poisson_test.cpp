@@ -0,0 +1,87 @@
+//***************************************************************************
+//* Copyright (c) 2021 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "gamma_poisson_model.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/logger/log_writers.hpp"
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace n_gamma_poisson_model;
+
+// Shapes, rates and counts seen by the EM estimator and the read correction
+static const std::vector<double> SHAPES = { 0.05, 0.3, 1, 7.5, 60, 1e3, 1e4 };
+static const std::vector<double> RATES = { 0.01, 0.1, 0.5, 1, 3, 8 };
+static const size_t MAX_COUNT = 400000;
+
+// All the small counts and a sparse sample of the large ones
+static std::vector<size_t> Counts(size_t from) {
+    std::vector<size_t> counts;
+    for (size_t count = from; count < from + 3000; ++count)
+        counts.push_back(count);
+    for (size_t count = from + 3000; count <= MAX_COUNT; count += 997)
+        counts.push_back(count);
+    counts.push_back(MAX_COUNT);
+    return counts;
+}
+
+// The table is accurate relative to the magnitude of the terms summed, not of the result which could be close to 0
+static double Tolerance(const GammaDistribution &prior, size_t count) {
+    const double a = prior.GetShape(), b = prior.GetRate(), c = (double)count;
+    double terms = std::abs(a * log(b)) + (a + c) * log(b + 1) + std::abs(boost::math::lgamma(a + c)) +
+                   std::abs(prior.LogGammaAtShape()) + boost::math::lgamma(c + 1);
+    return 1e-10 * std::max(1.0, terms);
+}
+
+TEST(GammaPoisson, BatchedPartialLogLikelihood) {
+    for (double shape : SHAPES) {
+        for (double rate : RATES) {
+            GammaDistribution prior(shape, rate);
+            PoissonGammaDistribution dist(prior);
+            for (size_t from : { 0, 5, 1000 }) {
+                std::vector<size_t> counts = Counts(from);
+                std::vector<double> batched(counts.size());
+                dist.PartialLogLikelihood(counts.data(), counts.size(), batched.data());
+                for (size_t i = 0; i < counts.size(); ++i)
+                    ASSERT_NEAR(dist.PartialLogLikelihood(counts[i]), batched[i], Tolerance(prior, counts[i]))
+                        << "shape " << shape << ", rate " << rate << ", count " << counts[i];
+            }
+        }
+    }
+}
+
+TEST(GammaPoisson, LogLikelihoodTable) {
+    for (double shape : SHAPES) {
+        for (double rate : RATES) {
+            GammaDistribution prior(shape, rate);
+            PoissonGammaDistribution dist(prior);
+            // Counts outside of the table should be evaluated directly
+            PoissonGammaLogLikelihoodTable table(prior, 3, MAX_COUNT / 2);
+            for (size_t count : Counts(0))
+                ASSERT_NEAR(dist.LogLikelihood(count), table(count), Tolerance(prior, count))
+                    << "shape " << shape << ", rate " << rate << ", count " << count;
+        }
+    }
+}
+
+void create_console_logger() {
+    using namespace logging;
+
+    logger *lg = create_logger("");
+    lg->add_writer(std::make_shared<console_writer>());
+    attach_logger(lg);
+}
+
+GTEST_API_ int main(int argc, char **argv) {
+    create_console_logger();
+
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}